@@ -0,0 +1,193 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Active-block tracking (-a). The board is divided into ACTIVE_BLOCK x
+ACTIVE_BLOCK blocks and each block remembers the last round in which any
+of its cells changed. A block whose 3x3 neighborhood of blocks did not
+change in the previous round cannot change in this one, and because the
+boards are double buffered the next board already holds the same cells
+(it was written two rounds ago, before they stopped changing). Such a
+block is skipped with no work at all. Every partition mode and kernel
+goes through here: a thread's rows, columns or tiles are cut along block
+lines and only the active pieces are played.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/*
+Returns the number of rounds whose counts are kept for the report
+    data-> The struct containing information for the game
+*/
+static int counted_rounds(struct gol_data *data) {
+
+    return (data->iters < ACTIVE_MAX_ROUNDS) ? data->iters
+        : ACTIVE_MAX_ROUNDS;
+}
+
+/*
+Sets up block tracking for the board; every block starts out changed so
+the first round plays the whole board
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int active_setup(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    int b, n;
+
+    shared->blocks_y = (data->rows + ACTIVE_BLOCK - 1) / ACTIVE_BLOCK;
+    shared->blocks_x = (data->cols + ACTIVE_BLOCK - 1) / ACTIVE_BLOCK;
+    n = shared->blocks_y * shared->blocks_x;
+
+    shared->changed = malloc(sizeof(int) * n);
+    shared->active_counts = calloc(counted_rounds(data) + 1, sizeof(int));
+    if (shared->changed == NULL || shared->active_counts == NULL) {
+        return 1;
+    }
+    for (b = 0; b < n; b++) {
+        shared->changed[b] = -1;
+    }
+    return 0;
+}
+
+/*
+Checks whether block (by, bx) or any of its eight neighbors (wrapping
+around the torus) changed in the previous round
+    shared -> the tracking state
+    by, bx -> the block's row and column in the block grid
+    round -> the round about to be played
+    returns: 1 if the block must be played, 0 if it can be skipped
+*/
+static int block_active(struct gol_shared *shared, int by, int bx,
+        int round) {
+    int dy, dx, y, x, stamp;
+
+    for (dy = -1; dy <= 1; dy++) {
+        y = (by + dy + shared->blocks_y) % shared->blocks_y;
+        for (dx = -1; dx <= 1; dx++) {
+            x = (bx + dx + shared->blocks_x) % shared->blocks_x;
+            stamp = __atomic_load_n(&shared->changed[y * shared->blocks_x + x],
+                    __ATOMIC_RELAXED);
+            // (>= since a neighbor may already be stamped this round)
+            if (stamp >= round - 1) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+Plays one round on rows r0..r1, cols c0..c1, skipping the parts of it
+that lie in inactive blocks and stamping the blocks that changed
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+    returns: the change in the number of live cells in the rectangle
+*/
+int active_region(struct gol_data *data, int r0, int r1, int c0, int c1) {
+    struct gol_shared *shared = data->shared;
+    int by, bx, br0, br1, bc0, bc1, round, live, counted;
+
+    if (r0 > r1 || c0 > c1) {
+        return 0;
+    }
+    round = shared->round;
+    live = 0;
+    counted = 0;
+
+    for (by = r0 / ACTIVE_BLOCK; by <= r1 / ACTIVE_BLOCK; by++) {
+        br0 = by * ACTIVE_BLOCK;
+        br1 = br0 + ACTIVE_BLOCK - 1;
+        br0 = (br0 < r0) ? r0 : br0;
+        br1 = (br1 > r1) ? r1 : br1;
+
+        for (bx = c0 / ACTIVE_BLOCK; bx <= c1 / ACTIVE_BLOCK; bx++) {
+            if (!block_active(shared, by, bx, round)) {
+                continue;
+            }
+            bc0 = bx * ACTIVE_BLOCK;
+            bc1 = bc0 + ACTIVE_BLOCK - 1;
+            bc0 = (bc0 < c0) ? c0 : bc0;
+            bc1 = (bc1 > c1) ? c1 : bc1;
+
+            live += play_region(data, br0, br1, bc0, bc1);
+            if (region_changed(data, br0, br1, bc0, bc1)) {
+                __atomic_store_n(&shared->changed[by * shared->blocks_x + bx],
+                        round, __ATOMIC_RELAXED);
+            }
+
+            // a block split between threads is counted by the thread
+            // that has its top left cell
+            if (br0 % ACTIVE_BLOCK == 0 && bc0 % ACTIVE_BLOCK == 0) {
+                counted++;
+            }
+        }
+    }
+
+    // (no counts for libgol, which has no report and no last round)
+    if (counted > 0 && shared->active_counts != NULL
+            && round <= counted_rounds(data)) {
+        __atomic_add_fetch(&shared->active_counts[round], counted,
+                __ATOMIC_RELAXED);
+    }
+    return live;
+}
+
+/*
+Marks every block as changed in the last round, so the next round plays
+the whole board (after -r skips ahead, the stamps are from rounds that
+are no longer the last ones)
+    data-> The struct containing information for the game
+*/
+void active_reset(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    int b;
+
+    for (b = 0; b < shared->blocks_y * shared->blocks_x; b++) {
+        shared->changed[b] = shared->round - 1;
+    }
+}
+
+/*
+Prints how many blocks were active per round (all of them with
+print_config, otherwise a summary), over the first ACTIVE_MAX_ROUNDS
+    data-> The struct containing information for the game
+*/
+void active_report(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    int i, n, min, max, rounds;
+    double sum;
+
+    n = shared->blocks_y * shared->blocks_x;
+    rounds = counted_rounds(data);
+    if (data->print_config == 1) {
+        for (i = 0; i < rounds; i++) {
+            printf("round %d: %d/%d blocks active\n", i,
+                    shared->active_counts[i], n);
+        }
+    }
+
+    sum = 0;
+    min = n;
+    max = 0;
+    for (i = 0; i < rounds; i++) {
+        sum += shared->active_counts[i];
+        min = (shared->active_counts[i] < min) ? shared->active_counts[i] : min;
+        max = (shared->active_counts[i] > max) ? shared->active_counts[i] : max;
+    }
+    if (rounds > 0) {
+        printf("Active blocks (%dx%d cells): %.1f avg, %d min, %d max "
+                "of %d per round\n", ACTIVE_BLOCK, ACTIVE_BLOCK,
+                sum / rounds, min, max, n);
+    }
+    if (rounds < data->iters) {
+        printf("(counted over the first %d of %d rounds)\n", rounds,
+                data->iters);
+    }
+}
@@ -0,0 +1,188 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Load balancing between generations (-B). partition() gives every thread
+the same number of rows, columns or tiles, which is only fair while every
+cell costs the same and every CPU runs at the same speed. With -a whole
+blocks are skipped, and on a shared host a thread can lose its CPU, so
+with -B each thread times its play_round and the thread running
+end_round moves the boundaries between the shares (the cuts) so that
+every thread gets the same measured cost. A thread's time is spread
+evenly over its own units, and the new cuts are the points where the
+running total reaches 1/threads, 2/threads, ... of the whole.
+
+To keep it from chasing noise or oscillating, the times are summed over
+BALANCE_PERIOD rounds, nothing moves while the slowest thread is within
+BALANCE_SLACK of the average, and each cut moves only halfway to its
+target. Every thread keeps at least one unit, so it keeps being measured.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/* rounds of compute time summed before the cuts may move */
+#define BALANCE_PERIOD (8)
+
+/* how far the slowest thread may be above the average before the cuts
+ * move (0.05: 5%) */
+#define BALANCE_SLACK (0.05)
+
+/*
+Allocates the cuts, starting from partition()'s even split
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int balance_setup(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    int t, start, end;
+
+    shared->cuts = malloc(sizeof(int) * (data->threads + 1));
+    shared->bal_next = malloc(sizeof(int) * (data->threads + 1));
+    shared->bal_ns = calloc(data->threads, sizeof(long));
+    if (shared->cuts == NULL || shared->bal_next == NULL
+            || shared->bal_ns == NULL) {
+        return 1;
+    }
+    for (t = 0; t < data->threads; t++) {
+        split_range(part_units(data), data->threads, t, &start, &end);
+        shared->cuts[t] = start;
+    }
+    shared->cuts[data->threads] = part_units(data);
+    shared->bal_rounds = 0;
+    shared->rebalances = 0;
+    return 0;
+}
+
+/*
+Prints every thread's share given by the cuts, the way play_gol prints
+its own share with print_config
+    data-> The struct containing information for the game
+*/
+static void print_cuts(struct gol_data *data) {
+    int *cuts = data->shared->cuts;
+    int t, start, end;
+    const char *what;
+
+    what = (data->part_mode == 0) ? "rows"
+        : (data->part_mode == 1) ? "cols" : "tiles";
+    for (t = 0; t < data->threads; t++) {
+        share_bounds(data, cuts[t], cuts[t + 1] - 1, &start, &end);
+        printf("ntid %d:  %s: %d:%d (%d)\n", t, what, start, end,
+                end - start + 1);
+    }
+}
+
+/*
+Runs in end_round: adds this round's compute times to the window and,
+once the window is full and the threads were uneven, moves the cuts
+halfway towards an even split of the measured cost
+    data-> The struct containing information for the game
+*/
+void balance_round(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    int n = data->threads;
+    int *cuts = shared->cuts;
+    int *next = shared->bal_next;
+    long *ns = shared->bal_ns;
+    double total, max, goal, before, pos;
+    int t, k, units, target, step, min_share;
+
+    for (t = 0; t < n; t++) {
+        ns[t] += shared->counts[t].ns;
+    }
+    if (++shared->bal_rounds < BALANCE_PERIOD) {
+        return;
+    }
+
+    total = 0;
+    max = 0;
+    for (t = 0; t < n; t++) {
+        total += ns[t];
+        max = (ns[t] > max) ? ns[t] : max;
+    }
+    if (total == 0 || max * n <= total * (1 + BALANCE_SLACK)) {
+        // even enough: start a new window with the same cuts
+        memset(ns, 0, sizeof(long) * n);
+        shared->bal_rounds = 0;
+        return;
+    }
+
+    // walk the threads' shares, cost spread evenly over each one, and
+    // put cut k where the cost so far reaches k / n of the total
+    units = cuts[n];
+    next[0] = 0;
+    next[n] = units;
+    t = 0;
+    before = 0; // cost of the shares before thread t's
+    for (k = 1; k < n; k++) {
+        goal = total * k / n;
+        while (t < n - 1 && before + ns[t] < goal) {
+            before += ns[t];
+            t++;
+        }
+        pos = cuts[t];
+        if (ns[t] > 0) {
+            pos += (goal - before) / ns[t] * (cuts[t + 1] - cuts[t]);
+        }
+        target = (int)(pos + 0.5);
+        if (target > cuts[t + 1]) {
+            target = cuts[t + 1];
+        }
+        // only halfway there (but always some way), so it settles
+        step = (target - cuts[k]) / 2;
+        if (step == 0) {
+            step = target - cuts[k];
+        }
+        next[k] = cuts[k] + step;
+    }
+
+    // in order, with at least one unit per thread when there are enough
+    min_share = (units >= n);
+    for (k = 1; k < n; k++) {
+        if (next[k] < next[k - 1] + min_share) {
+            next[k] = next[k - 1] + min_share;
+        }
+    }
+    for (k = n - 1; k > 0; k--) {
+        if (next[k] > next[k + 1] - min_share) {
+            next[k] = next[k + 1] - min_share;
+        }
+    }
+
+    memcpy(cuts, next, sizeof(int) * (n + 1));
+    memset(ns, 0, sizeof(long) * n);
+    shared->bal_rounds = 0;
+    shared->rebalances++;
+    if (data->print_config == 1) {
+        printf("Round %d: rebalanced (slowest thread %.0f%% above the "
+                "average)\n", shared->round, 100 * (max * n / total - 1));
+        print_cuts(data);
+    }
+}
+
+/*
+Sets this thread's share (start and end) from the cuts, after the
+end-of-round barrier
+    data-> The struct containing information for the game
+*/
+void balance_apply(struct gol_data *data) {
+    int *cuts = data->shared->cuts;
+
+    share_bounds(data, cuts[data->ntids], cuts[data->ntids + 1] - 1,
+            &data->start, &data->end);
+}
+
+/*
+Prints how often the cuts moved and the final split
+    data-> The struct containing information for the game
+*/
+void balance_report(struct gol_data *data) {
+
+    printf("Rebalanced %d times; final split:\n", data->shared->rebalances);
+    print_cuts(data);
+}
@@ -0,0 +1,93 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Sense-reversing spin barrier with a futex fallback (see barrier.h).
+Each thread keeps a private sense that it flips on every wait; the last
+thread to arrive resets the count, runs the serial function (if any) and
+then publishes its sense, which releases everyone else.
+*/
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "barrier.h"
+
+/* hint to the CPU that we are busy-waiting */
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/*
+Initializes a barrier for threads threads
+    b -> the barrier
+    threads -> number of threads that will call spin_barrier_wait
+*/
+void spin_barrier_init(struct spin_barrier *b, int threads) {
+    long cpus;
+
+    b->threads = threads;
+    b->count = threads;
+    b->sense = 0;
+    b->sleepers = 0;
+
+    // with more threads than CPUs a spinning waiter only delays the
+    // thread it is waiting for, so go straight to the futex
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    b->spins = (cpus > 0 && threads > cpus) ? 0 : BARRIER_SPINS;
+}
+
+/*
+Waits until all b->threads threads have called spin_barrier_wait. The
+last one to arrive runs serial(arg) while the others are still waiting.
+    b -> the barrier
+    local_sense -> the calling thread's sense (starts at 0, never shared)
+    serial -> function for the last thread to run, or NULL
+    arg -> passed to serial
+    returns: 1 in the thread that ran serial, 0 in the others
+*/
+int spin_barrier_wait(struct spin_barrier *b, int *local_sense,
+        barrier_serial_fn serial, void *arg) {
+    int sense, spins;
+
+    sense = !*local_sense;
+    *local_sense = sense;
+
+    if (__atomic_sub_fetch(&b->count, 1, __ATOMIC_ACQ_REL) == 0) {
+        // last one in: everybody else is waiting on sense
+        b->count = b->threads;
+        if (serial != NULL) {
+            serial(arg);
+        }
+        __atomic_store_n(&b->sense, sense, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&b->sleepers, __ATOMIC_SEQ_CST) > 0) {
+            syscall(SYS_futex, &b->sense, FUTEX_WAKE_PRIVATE, INT_MAX,
+                    NULL, NULL, 0);
+        }
+        return 1;
+    }
+
+    spins = 0;
+    while (__atomic_load_n(&b->sense, __ATOMIC_ACQUIRE) != sense) {
+        if (spins < b->spins) {
+            spins++;
+            cpu_relax();
+            continue;
+        }
+        // sleep until sense changes; the futex call returns at once if
+        // it already has, so a wakeup between the check and the call
+        // cannot be lost
+        __atomic_add_fetch(&b->sleepers, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&b->sense, __ATOMIC_SEQ_CST) != sense) {
+            syscall(SYS_futex, &b->sense, FUTEX_WAIT_PRIVATE, !sense,
+                    NULL, NULL, 0);
+        }
+        __atomic_sub_fetch(&b->sleepers, 1, __ATOMIC_SEQ_CST);
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+A reusable sense-reversing barrier for the per-generation sync between
+worker threads. Waiters spin on a shared sense flag for a short while and
+then sleep on it with a futex, so a barrier costs a few cache misses when
+every thread has its own core and no wasted CPU when they do not. This
+header has no ParaVis dependency so the benchmark can use it on its own.
+*/
+#ifndef __BARRIER_H__
+#define __BARRIER_H__
+
+/* size of a cache line, for aligning per-thread data */
+#define CACHE_LINE (64)
+
+/* spins before a waiter falls back to sleeping on the futex */
+#define BARRIER_SPINS (20000)
+
+struct spin_barrier {
+    int threads; // number of threads that meet at the barrier
+    int spins; // spins before sleeping (0 when threads > CPUs)
+    // the counters each get their own cache line; every arrival
+    // writes count but waiters only read sense
+    int count __attribute__((aligned(CACHE_LINE))); // arrivals left
+    int sense __attribute__((aligned(CACHE_LINE))); // flips each phase
+    int sleepers; // waiters sleeping on the futex
+};
+
+/* function the last thread to arrive runs before releasing the others */
+typedef void (*barrier_serial_fn)(void *arg);
+
+void spin_barrier_init(struct spin_barrier *b, int threads);
+int spin_barrier_wait(struct spin_barrier *b, int *local_sense,
+        barrier_serial_fn serial, void *arg);
+
+#endif  /* __BARRIER_H__ */
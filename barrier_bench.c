@@ -0,0 +1,159 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Measures what the per-generation synchronization costs: threads run a
+number of "generations" of (optional) busy work followed by
+  - two pthread_barrier_wait calls (how play_gol used to sync),
+  - one pthread_barrier_wait call,
+  - one spin_barrier_wait call (how play_gol syncs now),
+and the time per generation is reported for each.
+
+ * To run:
+ * ./barrier_bench [threads] [generations] [work_ns]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include "barrier.h"
+
+#define SYNC_PTHREAD_TWICE (0)
+#define SYNC_PTHREAD_ONCE  (1)
+#define SYNC_SPIN          (2)
+
+static const char *sync_names[] = {
+    "pthread_barrier x2", "pthread_barrier x1", "spin_barrier x1"
+};
+
+/* state shared by the benchmark threads of one run */
+struct bench_shared {
+    int sync; // one of the SYNC_* values
+    int gens; // generations to run
+    long work_ns; // busy work per thread per generation
+    pthread_barrier_t pbarrier;
+    struct spin_barrier sbarrier;
+};
+
+/* per-thread arguments, one cache line each */
+struct bench_thread {
+    struct bench_shared *shared;
+    int sense;
+} __attribute__((aligned(CACHE_LINE)));
+
+/* returns a monotonic time stamp in nanoseconds */
+static long long now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* spins for about ns nanoseconds (stands in for play_round) */
+static void busy_work(long ns) {
+    long long until;
+
+    if (ns <= 0) {
+        return;
+    }
+    until = now_ns() + ns;
+    while (now_ns() < until) {
+    }
+}
+
+/* thread body: gens rounds of work + the selected synchronization */
+static void *bench_thread(void *arg) {
+    struct bench_thread *t = (struct bench_thread *)arg;
+    struct bench_shared *s = t->shared;
+    int g;
+
+    for (g = 0; g < s->gens; g++) {
+        busy_work(s->work_ns);
+        if (s->sync == SYNC_PTHREAD_TWICE) {
+            pthread_barrier_wait(&s->pbarrier);
+            pthread_barrier_wait(&s->pbarrier);
+        } else if (s->sync == SYNC_PTHREAD_ONCE) {
+            pthread_barrier_wait(&s->pbarrier);
+        } else {
+            spin_barrier_wait(&s->sbarrier, &t->sense, NULL, NULL);
+        }
+    }
+    return NULL;
+}
+
+/*
+Runs one configuration and returns its time per generation
+    sync -> which synchronization to use
+    threads, gens, work_ns -> the run configuration
+    returns: nanoseconds per generation
+*/
+static double run(int sync, int threads, int gens, long work_ns) {
+    struct bench_shared shared;
+    struct bench_thread *targs;
+    pthread_t *tids;
+    long long t0, t1;
+    int i;
+
+    shared.sync = sync;
+    shared.gens = gens;
+    shared.work_ns = work_ns;
+    pthread_barrier_init(&shared.pbarrier, NULL, threads);
+    spin_barrier_init(&shared.sbarrier, threads);
+
+    tids = malloc(sizeof(pthread_t) * threads);
+    targs = aligned_alloc(CACHE_LINE, sizeof(struct bench_thread) * threads);
+    if (tids == NULL || targs == NULL) {
+        perror("malloc");
+        exit(1);
+    }
+
+    t0 = now_ns();
+    for (i = 0; i < threads; i++) {
+        targs[i].shared = &shared;
+        targs[i].sense = 0;
+        if (pthread_create(&tids[i], NULL, bench_thread, &targs[i])) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    t1 = now_ns();
+
+    pthread_barrier_destroy(&shared.pbarrier);
+    free(tids);
+    free(targs);
+    return (double)(t1 - t0) / gens;
+}
+
+int main(int argc, char **argv) {
+    int threads, gens, sync;
+    long work_ns;
+    double ns, base;
+
+    threads = (argc > 1) ? atoi(argv[1]) : 4;
+    gens = (argc > 2) ? atoi(argv[2]) : 100000;
+    work_ns = (argc > 3) ? atol(argv[3]) : 0;
+    if (threads < 1 || gens < 1) {
+        printf("usage: %s [threads] [generations] [work_ns]\n", argv[0]);
+        exit(1);
+    }
+
+    printf("threads: %d  generations: %d  work per generation: %ld ns\n",
+            threads, gens, work_ns);
+    printf("%-20s %14s %14s\n", "sync", "ns/generation", "sync ns/gen");
+
+    // warm up (thread creation, page faults) before timing anything
+    run(SYNC_SPIN, threads, gens / 10 + 1, work_ns);
+
+    base = work_ns;
+    for (sync = SYNC_PTHREAD_TWICE; sync <= SYNC_SPIN; sync++) {
+        ns = run(sync, threads, gens, work_ns);
+        printf("%-20s %14.1f %14.1f\n", sync_names[sync], ns, ns - base);
+    }
+    return 0;
+}
@@ -0,0 +1,340 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Per-generation census (-c file): population, births, deaths and the
+bounding box of the live cells after every generation. After playing its
+share of a round each thread compares its part of the current and next
+boards and leaves the counts in its own cache line of shared->counts;
+end_round adds the threads' counts up (no locks: every other thread is
+waiting at the barrier) and appends one record to the file. A file
+ending in .csv gets one CSV line per generation, anything else gets
+CENSUS_MAGIC, the board size and fixed-size binary records. Without -c
+none of this runs.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "gol.h"
+
+/* first bytes of a binary census file, followed by rows and cols as
+ * int32_t and then one census_record per generation */
+#define CENSUS_MAGIC "GOLCENS1"
+
+/* one generation of a binary census file (host byte order; the box is
+ * -1 when there are no live cells) */
+struct census_record {
+    int64_t gen; // generation (0: the input board)
+    int64_t live; // population
+    int64_t births, deaths; // cells that came alive / died this round
+    int32_t min_r, max_r; // first and last row with a live cell
+    int32_t min_c, max_c; // first and last column with a live cell
+};
+
+/*
+Empties one thread's census counts (all but the live delta, which
+play_round sets)
+    c -> the counts
+*/
+static void counts_clear(struct census_counts *c) {
+
+    c->births = 0;
+    c->deaths = 0;
+    c->min_r = INT_MAX;
+    c->max_r = -1;
+    c->min_c = INT_MAX;
+    c->max_c = -1;
+}
+
+/*
+Grows a bounding box to take in row i, columns lo..hi
+    c -> the counts holding the box
+    i -> the row
+    lo, hi -> the first and last live column on it
+*/
+static void box_add(struct census_counts *c, int i, int lo, int hi) {
+
+    c->min_r = (i < c->min_r) ? i : c->min_r;
+    c->max_r = (i > c->max_r) ? i : c->max_r;
+    c->min_c = (lo < c->min_c) ? lo : c->min_c;
+    c->max_c = (hi > c->max_c) ? hi : c->max_c;
+}
+
+/*
+Census of rows r0..r1, cols c0..c1 of two int boards (scalar or padded)
+    data-> The struct containing information for the game
+    old, new -> the boards before and after the round
+    r0, r1, c0, c1 -> the rectangle
+    c -> where the counts are added
+*/
+static void census_ints(struct gol_data *data, int *old, int *new,
+        int r0, int r1, int c0, int c1, struct census_counts *c) {
+    const int *o, *n;
+    int i, j, lo, hi, births, deaths, any;
+
+    for (i = r0; i <= r1; i++) {
+        o = board_row(data, old, i);
+        n = board_row(data, new, i);
+        births = 0;
+        deaths = 0;
+        any = 0;
+        // branch free so it vectorizes; the box only needs the row ends
+        for (j = c0; j <= c1; j++) {
+            births += n[j] & ~o[j];
+            deaths += o[j] & ~n[j];
+            any |= n[j];
+        }
+        c->births += births;
+        c->deaths += deaths;
+        if (any) {
+            for (lo = c0; !n[lo]; lo++) {
+            }
+            for (hi = c1; !n[hi]; hi--) {
+            }
+            box_add(c, i, lo, hi);
+        }
+    }
+}
+
+/*
+Census of rows r0..r1, cols c0..c1 (word aligned, as for play_region) of
+two packed boards, a word at a time
+    data-> The struct containing information for the game
+    old, new -> the boards before and after the round
+    r0, r1, c0, c1 -> the rectangle
+    c -> where the counts are added
+*/
+static void census_packed(struct gol_data *data, const uint64_t *old,
+        const uint64_t *new, int r0, int r1, int c0, int c1,
+        struct census_counts *c) {
+    const uint64_t *o, *n;
+    int i, w, lo, hi;
+
+    for (i = r0; i <= r1; i++) {
+        o = old + (size_t)i * data->words;
+        n = new + (size_t)i * data->words;
+        lo = -1;
+        hi = -1;
+        for (w = c0 / 64; w <= c1 / 64; w++) {
+            c->births += __builtin_popcountll(n[w] & ~o[w]);
+            c->deaths += __builtin_popcountll(o[w] & ~n[w]);
+            if (n[w] != 0) {
+                if (lo < 0) {
+                    lo = w * 64 + __builtin_ctzll(n[w]);
+                }
+                hi = w * 64 + 63 - __builtin_clzll(n[w]);
+            }
+        }
+        if (lo >= 0) {
+            box_add(c, i, lo, hi);
+        }
+    }
+}
+
+/*
+Census of rows r0..r1 of the sparse engine: walks the old cells of those
+rows and the new ones side by side (both are in key order)
+    data-> The struct containing information for the game
+    old -> the current live cells (all rows)
+    new -> the next generation's live cells, rows r0..r1 only
+    r0, r1 -> the rows
+    c -> where the counts are added
+*/
+static void census_sparse(struct gol_data *data, const struct sparse_set *old,
+        const struct sparse_set *new, int r0, int r1,
+        struct census_counts *c) {
+    uint64_t cols;
+    long x, xe, y;
+    int j;
+
+    cols = data->cols;
+    x = sparse_lower_bound(old, (uint64_t)r0 * cols);
+    xe = sparse_lower_bound(old, (uint64_t)(r1 + 1) * cols);
+    y = 0;
+    while (x < xe || y < new->n) {
+        if (y == new->n || (x < xe && old->cells[x] < new->cells[y])) {
+            c->deaths++;
+            x++;
+            continue;
+        }
+        if (x == xe || new->cells[y] < old->cells[x]) {
+            c->births++;
+        } else {
+            x++;
+        }
+        j = (int)(new->cells[y] % cols);
+        box_add(c, (int)(new->cells[y] / cols), j, j);
+        y++;
+    }
+}
+
+/*
+Adds the census of rows r0..r1, cols c0..c1 for the round just played
+    data-> The struct containing information for the game
+    r0, r1, c0, c1 -> the rectangle
+    c -> where the counts are added
+*/
+static void census_region(struct gol_data *data, int r0, int r1, int c0,
+        int c1, struct census_counts *c) {
+
+    if (r0 > r1 || c0 > c1) {
+        return;
+    }
+    if (data->kernel == KERNEL_PACKED) {
+        census_packed(data, data->packed_board, data->packed_next,
+                r0, r1, c0, c1, c);
+    } else if (data->kernel == KERNEL_SPARSE) {
+        census_sparse(data, data->sparse_board, sparse_result(data),
+                r0, r1, c);
+    } else {
+        census_ints(data, data->gol_board, data->next_board,
+                r0, r1, c0, c1, c);
+    }
+}
+
+/*
+Takes the census of this thread's share of the board (rows, columns or
+tiles) for the round it just played (called by play_round with -c)
+    data-> The struct containing information for the game
+*/
+void census_share(struct gol_data *data) {
+    struct census_counts *c = &data->shared->counts[data->ntids];
+    int k, r0, r1, c0, c1;
+
+    counts_clear(c);
+    if (data->part_mode == 0) {
+        census_region(data, data->start, data->end, 0, data->cols - 1, c);
+    }
+    if (data->part_mode == 1) {
+        census_region(data, 0, data->rows - 1, data->start, data->end, c);
+    }
+    if (data->part_mode == 2) {
+        for (k = data->start; k <= data->end; k++) {
+            tile_bounds(data, k, &r0, &r1, &c0, &c1);
+            census_region(data, r0, r1, c0, c1, c);
+        }
+    }
+}
+
+/*
+Writes one generation's census to the file
+    shared -> the state holding the file
+    gen -> the generation
+    live -> the population
+    c -> births, deaths and box
+    returns: 0 on success, 1 on a write error
+*/
+static int census_put(struct gol_shared *shared, long gen, long live,
+        const struct census_counts *c) {
+    struct census_record rec;
+
+    rec.gen = gen;
+    rec.live = live;
+    rec.births = c->births;
+    rec.deaths = c->deaths;
+    rec.min_r = (c->max_r < 0) ? -1 : c->min_r;
+    rec.max_r = c->max_r;
+    rec.min_c = (c->max_c < 0) ? -1 : c->min_c;
+    rec.max_c = c->max_c;
+
+    if (shared->census_csv) {
+        return fprintf(shared->census, "%lld,%lld,%lld,%lld,%d,%d,%d,%d\n",
+                (long long)rec.gen, (long long)rec.live,
+                (long long)rec.births, (long long)rec.deaths,
+                rec.min_r, rec.max_r, rec.min_c, rec.max_c) < 0;
+    }
+    return fwrite(&rec, sizeof(rec), 1, shared->census) != 1;
+}
+
+/*
+Opens the census file, writes its header and the census of the starting
+board (generation 0)
+    data-> The struct containing information for the game
+    path -> the file (.csv: CSV, otherwise binary)
+    live -> the starting population
+    returns: 0 on success, 1 on error
+*/
+int census_open(struct gol_data *data, const char *path, long live) {
+    struct gol_shared *shared = data->shared;
+    struct census_counts c;
+    size_t len;
+    int32_t size[2];
+
+    len = strlen(path);
+    shared->census_csv = (len >= 4 && strcmp(path + len - 4, ".csv") == 0);
+    shared->census = fopen(path, shared->census_csv ? "w" : "wb");
+    if (shared->census == NULL) {
+        return 1;
+    }
+
+    if (shared->census_csv) {
+        fprintf(shared->census, "generation,population,births,deaths,"
+                "min_row,max_row,min_col,max_col\n");
+    } else {
+        size[0] = data->rows;
+        size[1] = data->cols;
+        fwrite(CENSUS_MAGIC, 1, strlen(CENSUS_MAGIC), shared->census);
+        fwrite(size, sizeof(size), 1, shared->census);
+    }
+
+    // the starting board against itself: no births or deaths
+    counts_clear(&c);
+    if (data->kernel == KERNEL_PACKED) {
+        census_packed(data, data->packed_board, data->packed_board,
+                0, data->rows - 1, 0, data->cols - 1, &c);
+    } else if (data->kernel == KERNEL_SPARSE) {
+        census_sparse(data, data->sparse_board, data->sparse_board,
+                0, data->rows - 1, &c);
+    } else {
+        census_ints(data, data->gol_board, data->gol_board,
+                0, data->rows - 1, 0, data->cols - 1, &c);
+    }
+    return census_put(shared, 0, live, &c);
+}
+
+/*
+Adds up the threads' census counts for the round just played and writes
+them (called by end_round, while the other threads wait)
+    data-> The struct containing information for the game
+    live -> the population after the round
+*/
+void census_round(struct gol_data *data, long live) {
+    struct gol_shared *shared = data->shared;
+    struct census_counts sum, *c;
+    int t;
+
+    counts_clear(&sum);
+    for (t = 0; t < data->threads; t++) {
+        c = &shared->counts[t];
+        sum.births += c->births;
+        sum.deaths += c->deaths;
+        if (c->max_r >= 0) {
+            box_add(&sum, c->min_r, c->min_c, c->max_c);
+            box_add(&sum, c->max_r, c->min_c, c->max_c);
+        }
+    }
+    if (census_put(shared, shared->round, live, &sum) != 0) {
+        perror("census");
+        exit(1);
+    }
+}
+
+/*
+Closes the census file
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 if the file could not be written
+*/
+int census_close(struct gol_data *data) {
+    int ret;
+
+    if (data->shared->census == NULL) {
+        return 0;
+    }
+    ret = fclose(data->shared->census) != 0;
+    data->shared->census = NULL;
+    return ret;
+}
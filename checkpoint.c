@@ -0,0 +1,634 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Checkpoints (-s N:file): the board is saved every N generations in a
+compact binary file that gol reads back like any other input, so a long
+run can be stopped and restarted where it was. The file is a
+checkpoint_header followed by the board: for the dense kernels one bit
+per cell, rows of (cols + 63) / 64 uint64_t words (bit j % 64 of word
+j / 64 is column j, the packed board's own layout), and for the sparse
+engine the sorted keys (row * cols + col) of the live cells.
+
+Saving never makes the workers wait for the disk. In a round that ends
+on a checkpoint generation each thread packs its own share of the new
+board into the checkpoint buffer right after playing it (as the census
+and -r do), and end_round hands the full buffer to a writer thread. The
+writer writes it to file.tmp and renames it over the file, so the file
+always holds a whole checkpoint. If the writer is still busy when the
+next one is due, that checkpoint waits for the first round after the
+writer is done. When the run ends the last board is saved as well.
+
+A checkpoint is loaded by mapping it (load.c): the board is copied
+straight from the mapped file (a memcpy for the packed kernel), and
+the run continues from its generation up to the generation the old run
+was playing to (or -i more).
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "gol.h"
+
+/* how the board is stored after the header */
+#define CKPT_BITS (0) // one bit per cell, row after row
+#define CKPT_KEYS (1) // sorted keys of the live cells (sparse engine)
+
+/* the first CHECKPOINT_HEAD bytes of a checkpoint (host byte order) */
+struct checkpoint_header {
+    char magic[8]; // CHECKPOINT_MAGIC
+    int32_t rows, cols; // board size
+    int64_t generation; // generation of the board
+    int64_t target; // generation the run was playing to
+    int64_t live; // live cells
+    int32_t encoding; // CKPT_BITS or CKPT_KEYS
+    int32_t words; // CKPT_BITS: uint64_t words per row
+    char rule[16]; // the rulestring ("B3/S23"), or, for rules too long
+                   // for it, '\0' and the rule's mask as a uint32_t at
+                   // rule + 4 (see rule.c)
+};
+
+/* The checkpoint writer and the buffer the threads pack into */
+struct checkpoint {
+    const char *path; // the checkpoint file
+    char *tmp; // path.tmp: written, then renamed over path
+    int every; // generations between checkpoints
+    long next; // round at which the next checkpoint is due
+    int due; // 1: the round being played ends on a checkpoint
+    int keys; // 1: sparse engine, buf holds keys
+    int zero; // 1: shares OR into shared words; clear buf after writing
+    uint64_t *buf; // the board being saved (bits or keys)
+    long n, cap; // words in buf, and room
+    struct checkpoint_header head; // header of the board in buf
+    long last_gen; // generation of the last checkpoint (-1: none)
+    long saved; // checkpoints written
+    long late; // rounds a due checkpoint waited for the writer
+
+    pthread_t writer;
+    pthread_mutex_t lock; // guards the fields below
+    pthread_cond_t cond; // busy or quit changed
+    int busy; // 1: buf is being written
+    int quit; // 1: the writer exits
+    int error; // errno of the first failed write (0: none)
+};
+
+/*
+Packs rows r0..r1, cols c0..c1 of an int board (scalar or padded) into
+the checkpoint's bits. Words only partly inside the rectangle can be
+shared with another thread's share, so they are ORed in atomically
+    data-> The struct containing information for the game
+    ck -> the checkpoint
+    board -> the board
+    r0, r1, c0, c1 -> the rectangle
+*/
+static void pack_ints(struct gol_data *data, struct checkpoint *ck,
+        int *board, int r0, int r1, int c0, int c1) {
+    const int *row;
+    uint64_t *out, bits;
+    int i, j, w, lo, hi, words;
+
+    words = (data->cols + 63) / 64;
+    for (i = r0; i <= r1; i++) {
+        row = board_row(data, board, i);
+        out = ck->buf + (size_t)i * words;
+        for (w = c0 / 64; w <= c1 / 64; w++) {
+            lo = (c0 > w * 64) ? c0 : w * 64;
+            hi = (c1 < w * 64 + 63) ? c1 : w * 64 + 63;
+            bits = 0;
+            for (j = lo; j <= hi; j++) {
+                bits |= (uint64_t)(row[j] & 1) << (j - w * 64);
+            }
+            if (lo == w * 64
+                    && (hi == w * 64 + 63 || hi == data->cols - 1)) {
+                out[w] = bits;
+            } else {
+                __atomic_fetch_or(&out[w], bits, __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+/*
+Packs rows r0..r1, cols c0..c1 of a board into the checkpoint's bits
+(for the packed board, c0 and c1 + 1 are word aligned as for
+play_region, and the rows are copied)
+    data-> The struct containing information for the game
+    next -> 1: the next board, 0: the current board
+    r0, r1, c0, c1 -> the rectangle
+*/
+static void pack_region(struct gol_data *data, int next, int r0, int r1,
+        int c0, int c1) {
+    struct checkpoint *ck = data->shared->ckpt;
+    const uint64_t *board;
+    int i, w0, w1;
+
+    if (data->kernel == KERNEL_PACKED) {
+        board = next ? data->packed_next : data->packed_board;
+        w0 = c0 / 64;
+        w1 = c1 / 64;
+        for (i = r0; i <= r1; i++) {
+            memcpy(ck->buf + (size_t)i * data->words + w0,
+                    board + (size_t)i * data->words + w0,
+                    sizeof(uint64_t) * (w1 - w0 + 1));
+        }
+        return;
+    }
+    pack_ints(data, ck, next ? data->next_board : data->gol_board,
+            r0, r1, c0, c1);
+}
+
+/*
+Copies the live cells of the sparse engine's current board (after
+end_round's flip) into the checkpoint buffer
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 if out of memory
+*/
+static int copy_keys(struct gol_data *data) {
+    struct checkpoint *ck = data->shared->ckpt;
+    const struct sparse_set *set;
+    uint64_t *grown;
+
+    set = data->shared->sparse[data->shared->cur];
+    if (set->n > ck->cap) {
+        grown = realloc(ck->buf, sizeof(uint64_t) * set->n);
+        if (grown == NULL) {
+            return 1;
+        }
+        ck->buf = grown;
+        ck->cap = set->n;
+    }
+    memcpy(ck->buf, set->cells, sizeof(uint64_t) * set->n);
+    ck->n = set->n;
+    return 0;
+}
+
+/*
+Writes the buffer to path.tmp and renames it over the checkpoint file
+    ck -> the checkpoint (buf and head hold a whole board)
+    returns: 0 on success, or errno
+*/
+static int write_file(struct checkpoint *ck) {
+    FILE *f;
+    int err;
+
+    f = fopen(ck->tmp, "wb");
+    if (f == NULL) {
+        return errno;
+    }
+    err = 0;
+    if (fwrite(&ck->head, sizeof(ck->head), 1, f) != 1
+            || (ck->n > 0 && fwrite(ck->buf, sizeof(uint64_t), ck->n, f)
+                != (size_t)ck->n)) {
+        err = errno;
+    }
+    if (fclose(f) != 0 && err == 0) {
+        err = errno;
+    }
+    if (err == 0 && rename(ck->tmp, ck->path) != 0) {
+        err = errno;
+    }
+    return err;
+}
+
+/*
+Thread function of the writer: writes every board handed to it (busy)
+until checkpoint_close sets quit
+    arg -> the struct checkpoint
+*/
+static void *writer_run(void *arg) {
+    struct checkpoint *ck = (struct checkpoint *)arg;
+    int err;
+
+    pthread_mutex_lock(&ck->lock);
+    for (;;) {
+        while (!ck->busy && !ck->quit) {
+            pthread_cond_wait(&ck->cond, &ck->lock);
+        }
+        if (!ck->busy) {
+            break;
+        }
+        pthread_mutex_unlock(&ck->lock);
+
+        err = write_file(ck);
+        if (ck->zero) {
+            memset(ck->buf, 0, sizeof(uint64_t) * ck->n);
+        }
+
+        pthread_mutex_lock(&ck->lock);
+        if (err != 0 && ck->error == 0) {
+            ck->error = err;
+        }
+        ck->saved++;
+        ck->busy = 0;
+        pthread_cond_broadcast(&ck->cond);
+    }
+    pthread_mutex_unlock(&ck->lock);
+    return NULL;
+}
+
+/*
+Hands the buffer, which holds the current board, to the writer and
+schedules the next checkpoint
+    data-> The struct containing information for the game
+*/
+static void hand_off(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct checkpoint *ck = shared->ckpt;
+    long gen;
+
+    gen = shared->base_gen + shared->round;
+    ck->head.generation = gen;
+    ck->head.target = shared->base_gen + shared->stop;
+    ck->head.live = shared->total_live;
+    ck->last_gen = gen;
+    ck->next = (gen / ck->every + 1) * ck->every - shared->base_gen;
+
+    pthread_mutex_lock(&ck->lock);
+    ck->busy = 1;
+    pthread_cond_broadcast(&ck->cond);
+    pthread_mutex_unlock(&ck->lock);
+}
+
+/*
+Fills in the header of a checkpoint of data's board stored as bits
+(the layout of the packed board; also used by the streaming engine)
+    data-> The struct containing information for the game (size, rule)
+    generation -> generation of the board
+    target -> generation the run plays to
+    live -> live cells on the board
+    out -> CHECKPOINT_HEAD bytes
+*/
+void checkpoint_head(struct gol_data *data, long generation, long target,
+        long live, void *out) {
+    struct checkpoint_header h;
+    char rule[RULE_LEN];
+    uint32_t mask;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.rows = data->rows;
+    h.cols = data->cols;
+    h.generation = generation;
+    h.target = target;
+    h.live = live;
+    h.encoding = CKPT_BITS;
+    h.words = (data->cols + 63) / 64;
+    rule_format(data->rule, rule);
+    if (strlen(rule) < sizeof(h.rule)) {
+        strcpy(h.rule, rule);
+    } else {
+        mask = data->rule;
+        memcpy(h.rule + 4, &mask, sizeof(mask));
+    }
+    memcpy(out, &h, sizeof(h));
+}
+
+/*
+Allocates the checkpoint buffer and starts the writer thread (after
+life_setup, before the worker threads start)
+    data-> The struct containing information for the game
+    path -> the checkpoint file
+    every -> generations between checkpoints
+    returns: 0 on success, 1 on error
+*/
+int checkpoint_open(struct gol_data *data, const char *path, int every) {
+    struct gol_shared *shared = data->shared;
+    struct checkpoint *ck;
+    int words;
+
+    ck = calloc(1, sizeof(struct checkpoint));
+    if (ck == NULL) {
+        return 1;
+    }
+    shared->ckpt = ck;
+    pthread_mutex_init(&ck->lock, NULL);
+    pthread_cond_init(&ck->cond, NULL);
+    ck->path = path;
+    ck->every = every;
+    ck->last_gen = -1;
+    ck->next = (shared->base_gen / every + 1) * every - shared->base_gen;
+    ck->keys = (data->kernel == KERNEL_SPARSE);
+    ck->zero = (data->part_mode != 0 && data->kernel != KERNEL_PACKED);
+
+    words = (data->cols + 63) / 64;
+    checkpoint_head(data, 0, 0, 0, &ck->head);
+    if (ck->keys) {
+        ck->head.encoding = CKPT_KEYS;
+        ck->head.words = 0;
+    }
+
+    ck->tmp = malloc(strlen(path) + 5);
+    if (ck->tmp == NULL) {
+        return 1;
+    }
+    sprintf(ck->tmp, "%s.tmp", path);
+    if (!ck->keys) {
+        ck->n = (long)data->rows * words;
+        ck->cap = ck->n;
+        ck->buf = calloc(ck->n, sizeof(uint64_t));
+        if (ck->buf == NULL) {
+            return 1;
+        }
+    }
+    if (pthread_create(&ck->writer, NULL, writer_run, ck) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Decides whether the round about to be played ends on a checkpoint (runs
+in start_loop and end_round, while the other threads wait): it does if
+it reaches the next checkpoint generation and the writer is free
+    data-> The struct containing information for the game
+*/
+void checkpoint_plan(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct checkpoint *ck = shared->ckpt;
+    int left, steps, busy;
+
+    left = shared->stop - shared->round;
+    steps = 1;
+    if (data->tb_k > 0) {
+        steps = (left < data->tb_k) ? left : data->tb_k;
+    }
+    ck->due = 0;
+    if (left <= 0 || shared->round + steps < ck->next) {
+        return;
+    }
+    pthread_mutex_lock(&ck->lock);
+    busy = ck->busy;
+    pthread_mutex_unlock(&ck->lock);
+    if (busy) {
+        ck->late++;
+        return;
+    }
+    ck->due = 1;
+}
+
+/*
+Packs this thread's share of the board it just played (rows, columns
+or tiles) into the checkpoint buffer, in a round that ends on a
+checkpoint (called by play_round with -s)
+    data-> The struct containing information for the game
+*/
+void checkpoint_share(struct gol_data *data) {
+    int k, r0, r1, c0, c1;
+
+    if (!data->shared->ckpt->due || data->kernel == KERNEL_SPARSE) {
+        return;
+    }
+    if (data->part_mode == 0) {
+        pack_region(data, 1, data->start, data->end, 0, data->cols - 1);
+    }
+    if (data->part_mode == 1) {
+        pack_region(data, 1, 0, data->rows - 1, data->start, data->end);
+    }
+    if (data->part_mode == 2) {
+        for (k = data->start; k <= data->end; k++) {
+            tile_bounds(data, k, &r0, &r1, &c0, &c1);
+            pack_region(data, 1, r0, r1, c0, c1);
+        }
+    }
+}
+
+/*
+Runs in end_round after the boards are flipped (and after any -r jump,
+which lands on the same board): hands a packed board to the writer and
+plans the next round
+    data-> The struct containing information for the game
+*/
+void checkpoint_round(struct gol_data *data) {
+    struct checkpoint *ck = data->shared->ckpt;
+
+    if (ck->due) {
+        if (ck->keys && copy_keys(data) != 0) {
+            // out of memory: skip this one, the writer is still free
+            ck->next += ck->every;
+        } else {
+            hand_off(data);
+        }
+    }
+    checkpoint_plan(data);
+}
+
+/*
+Saves the final board (unless the last checkpoint already holds it),
+waits for the writer and stops it; called after the worker threads are
+joined
+    data-> The struct containing information for the game
+    returns: 0 on success, or errno of the first failed write
+*/
+int checkpoint_close(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct checkpoint *ck = shared->ckpt;
+
+    if (ck == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&ck->lock);
+    while (ck->busy) {
+        pthread_cond_wait(&ck->cond, &ck->lock);
+    }
+    pthread_mutex_unlock(&ck->lock);
+
+    if (ck->last_gen != shared->base_gen + shared->round) {
+        sync_boards(data);
+        if (ck->keys) {
+            if (copy_keys(data) != 0) {
+                return ENOMEM;
+            }
+        } else {
+            pack_region(data, 0, 0, data->rows - 1, 0, data->cols - 1);
+        }
+        hand_off(data);
+    }
+
+    pthread_mutex_lock(&ck->lock);
+    while (ck->busy) {
+        pthread_cond_wait(&ck->cond, &ck->lock);
+    }
+    ck->quit = 1;
+    pthread_cond_broadcast(&ck->cond);
+    pthread_mutex_unlock(&ck->lock);
+    pthread_join(ck->writer, NULL);
+    return ck->error;
+}
+
+/*
+Prints the last checkpoint saved and how many were written
+    data-> The struct containing information for the game
+*/
+void checkpoint_report(struct gol_data *data) {
+    struct checkpoint *ck = data->shared->ckpt;
+
+    if (ck == NULL) {
+        return;
+    }
+    printf("Checkpoint: generation %ld in %s (%ld written, %ld rounds "
+            "waited for the writer)\n", ck->last_gen, ck->path, ck->saved,
+            ck->late);
+}
+
+/*
+Frees what checkpoint_open allocated
+    data-> The struct containing information for the game
+*/
+void checkpoint_free(struct gol_data *data) {
+    struct checkpoint *ck = data->shared->ckpt;
+
+    if (ck == NULL) {
+        return;
+    }
+    pthread_mutex_destroy(&ck->lock);
+    pthread_cond_destroy(&ck->cond);
+    free(ck->buf);
+    free(ck->tmp);
+    free(ck);
+    data->shared->ckpt = NULL;
+}
+
+/*
+Parses a checkpoint held in memory (load_buffer): the board size, its
+generation and the generation its run was playing to come from the
+header, and the cells are left where they are (pat->snap_cells) for
+checkpoint_place
+    buf -> the file (starts with CHECKPOINT_MAGIC)
+    len -> its length in bytes
+    name -> its name, for error messages
+    data-> The struct containing information for the game (-b, -i)
+    pat -> filled in
+    returns: 0 on success, 1 on error (the error has been printed)
+*/
+int checkpoint_parse(const char *buf, size_t len, const char *name,
+        struct gol_data *data, struct pattern *pat) {
+    struct checkpoint_header h;
+    const char *cells;
+    uint64_t word, key, prev, mask;
+    uint32_t rule;
+    long n, k, words, count;
+    size_t need;
+
+    if (len < sizeof(h)) {
+        printf("%s: checkpoint header is cut short\n", name);
+        return 1;
+    }
+    memcpy(&h, buf, sizeof(h));
+    words = (h.cols + 63) / 64;
+    if (h.rows < 1 || h.cols < 1 || h.live < 0 || h.live > INT32_MAX
+            || h.generation < 0
+            || (h.encoding == CKPT_BITS && h.words != words)
+            || (h.encoding != CKPT_BITS && h.encoding != CKPT_KEYS)) {
+        printf("%s: invalid checkpoint header\n", name);
+        return 1;
+    }
+    n = (h.encoding == CKPT_BITS) ? (long)h.rows * words : (long)h.live;
+    need = sizeof(h) + sizeof(uint64_t) * (size_t)n;
+    if (len < need) {
+        printf("%s: checkpoint is cut short (%zu of %zu bytes)\n", name,
+                len, need);
+        return 1;
+    }
+    if ((data->opt_rows > 0 && data->opt_rows != h.rows)
+            || (data->opt_cols > 0 && data->opt_cols != h.cols)) {
+        printf("%s: the checkpoint is %d x %d; -b cannot change it\n",
+                name, h.rows, h.cols);
+        return 1;
+    }
+
+    // check the cells against the header before anything is placed
+    cells = buf + sizeof(h);
+    count = 0;
+    if (h.encoding == CKPT_BITS) {
+        mask = (h.cols % 64 == 0) ? 0 : ~0ULL << (h.cols % 64);
+        for (k = 0; k < n; k++) {
+            memcpy(&word, cells + sizeof(uint64_t) * k, sizeof(word));
+            if ((k % words == words - 1) && (word & mask)) {
+                printf("%s: checkpoint has cells past the last column\n",
+                        name);
+                return 1;
+            }
+            count += __builtin_popcountll(word);
+        }
+    } else {
+        prev = 0;
+        for (k = 0; k < n; k++) {
+            memcpy(&key, cells + sizeof(uint64_t) * k, sizeof(key));
+            if (key >= (uint64_t)h.rows * h.cols || (k > 0 && key <= prev)) {
+                printf("%s: checkpoint cell %ld is out of order or off "
+                        "the board\n", name, k);
+                return 1;
+            }
+            prev = key;
+        }
+        count = n;
+    }
+    if (count != h.live) {
+        printf("%s: checkpoint has %ld live cells, its header says %ld\n",
+                name, count, (long)h.live);
+        return 1;
+    }
+
+    pat->rows = h.rows;
+    pat->cols = h.cols;
+    pat->live = (int)h.live;
+    pat->generation = h.generation;
+    pat->target = h.target;
+    if (data->opt_iters >= 0) {
+        pat->iters = data->opt_iters;
+    } else {
+        pat->iters = (h.target > h.generation)
+            ? (int)(h.target - h.generation) : 0;
+    }
+    if (h.rule[0] == '\0') {
+        memcpy(&rule, h.rule + 4, sizeof(rule));
+        rule_format(rule, pat->rule);
+    } else {
+        memcpy(pat->rule, h.rule, sizeof(h.rule));
+        pat->rule[sizeof(h.rule)] = '\0';
+    }
+    pat->snap_cells = cells;
+    pat->snap_keys = (h.encoding == CKPT_KEYS);
+    return 0;
+}
+
+/*
+Places the cells of a checkpoint on the new (all dead) board: the
+packed board takes the rows as they are, the other boards get a
+set_cell per live cell
+    data-> The struct containing information for the game
+    pat -> the checkpoint (checkpoint_parse)
+*/
+void checkpoint_place(struct gol_data *data, struct pattern *pat) {
+    const char *cells = pat->snap_cells;
+    uint64_t word, key;
+    long i, w, words;
+
+    if (pat->snap_keys) {
+        for (i = 0; i < pat->live; i++) {
+            memcpy(&key, cells + sizeof(uint64_t) * i, sizeof(key));
+            set_cell(data, key / data->cols, key % data->cols);
+        }
+        return;
+    }
+    words = (data->cols + 63) / 64;
+    if (data->kernel == KERNEL_PACKED) {
+        memcpy(data->packed_board, cells,
+                sizeof(uint64_t) * data->rows * words);
+        return;
+    }
+    for (i = 0; i < data->rows; i++) {
+        for (w = 0; w < words; w++) {
+            memcpy(&word, cells + sizeof(uint64_t) * (i * words + w),
+                    sizeof(word));
+            while (word != 0) {
+                set_cell(data, i, w * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,518 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Repeat detection (-r). Many boards settle into a still life, die out or
+fall into a short oscillator long before the last iteration; once the
+board is known to repeat with period p, all but (generations left) % p
+of the remaining generations can be skipped, since they would only
+bring the same boards back.
+
+After playing its share of a round each thread hashes its part of the
+new board into its cache line of shared->counts. The hash is a sum of
+per-cell (or per-word) terms, so it comes out the same however the
+board is split, and end_round only has to add the threads' parts up.
+Repeats are found with Brent's algorithm: one snapshot of the board is
+kept, retaken at generations 1, 2, 4, 8, ..., and every generation's
+hash is compared with the snapshot's. A matching hash is checked
+against the snapshot cell by cell before anything is skipped, so a hash
+collision costs one compare and nothing else. Brent's algorithm finds
+the smallest period once the snapshot is inside the cycle, at most about
+twice as many generations in as the cycle starts. The generation where
+the cycle starts is then found from the hashes of the generations before
+it. Only the last CYCLE_HISTORY hashes are kept (a ring), so a long run
+that never repeats does not grow without limit; a cycle that started
+before them is reported as starting at the oldest one kept, or earlier.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/* most generations whose hashes are kept (8 bytes each) */
+#define CYCLE_HISTORY (1L << 20)
+
+/* What -r keeps: the hashes of the last generations and Brent's
+ * snapshot */
+struct cycle {
+    uint64_t *colkey; // int boards: random key of every column
+    uint64_t *hashes; // ring: hash of generation g at g % cap
+    long nhash, cap; // generations hashed so far, and room (it grows up
+                     // to CYCLE_HISTORY, then the oldest are replaced)
+    uint64_t snap_hash; // hash of the snapshot
+    long snap_gen; // generation of the snapshot
+    long power; // the snapshot is retaken power generations after it
+    uint64_t *snap; // the snapshot: board bits (dense) or keys (sparse)
+    long snap_n; // uint64_t words in snap
+    long snap_cap; // room in snap
+    uint64_t *row; // int boards: one row of bits, for snap_equal
+    long start; // first generation of the cycle
+    int start_bound; // 1: the cycle may start before start (its hashes
+                     // were no longer kept)
+    long found_at; // generation at which it was found
+    long skipped; // generations skipped so far
+    long false_matches; // equal hashes of boards that were not equal
+};
+
+/*
+Mixes a 64-bit value into a well spread one (the splitmix64 finalizer)
+    x -> the value
+    returns: its mix
+*/
+static inline uint64_t mix(uint64_t x) {
+
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/*
+Hashes rows r0..r1, cols c0..c1 of an int board (scalar or padded): a
+row is the sum of the keys of its live columns, and the board the sum
+of every row times the row's own key. Row keys are drawn apart from the
+column keys, or a board and its transpose would hash the same. Sums
+keep the hash of a row split between threads the same.
+    data-> The struct containing information for the game
+    board -> the board
+    r0, r1, c0, c1 -> the rectangle
+    returns: the rectangle's part of the hash
+*/
+static uint64_t hash_ints(struct gol_data *data, int *board, int r0, int r1,
+        int c0, int c1) {
+    const uint64_t *key = data->shared->cycle->colkey;
+    const int *row;
+    uint64_t h, s;
+    int i, j;
+
+    h = 0;
+    for (i = r0; i <= r1; i++) {
+        row = board_row(data, board, i);
+        s = 0;
+        // branch free so it vectorizes
+        for (j = c0; j <= c1; j++) {
+            s += key[j] & -(uint64_t)row[j];
+        }
+        h += mix(~(uint64_t)i) * s;
+    }
+    return h;
+}
+
+/*
+Hashes rows r0..r1, cols c0..c1 (word aligned) of a packed board, a
+word at a time
+    data-> The struct containing information for the game
+    board -> the board
+    r0, r1, c0, c1 -> the rectangle
+    returns: the rectangle's part of the hash
+*/
+static uint64_t hash_packed(struct gol_data *data, const uint64_t *board,
+        int r0, int r1, int c0, int c1) {
+    const uint64_t *row;
+    uint64_t h;
+    int i, w;
+
+    h = 0;
+    for (i = r0; i <= r1; i++) {
+        row = board + (size_t)i * data->words;
+        for (w = c0 / 64; w <= c1 / 64; w++) {
+            if (row[w] != 0) {
+                h += mix(row[w] ^ mix((uint64_t)i * data->words + w));
+            }
+        }
+    }
+    return h;
+}
+
+/*
+Hashes a list of live cells (sparse engine)
+    set -> the cells
+    returns: the list's part of the hash
+*/
+static uint64_t hash_keys(const struct sparse_set *set) {
+    uint64_t h;
+    long k;
+
+    h = 0;
+    for (k = 0; k < set->n; k++) {
+        h += mix(set->cells[k]);
+    }
+    return h;
+}
+
+/*
+Hashes rows r0..r1, cols c0..c1 of the current or the next board
+    data-> The struct containing information for the game
+    next -> 1: the board just played, 0: the current one (whole board)
+    r0, r1, c0, c1 -> the rectangle
+    returns: the rectangle's part of the hash
+*/
+static uint64_t hash_region(struct gol_data *data, int next, int r0,
+        int r1, int c0, int c1) {
+
+    if (r0 > r1 || c0 > c1) {
+        return 0;
+    }
+    if (data->kernel == KERNEL_PACKED) {
+        return hash_packed(data, next ? data->packed_next
+                : data->packed_board, r0, r1, c0, c1);
+    }
+    if (data->kernel == KERNEL_SPARSE) {
+        // (a thread's next cells are only its own rows)
+        return hash_keys(next ? sparse_result(data) : data->sparse_board);
+    }
+    return hash_ints(data, next ? data->next_board : data->gol_board,
+            r0, r1, c0, c1);
+}
+
+/*
+Words the snapshot of a dense board takes: one bit per cell, rows
+starting on a new word (the packed board's own layout)
+    data-> The struct containing information for the game
+*/
+static long snap_words(struct gol_data *data) {
+
+    return (long)data->rows * ((data->cols + 63) / 64);
+}
+
+/*
+Packs row i of an int board into bits, 64 cells per word
+    data-> The struct containing information for the game
+    i -> the row
+    out -> room for (cols + 63) / 64 words
+*/
+static void pack_row(struct gol_data *data, int i, uint64_t *out) {
+    const int *row;
+    int j, w;
+
+    row = board_row(data, data->gol_board, i);
+    for (w = 0; w < (data->cols + 63) / 64; w++) {
+        out[w] = 0;
+    }
+    for (j = 0; j < data->cols; j++) {
+        out[j / 64] |= (uint64_t)(row[j] & 1) << (j % 64);
+    }
+}
+
+/*
+Copies the current board into the snapshot
+    data-> The struct containing information for the game (the calling
+        thread's boards must be current: see sync_boards)
+    returns: 0 on success, 1 if out of memory (no snapshot)
+*/
+static int snap_take(struct gol_data *data) {
+    struct cycle *cy = data->shared->cycle;
+    const struct sparse_set *set;
+    long need, words, i;
+    uint64_t *grown;
+
+    set = data->sparse_board;
+    need = (data->kernel == KERNEL_SPARSE) ? set->n : snap_words(data);
+    if (need > cy->snap_cap) {
+        grown = realloc(cy->snap, sizeof(uint64_t) * (need + 1));
+        if (grown == NULL) {
+            return 1;
+        }
+        cy->snap = grown;
+        cy->snap_cap = need;
+    }
+    cy->snap_n = need;
+
+    if (data->kernel == KERNEL_SPARSE) {
+        memcpy(cy->snap, set->cells, sizeof(uint64_t) * need);
+    } else if (data->kernel == KERNEL_PACKED) {
+        memcpy(cy->snap, data->packed_board, sizeof(uint64_t) * need);
+    } else {
+        words = (data->cols + 63) / 64;
+        for (i = 0; i < data->rows; i++) {
+            pack_row(data, i, cy->snap + i * words);
+        }
+    }
+    return 0;
+}
+
+/*
+Compares the current board with the snapshot, cell by cell
+    data-> The struct containing information for the game (boards
+        current)
+    returns: 1 if they are the same, 0 if not
+*/
+static int snap_equal(struct gol_data *data) {
+    struct cycle *cy = data->shared->cycle;
+    const struct sparse_set *set;
+    long words, i;
+
+    if (data->kernel == KERNEL_SPARSE) {
+        set = data->sparse_board;
+        return set->n == cy->snap_n && memcmp(set->cells, cy->snap,
+                sizeof(uint64_t) * set->n) == 0;
+    }
+    if (data->kernel == KERNEL_PACKED) {
+        return memcmp(data->packed_board, cy->snap,
+                sizeof(uint64_t) * cy->snap_n) == 0;
+    }
+    words = (data->cols + 63) / 64;
+    for (i = 0; i < data->rows; i++) {
+        pack_row(data, i, cy->row);
+        if (memcmp(cy->row, cy->snap + i * words,
+                    sizeof(uint64_t) * words) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+Adds a generation's hash to the history. The ring grows (before it has
+wrapped around, so every hash stays at g % cap) until it holds
+CYCLE_HISTORY hashes, or memory runs out; then the oldest is replaced.
+    cy -> the detection state
+    h -> the hash of generation cy->nhash
+    returns: 0 on success, 1 if out of memory with no room at all
+*/
+static int history_add(struct cycle *cy, uint64_t h) {
+    uint64_t *grown;
+    long cap;
+
+    if (cy->nhash == cy->cap && cy->cap < CYCLE_HISTORY) {
+        cap = (cy->cap > 0) ? 2 * cy->cap : 1024;
+        cap = (cap < CYCLE_HISTORY) ? cap : CYCLE_HISTORY;
+        grown = realloc(cy->hashes, sizeof(uint64_t) * cap);
+        if (grown != NULL) {
+            cy->hashes = grown;
+            cy->cap = cap;
+        } else if (cy->cap == 0) {
+            return 1;
+        }
+    }
+    cy->hashes[cy->nhash % cy->cap] = h;
+    cy->nhash++;
+    return 0;
+}
+
+/*
+Returns the hash of generation g (still in the history)
+    cy -> the detection state
+    g -> the generation
+*/
+static uint64_t history_at(struct cycle *cy, long g) {
+
+    return cy->hashes[g % cy->cap];
+}
+
+/*
+Sets up repeat detection: hashes generation 0 and takes it as the first
+snapshot
+    data-> The struct containing information for the game (the boards
+        hold generation 0)
+    returns: 0 on success, 1 on error
+*/
+int cycle_setup(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct cycle *cy;
+    int j;
+
+    cy = calloc(1, sizeof(struct cycle));
+    if (cy == NULL) {
+        return 1;
+    }
+    shared->cycle = cy;
+    if (data->kernel != KERNEL_PACKED && data->kernel != KERNEL_SPARSE) {
+        cy->colkey = malloc(sizeof(uint64_t) * data->cols);
+        cy->row = malloc(sizeof(uint64_t) * ((data->cols + 63) / 64));
+        if (cy->colkey == NULL || cy->row == NULL) {
+            return 1;
+        }
+        for (j = 0; j < data->cols; j++) {
+            cy->colkey[j] = mix(j + 1);
+        }
+    }
+    return cycle_reset(data);
+}
+
+/*
+Starts detection over at generation 0 (cycle_setup, and life_reset for a
+new board of the same size), keeping the keys and the history and
+snapshot buffers
+    data-> The struct containing information for the game (the boards
+        hold generation 0)
+    returns: 0 on success, 1 on error
+*/
+int cycle_reset(struct gol_data *data) {
+    struct cycle *cy = data->shared->cycle;
+
+    data->shared->period = 0;
+    cy->nhash = 0;
+    cy->start = 0;
+    cy->start_bound = 0;
+    cy->found_at = 0;
+    cy->skipped = 0;
+    cy->false_matches = 0;
+    cy->snap_hash = hash_region(data, 0, 0, data->rows - 1,
+            0, data->cols - 1);
+    cy->snap_gen = 0;
+    cy->power = 1;
+    if (history_add(cy, cy->snap_hash) != 0 || snap_take(data) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Hashes this thread's share of the board it just played (rows, columns
+or tiles) into its counts (called by play_round with -r)
+    data-> The struct containing information for the game
+*/
+void cycle_share(struct gol_data *data) {
+    uint64_t h;
+    int k, r0, r1, c0, c1;
+
+    h = 0;
+    if (data->part_mode == 0) {
+        h = hash_region(data, 1, data->start, data->end, 0, data->cols - 1);
+    }
+    if (data->part_mode == 1) {
+        h = hash_region(data, 1, 0, data->rows - 1, data->start, data->end);
+    }
+    if (data->part_mode == 2) {
+        for (k = data->start; k <= data->end; k++) {
+            tile_bounds(data, k, &r0, &r1, &c0, &c1);
+            h += hash_region(data, 1, r0, r1, c0, c1);
+        }
+    }
+    data->shared->counts[data->ntids].hash = h;
+}
+
+/*
+Runs in end_round after the boards are flipped: checks the new board
+against the snapshot (Brent's algorithm) and, once the board is known to
+repeat, skips every whole period left before the end of the run
+    data-> The struct containing information for the game
+*/
+void cycle_round(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct cycle *cy = shared->cycle;
+    uint64_t h;
+    long gen, skip, left, oldest;
+    int t;
+
+    if (shared->period == 0) {
+        h = 0;
+        for (t = 0; t < data->threads; t++) {
+            h += shared->counts[t].hash;
+        }
+        gen = shared->round;
+        sync_boards(data);
+        if (history_add(cy, h) != 0) {
+            // out of memory: stop looking
+            shared->period = -1;
+            return;
+        }
+        if (h == cy->snap_hash && snap_equal(data)) {
+            shared->period = gen - cy->snap_gen;
+            cy->found_at = gen;
+            // walk back to the first generation that already repeats
+            // (as far as the history goes)
+            oldest = (cy->nhash > cy->cap) ? cy->nhash - cy->cap : 0;
+            cy->start = cy->snap_gen;
+            while (cy->start - 1 >= oldest && history_at(cy, cy->start - 1)
+                    == history_at(cy, cy->start - 1 + shared->period)) {
+                cy->start--;
+            }
+            cy->start_bound = (cy->start > 0 && cy->start - 1 < oldest);
+        } else {
+            if (h == cy->snap_hash) {
+                cy->false_matches++;
+            }
+            if (gen - cy->snap_gen == cy->power) {
+                cy->snap_hash = h;
+                cy->snap_gen = gen;
+                cy->power *= 2;
+                if (snap_take(data) != 0) {
+                    shared->period = -1;
+                }
+            }
+        }
+    }
+    if (shared->period <= 0) {
+        return;
+    }
+
+    // the board repeats: jump over the whole periods that are left
+    left = shared->stop - shared->round;
+    skip = left - left % shared->period;
+    if (skip > 0) {
+        shared->round += skip;
+        cy->skipped += skip;
+        if (shared->changed != NULL) {
+            active_reset(data);
+        }
+    }
+}
+
+/*
+Prints the period found (or that none was), where the cycle starts and
+how many generations were skipped
+    data-> The struct containing information for the game
+*/
+void cycle_report(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct cycle *cy = shared->cycle;
+
+    if (cy == NULL) {
+        return;
+    }
+    if (shared->period > 0) {
+        printf("Cycle: period %ld from generation %ld%s (found at %ld, "
+                "%ld generations skipped)\n", shared->period, cy->start,
+                cy->start_bound ? " or earlier" : "", cy->found_at,
+                cy->skipped);
+    } else {
+        printf("Cycle: none found in %ld generations%s\n", cy->nhash - 1,
+                shared->period < 0 ? " (out of memory)" : "");
+    }
+    if (cy->false_matches > 0) {
+        printf("Cycle: %ld hash collisions ruled out by comparing the "
+                "boards\n", cy->false_matches);
+    }
+}
+
+/*
+Gets the cycle found, for libgol
+    data-> The struct containing information for the game
+    start -> set to the generation where the cycle starts (or the
+        oldest one whose hash was kept, if it starts before that)
+    returns: the period, or 0 if no repeat has been found
+*/
+long cycle_period(struct gol_data *data, long *start) {
+    struct gol_shared *shared = data->shared;
+
+    if (shared->cycle == NULL || shared->period <= 0) {
+        return 0;
+    }
+    *start = shared->cycle->start;
+    return shared->period;
+}
+
+/*
+Frees what cycle_setup allocated
+    data-> The struct containing information for the game
+*/
+void cycle_free(struct gol_data *data) {
+    struct cycle *cy = data->shared->cycle;
+
+    if (cy == NULL) {
+        return;
+    }
+    free(cy->colkey);
+    free(cy->row);
+    free(cy->hashes);
+    free(cy->snap);
+    free(cy);
+    data->shared->cycle = NULL;
+}
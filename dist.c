@@ -0,0 +1,1010 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Distributed mode (-D): the board is split between several gol processes,
+possibly on different hosts, so it is not limited by one machine's
+memory. Every process (a rank) owns the band of rows split_range gives
+it (the rows partition) and allocates only that band, as a padded board
+with one halo row above and below. Each generation it sends its first
+row to the rank above and its last row to the rank below (one bit per
+cell) and gets their rows back into its halo. The exchange is started
+before the band is played and finished after its interior rows: the
+interior needs no halo, so the rows are in flight while it is computed
+(the transport is polled every DIST_POLL_ROWS rows), and only the first
+and last rows wait for them.
+
+The exchange runs over a pluggable transport (struct dist_ops):
+    unix:PATH       Unix-domain stream sockets (rank r listens on PATH.r)
+    tcp:PORT[:H0,H1,...]  TCP (rank r listens on PORT + r on host Hr;
+                    one host, or none for 127.0.0.1, means all ranks)
+    shm:NAME        shared memory on one host (a segment /NAME.r between
+                    rank r and the rank below, one slot per direction)
+Rank r opens the link to the rank below (r + 1, wrapping around the
+torus) and accepts the one from the rank above, so every pair of
+neighbors has its own link; with two ranks both links join the same two
+processes. At the end the ranks add up their live cell changes around
+the ring, and rank 0 prints the report.
+
+    -D R/N:transport    run as rank R of N (start one per host)
+    -D N:transport      fork N local ranks and wait for them (one box)
+
+Each rank plays its band with one thread and the -k row kernel (the
+portable padded loop, or simd, avx2, avx512), under any rule.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <netdb.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "gol.h"
+
+/* interior rows played between two polls of the transport */
+#define DIST_POLL_ROWS (32)
+
+/* how long a rank waits for its neighbor to start listening */
+#define DIST_CONNECT_TRIES (600)
+#define DIST_CONNECT_USECS (50000)
+
+/* first bytes of a shared memory link once its owner has set it up */
+#define DIST_SHM_MAGIC (0x474f4c53484d3031ull) // "GOLSHM01"
+
+struct dist;
+
+/* One neighbor link and the message in flight on it (one each way) */
+struct dist_link {
+    int peer; // the neighbor's rank
+    int fd; // sockets: the connection
+    struct shm_slot *out, *in; // shm: the slots this side writes/reads
+    void *map; // shm: the segment
+    size_t map_len;
+    const char *send; // the message being sent
+    char *recv; // where the one being received goes
+    size_t len; // bytes per message (both ways)
+    size_t sent, got; // bytes moved so far
+    uint64_t seq; // messages started on this link
+};
+
+/* A transport: how links are set up, moved along and closed */
+struct dist_ops {
+    const char *name;
+    int (*setup)(struct dist *d); // opens both links (blocking)
+    int (*progress)(struct dist_link *l); // moves what it can without
+                                          // blocking: -1 on error
+    int (*wait)(struct dist *d); // blocks until a link may move
+    void (*close)(struct dist_link *l);
+};
+
+/* A rank: its band of the board and its two links */
+struct dist {
+    int rank, n; // this rank and the number of ranks
+    const struct dist_ops *ops;
+    char *addr; // transport address (PATH, PORT[:hosts] or NAME)
+    char **hosts; // tcp: host of every rank
+    int port; // tcp: port of rank 0
+
+    int rows, cols; // the whole board
+    int r0, r1, band; // this rank's rows and their number
+    size_t stride; // ints per padded row (cols + 2)
+    int *board, *next; // (band + 2) x (cols + 2), padded layout
+    size_t words; // uint64_t words per packed row
+    uint64_t *to_up, *to_down, *from_up, *from_down; // packed rows
+    struct dist_link up, down; // links to rank - 1 and rank + 1
+};
+
+/* A shared memory slot: one direction of a link */
+struct shm_slot {
+    uint64_t seq; // messages written (set by the writer after the data)
+    uint64_t ack; // messages read (set by the reader after copying)
+    char pad[CACHE_LINE - 2 * sizeof(uint64_t)];
+    // followed by the message (rounded up to a cache line)
+};
+
+/* The start of a shared memory link's segment */
+struct shm_head {
+    uint64_t magic; // DIST_SHM_MAGIC once the owner has set it up
+    int32_t rows, cols; // the board, checked by the other side
+    int32_t joined; // 1 once the other side has mapped it
+    char pad[CACHE_LINE - sizeof(uint64_t) - 3 * sizeof(int32_t)];
+    // followed by two slots: owner to peer, peer to owner
+};
+
+/*
+Returns a pointer to cell (i, j) of a band (i from -1 to band, j from -1
+to cols)
+    d -> the rank
+    board -> d->board or d->next
+    i, j -> the row within the band and the column
+*/
+static int *band_at(struct dist *d, int *board, int i, int j) {
+
+    return &board[(size_t)(i + 1) * d->stride + (j + 1)];
+}
+
+/*
+Copies the wrapped-around neighbors of one band row into its halo columns
+    d -> the rank
+    board -> d->board or d->next
+    i -> the row (-1 to band)
+*/
+static void fill_cols(struct dist *d, int *board, int i) {
+
+    *band_at(d, board, i, -1) = *band_at(d, board, i, d->cols - 1);
+    *band_at(d, board, i, d->cols) = *band_at(d, board, i, 0);
+}
+
+/*
+Packs a band row into bits (bit j % 64 of word j / 64 is column j)
+    d -> the rank
+    i -> the row
+    out -> d->words words
+*/
+static void pack_row(struct dist *d, int i, uint64_t *out) {
+    const int *row = band_at(d, d->board, i, 0);
+    int j;
+
+    memset(out, 0, sizeof(uint64_t) * d->words);
+    for (j = 0; j < d->cols; j++) {
+        out[j / 64] |= (uint64_t)(row[j] & 1) << (j % 64);
+    }
+}
+
+/*
+Unpacks bits into a band row (a halo row) and its halo columns
+    d -> the rank
+    i -> the row (-1 or band)
+    in -> d->words words
+*/
+static void unpack_row(struct dist *d, int i, const uint64_t *in) {
+    int *row = band_at(d, d->board, i, 0);
+    int j;
+
+    for (j = 0; j < d->cols; j++) {
+        row[j] = (in[j / 64] >> (j % 64)) & 1;
+    }
+    fill_cols(d, d->board, i);
+}
+
+/*
+Parses a -D spec: [R/]N:transport:address
+    spec -> the spec
+    d -> its rank, n, ops and addr are set (rank -1: fork N ranks)
+    returns: 0 on success, 1 if it is not a valid spec
+*/
+static int parse_spec(const char *spec, struct dist *d);
+
+/*
+Checks that a -D spec is valid (run by parse_options)
+    spec -> the spec
+    returns: 0 if it is, 1 if not
+*/
+int dist_check(const char *spec) {
+    struct dist d;
+    int ret;
+
+    memset(&d, 0, sizeof(d));
+    ret = parse_spec(spec, &d);
+    free(d.addr);
+    return ret;
+}
+
+/******************** sockets (unix and tcp) ***********************/
+
+/*
+Fills in the socket address rank r listens on
+    d -> the rank (transport and address)
+    r -> the rank whose address is wanted
+    sa -> set to the address
+    len -> set to its length
+    returns: 0 on success, 1 on error
+*/
+static int sock_addr(struct dist *d, int r, struct sockaddr_storage *sa,
+        socklen_t *len) {
+    struct sockaddr_un *un = (struct sockaddr_un *)sa;
+    struct addrinfo hints, *res;
+    char port[16];
+
+    memset(sa, 0, sizeof(*sa));
+    if (d->hosts == NULL) {
+        un->sun_family = AF_UNIX;
+        if (snprintf(un->sun_path, sizeof(un->sun_path), "%s.%d", d->addr,
+                    r) >= (int)sizeof(un->sun_path)) {
+            errno = ENAMETOOLONG;
+            return 1;
+        }
+        *len = sizeof(*un);
+        return 0;
+    }
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%d", d->port + r);
+    if (getaddrinfo(d->hosts[r], port, &hints, &res) != 0) {
+        errno = EHOSTUNREACH;
+        return 1;
+    }
+    memcpy(sa, res->ai_addr, res->ai_addrlen);
+    *len = res->ai_addrlen;
+    freeaddrinfo(res);
+    return 0;
+}
+
+/*
+Reads or writes exactly len bytes on a blocking socket
+    fd -> the socket
+    buf -> the bytes
+    len -> how many
+    out -> 1 to write, 0 to read
+    returns: 0 on success, 1 on error or end of file
+*/
+static int sock_full(int fd, void *buf, size_t len, int out) {
+    ssize_t n;
+    size_t done;
+
+    for (done = 0; done < len; done += n) {
+        n = out ? send(fd, (char *)buf + done, len - done, MSG_NOSIGNAL)
+                : recv(fd, (char *)buf + done, len - done, 0);
+        if (n < 0 && errno == EINTR) {
+            n = 0;
+        } else if (n <= 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+Opens both links of a rank over sockets: listens on its own address,
+connects to the rank below and accepts the rank above; the two sides
+check each other's rank and board size
+    d -> the rank
+    returns: 0 on success, 1 on error
+*/
+static int sock_setup(struct dist *d) {
+    struct sockaddr_storage sa;
+    socklen_t len;
+    int32_t hello[3], got[3];
+    int lfd, one, tries;
+
+    if (sock_addr(d, d->rank, &sa, &len) != 0) {
+        return 1;
+    }
+    lfd = socket(sa.ss_family, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        return 1;
+    }
+    one = 1;
+    if (d->hosts == NULL) {
+        unlink(((struct sockaddr_un *)&sa)->sun_path);
+    } else {
+        setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ((struct sockaddr_in *)&sa)->sin_addr.s_addr = htonl(INADDR_ANY);
+    }
+    if (bind(lfd, (struct sockaddr *)&sa, len) != 0 || listen(lfd, 4) != 0) {
+        close(lfd);
+        return 1;
+    }
+
+    // the rank below may not be listening yet
+    if (sock_addr(d, d->down.peer, &sa, &len) != 0) {
+        close(lfd);
+        return 1;
+    }
+    for (tries = 0; tries < DIST_CONNECT_TRIES; tries++) {
+        d->down.fd = socket(sa.ss_family, SOCK_STREAM, 0);
+        if (d->down.fd < 0) {
+            break;
+        }
+        if (connect(d->down.fd, (struct sockaddr *)&sa, len) == 0) {
+            break;
+        }
+        close(d->down.fd);
+        d->down.fd = -1;
+        if (errno != ECONNREFUSED && errno != ENOENT) {
+            break;
+        }
+        usleep(DIST_CONNECT_USECS);
+    }
+    hello[0] = d->rank;
+    hello[1] = d->rows;
+    hello[2] = d->cols;
+    if (d->down.fd < 0
+            || sock_full(d->down.fd, hello, sizeof(hello), 1) != 0) {
+        close(lfd);
+        return 1;
+    }
+
+    d->up.fd = accept(lfd, NULL, NULL);
+    close(lfd);
+    if (d->hosts == NULL) {
+        sock_addr(d, d->rank, &sa, &len);
+        unlink(((struct sockaddr_un *)&sa)->sun_path);
+    }
+    if (d->up.fd < 0 || sock_full(d->up.fd, got, sizeof(got), 0) != 0) {
+        return 1;
+    }
+    if (got[0] != d->up.peer || got[1] != d->rows || got[2] != d->cols) {
+        errno = EPROTO;
+        return 1;
+    }
+
+    if (d->hosts != NULL) {
+        setsockopt(d->up.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(d->down.fd, IPPROTO_TCP, TCP_NODELAY, &one,
+                sizeof(one));
+    }
+    fcntl(d->up.fd, F_SETFL, fcntl(d->up.fd, F_GETFL) | O_NONBLOCK);
+    fcntl(d->down.fd, F_SETFL, fcntl(d->down.fd, F_GETFL) | O_NONBLOCK);
+    return 0;
+}
+
+/*
+Sends and receives what a socket link can take right now
+    l -> the link
+    returns: 0 on success, -1 on error (or if the neighbor has gone)
+*/
+static int sock_progress(struct dist_link *l) {
+    ssize_t n;
+
+    while (l->sent < l->len) {
+        n = send(l->fd, l->send + l->sent, l->len - l->sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno != EINTR) {
+                return -1;
+            }
+            n = 0;
+        }
+        l->sent += n;
+    }
+    while (l->got < l->len) {
+        n = recv(l->fd, l->recv + l->got, l->len - l->got, 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno != EINTR) {
+                return -1;
+            }
+            n = 0;
+        }
+        if (n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        l->got += n;
+    }
+    return 0;
+}
+
+/*
+Blocks until one of the rank's sockets can send or receive more
+    d -> the rank
+    returns: 0 on success, 1 on error
+*/
+static int sock_wait(struct dist *d) {
+    struct pollfd fds[2];
+    struct dist_link *l;
+    int k;
+
+    for (k = 0; k < 2; k++) {
+        l = (k == 0) ? &d->up : &d->down;
+        fds[k].fd = l->fd;
+        fds[k].events = ((l->sent < l->len) ? POLLOUT : 0)
+            | ((l->got < l->len) ? POLLIN : 0);
+        if (fds[k].events == 0) {
+            fds[k].fd = -1;
+        }
+    }
+    if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Closes a socket link
+    l -> the link
+*/
+static void sock_close(struct dist_link *l) {
+
+    if (l->fd >= 0) {
+        close(l->fd);
+        l->fd = -1;
+    }
+}
+
+/******************** shared memory ***********************/
+
+/*
+Returns the size of one shm slot for messages of len bytes
+    len -> the message size
+*/
+static size_t slot_size(size_t len) {
+
+    return sizeof(struct shm_slot)
+        + (len + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+/*
+Maps the segment of the link between rank r and the rank below it
+(/NAME.r), creating it when this rank owns it
+    d -> the rank
+    l -> the link (up or down)
+    r -> the rank that owns the segment
+    returns: 0 on success, 1 on error
+*/
+static int shm_link(struct dist *d, struct dist_link *l, int r) {
+    struct shm_head *head;
+    char name[256];
+    char *slots;
+    size_t len, slot;
+    int fd, tries, owner;
+
+    owner = (r == d->rank);
+    snprintf(name, sizeof(name), "/%s.%d", d->addr, r);
+    // one slot carries a packed row or a ring sum (one uint64_t)
+    slot = slot_size(sizeof(uint64_t) * d->words);
+    len = sizeof(struct shm_head) + 2 * slot;
+    fd = -1;
+    if (owner) {
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd >= 0 && ftruncate(fd, len) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        for (tries = 0; fd < 0 && tries < DIST_CONNECT_TRIES; tries++) {
+            fd = shm_open(name, O_RDWR, 0600);
+            if (fd < 0) {
+                usleep(DIST_CONNECT_USECS);
+            }
+        }
+    }
+    if (fd < 0) {
+        return 1;
+    }
+    l->map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (l->map == MAP_FAILED) {
+        l->map = NULL;
+        return 1;
+    }
+    l->map_len = len;
+    head = (struct shm_head *)l->map;
+    slots = (char *)l->map + sizeof(struct shm_head);
+    l->out = (struct shm_slot *)(slots + (owner ? 0 : slot));
+    l->in = (struct shm_slot *)(slots + (owner ? slot : 0));
+
+    if (owner) {
+        head->rows = d->rows;
+        head->cols = d->cols;
+        __atomic_store_n(&head->magic, DIST_SHM_MAGIC, __ATOMIC_RELEASE);
+        return 0;
+    }
+    // the owner may not have filled the header in yet
+    for (tries = 0; __atomic_load_n(&head->magic, __ATOMIC_ACQUIRE)
+            != DIST_SHM_MAGIC; tries++) {
+        if (tries == DIST_CONNECT_TRIES) {
+            errno = ETIMEDOUT;
+            return 1;
+        }
+        usleep(DIST_CONNECT_USECS);
+    }
+    if (head->rows != d->rows || head->cols != d->cols) {
+        errno = EPROTO;
+        return 1;
+    }
+    __atomic_store_n(&head->joined, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+Opens both links of a rank over shared memory: creates the segment to
+the rank below, maps the one from the rank above, and removes the name
+of its own once the rank below has mapped it
+    d -> the rank
+    returns: 0 on success, 1 on error
+*/
+static int shm_setup(struct dist *d) {
+    struct shm_head *head;
+    char name[256];
+    int tries;
+
+    if (shm_link(d, &d->down, d->rank) != 0
+            || shm_link(d, &d->up, d->up.peer) != 0) {
+        return 1;
+    }
+    head = (struct shm_head *)d->down.map;
+    for (tries = 0; !__atomic_load_n(&head->joined, __ATOMIC_ACQUIRE);
+            tries++) {
+        if (tries == DIST_CONNECT_TRIES) {
+            errno = ETIMEDOUT;
+            return 1;
+        }
+        usleep(DIST_CONNECT_USECS);
+    }
+    snprintf(name, sizeof(name), "/%s.%d", d->addr, d->rank);
+    shm_unlink(name);
+    return 0;
+}
+
+/*
+Moves a message through a shm link if the slots allow: the message is
+written once the reader has taken the previous one, and read once the
+writer has published it
+    l -> the link
+    returns: 0
+*/
+static int shm_progress(struct dist_link *l) {
+
+    if (l->sent < l->len
+            && __atomic_load_n(&l->out->ack, __ATOMIC_ACQUIRE)
+                == l->seq - 1) {
+        memcpy(l->out + 1, l->send, l->len);
+        __atomic_store_n(&l->out->seq, l->seq, __ATOMIC_RELEASE);
+        l->sent = l->len;
+    }
+    if (l->got < l->len
+            && __atomic_load_n(&l->in->seq, __ATOMIC_ACQUIRE) == l->seq) {
+        memcpy(l->recv, l->in + 1, l->len);
+        __atomic_store_n(&l->in->ack, l->seq, __ATOMIC_RELEASE);
+        l->got = l->len;
+    }
+    return 0;
+}
+
+/*
+Lets the neighbors run while a shm exchange waits for them
+    d -> the rank
+    returns: 0
+*/
+static int shm_wait(struct dist *d) {
+
+    (void)d;
+    sched_yield();
+    return 0;
+}
+
+/*
+Unmaps a shm link
+    l -> the link
+*/
+static void shm_close(struct dist_link *l) {
+
+    if (l->map != NULL) {
+        munmap(l->map, l->map_len);
+        l->map = NULL;
+    }
+}
+
+static const struct dist_ops unix_ops = {
+    "unix", sock_setup, sock_progress, sock_wait, sock_close
+};
+static const struct dist_ops tcp_ops = {
+    "tcp", sock_setup, sock_progress, sock_wait, sock_close
+};
+static const struct dist_ops shm_ops = {
+    "shm", shm_setup, shm_progress, shm_wait, shm_close
+};
+
+/******************** the exchange ***********************/
+
+/*
+Starts an exchange with both neighbors: to_up goes to the rank above and
+to_down to the rank below, and their messages arrive in from_up and
+from_down; nothing waits here
+    d -> the rank
+    to_up, to_down, from_up, from_down -> len bytes each
+    len -> the message size
+    returns: 0 on success, 1 on error
+*/
+static int exchange_start(struct dist *d, const void *to_up,
+        const void *to_down, void *from_up, void *from_down, size_t len) {
+
+    d->up.send = to_up;
+    d->up.recv = from_up;
+    d->down.send = to_down;
+    d->down.recv = from_down;
+    d->up.len = len;
+    d->down.len = len;
+    d->up.sent = d->up.got = 0;
+    d->down.sent = d->down.got = 0;
+    d->up.seq++;
+    d->down.seq++;
+    if (d->ops->progress(&d->up) != 0 || d->ops->progress(&d->down) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Moves the exchange along without waiting
+    d -> the rank
+    returns: 1 when it is complete, 0 if not yet, -1 on error
+*/
+static int exchange_poll(struct dist *d) {
+
+    if (d->ops->progress(&d->up) != 0 || d->ops->progress(&d->down) != 0) {
+        return -1;
+    }
+    return d->up.sent == d->up.len && d->up.got == d->up.len
+        && d->down.sent == d->down.len && d->down.got == d->down.len;
+}
+
+/*
+Waits for the exchange to complete
+    d -> the rank
+    returns: 0 on success, 1 on error
+*/
+static int exchange_finish(struct dist *d) {
+    int ret;
+
+    while ((ret = exchange_poll(d)) == 0) {
+        if (d->ops->wait(d) != 0) {
+            return 1;
+        }
+    }
+    return ret < 0;
+}
+
+/*
+Adds up one number from every rank by passing the numbers around the
+ring (n - 1 exchanges; every rank ends up with the sum)
+    d -> the rank
+    value -> this rank's number
+    sum -> set to the sum over all ranks
+    returns: 0 on success, 1 on error
+*/
+static int ring_sum(struct dist *d, int64_t value, int64_t *sum) {
+    int64_t pass, got, unused, none;
+    int k;
+
+    *sum = value;
+    pass = value;
+    none = 0;
+    for (k = 1; k < d->n; k++) {
+        if (exchange_start(d, &none, &pass, &got, &unused, sizeof(pass))
+                != 0 || exchange_finish(d) != 0) {
+            return 1;
+        }
+        *sum += got;
+        pass = got;
+    }
+    return 0;
+}
+
+/******************** the band ***********************/
+
+/*
+Parses a -D spec: [R/]N:transport:address (see the top of this file)
+    spec -> the spec
+    d -> its rank, n, ops, addr, hosts and port are set (rank -1: fork
+        N ranks)
+    returns: 0 on success, 1 if it is not a valid spec
+*/
+static int parse_spec(const char *spec, struct dist *d) {
+    const char *p;
+    char *end, *h;
+    int k, nhosts;
+
+    d->rank = -1;
+    d->n = (int)strtol(spec, &end, 10);
+    if (*end == '/') {
+        d->rank = d->n;
+        d->n = (int)strtol(end + 1, &end, 10);
+    }
+    if (*end != ':' || d->n < 2 || d->rank < -1 || d->rank >= d->n) {
+        return 1;
+    }
+    p = end + 1;
+    if (strncmp(p, "unix:", 5) == 0) {
+        d->ops = &unix_ops;
+    } else if (strncmp(p, "tcp:", 4) == 0) {
+        d->ops = &tcp_ops;
+    } else if (strncmp(p, "shm:", 4) == 0) {
+        d->ops = &shm_ops;
+    } else {
+        return 1;
+    }
+    p = strchr(p, ':') + 1;
+    if (*p == '\0' || (d->ops == &shm_ops && strchr(p, '/') != NULL)) {
+        return 1;
+    }
+    d->addr = strdup(p);
+    if (d->addr == NULL || d->ops != &tcp_ops) {
+        return d->addr == NULL;
+    }
+
+    // tcp: PORT[:host0,host1,...]
+    d->port = (int)strtol(d->addr, &end, 10);
+    if (d->port < 1 || d->port + d->n > 65535
+            || (*end != '\0' && *end != ':')) {
+        return 1;
+    }
+    d->hosts = malloc(sizeof(char *) * d->n);
+    if (d->hosts == NULL) {
+        return 1;
+    }
+    nhosts = 0;
+    h = (*end == ':') ? end + 1 : NULL;
+    while (h != NULL && nhosts < d->n) {
+        d->hosts[nhosts++] = h;
+        h = strchr(h, ',');
+        if (h != NULL) {
+            *h++ = '\0';
+        }
+    }
+    if (h != NULL || (nhosts != 0 && nhosts != 1 && nhosts != d->n)) {
+        return 1;
+    }
+    for (k = nhosts; k < d->n; k++) {
+        d->hosts[k] = (nhosts == 1) ? d->hosts[0] : "127.0.0.1";
+    }
+    return 0;
+}
+
+/*
+Allocates the band and places the pattern's cells that fall in it
+    d -> the rank (rows, cols and its rows set)
+    pat -> the loaded input
+    returns: 0 on success, 1 on error
+*/
+static int band_setup(struct dist *d, struct pattern *pat) {
+    const char *cells = pat->snap_cells;
+    uint64_t word, key;
+    size_t n;
+    long k, i, w, row, col;
+
+    d->stride = (size_t)d->cols + 2;
+    n = (size_t)(d->band + 2) * d->stride;
+    d->board = calloc(n, sizeof(int));
+    d->next = calloc(n, sizeof(int));
+    d->words = (d->cols + 63) / 64;
+    d->to_up = calloc(4 * d->words, sizeof(uint64_t));
+    if (d->board == NULL || d->next == NULL || d->to_up == NULL) {
+        return 1;
+    }
+    d->to_down = d->to_up + d->words;
+    d->from_up = d->to_down + d->words;
+    d->from_down = d->from_up + d->words;
+
+    for (k = 0; k < pat->ncells; k++) {
+        row = pat->cells[2 * k];
+        col = pat->cells[2 * k + 1];
+        if (row >= d->r0 && row <= d->r1) {
+            *band_at(d, d->board, row - d->r0, col) = 1;
+        }
+    }
+    // a checkpoint: only this band's part of the file is read
+    if (cells != NULL && pat->snap_keys) {
+        for (k = 0; k < pat->live; k++) {
+            memcpy(&key, cells + sizeof(uint64_t) * k, sizeof(key));
+            row = key / d->cols;
+            if (row >= d->r0 && row <= d->r1) {
+                *band_at(d, d->board, row - d->r0, key % d->cols) = 1;
+            }
+        }
+    } else if (cells != NULL) {
+        for (i = d->r0; i <= d->r1; i++) {
+            for (w = 0; w < (long)d->words; w++) {
+                memcpy(&word, cells + sizeof(uint64_t)
+                        * (i * d->words + w), sizeof(word));
+                while (word != 0) {
+                    *band_at(d, d->board, i - d->r0,
+                            w * 64 + __builtin_ctzll(word)) = 1;
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+    for (i = 0; i < d->band; i++) {
+        fill_cols(d, d->board, i);
+    }
+    return 0;
+}
+
+/*
+Plays one band row into the next board
+    data-> The struct containing information for the game (row kernel
+        and rule)
+    d -> the rank
+    i -> the row
+    returns: the change in the number of live cells on the row
+*/
+static int band_row(struct gol_data *data, struct dist *d, int i) {
+    const int *mid = band_at(d, d->board, i, 0);
+    int live;
+
+    live = data->row_fn(mid - d->stride, mid, mid + d->stride,
+            band_at(d, d->next, i, 0), d->cols, data->rule);
+    fill_cols(d, d->next, i);
+    return live;
+}
+
+/*
+Plays all the generations on this rank's band, exchanging the boundary
+rows with the neighbors every generation
+    data-> The struct containing information for the game
+    d -> the rank
+    live -> set to the change in the number of live cells on the band
+    returns: 0 on success, 1 on a transport error
+*/
+static int band_play(struct gol_data *data, struct dist *d, long *live) {
+    int g, i, last;
+    int *tmp;
+
+    *live = 0;
+    last = d->band - 1;
+    for (g = 0; g < data->iters; g++) {
+        pack_row(d, 0, d->to_up);
+        pack_row(d, last, d->to_down);
+        if (exchange_start(d, d->to_up, d->to_down, d->from_up,
+                    d->from_down, sizeof(uint64_t) * d->words) != 0) {
+            return 1;
+        }
+
+        // the interior needs no halo: play it while the rows travel
+        for (i = 1; i < last; i++) {
+            *live += band_row(data, d, i);
+            if (i % DIST_POLL_ROWS == 0 && exchange_poll(d) < 0) {
+                return 1;
+            }
+        }
+        if (exchange_finish(d) != 0) {
+            return 1;
+        }
+        unpack_row(d, -1, d->from_up);
+        unpack_row(d, d->band, d->from_down);
+        *live += band_row(data, d, 0);
+        if (last > 0) {
+            *live += band_row(data, d, last);
+        }
+
+        tmp = d->board;
+        d->board = d->next;
+        d->next = tmp;
+    }
+    return 0;
+}
+
+/*
+Runs one rank: loads the input, plays its band, adds up the live cells
+with the other ranks; rank 0 prints the report
+    data-> The struct containing information for the game (options)
+    d -> the rank (from parse_spec)
+    path -> the input file
+    returns: 0 on success, 1 on error (printed)
+*/
+static int dist_rank(struct gol_data *data, struct dist *d,
+        const char *path) {
+    struct pattern pat;
+    struct timeval start, stop;
+    int64_t total, sum;
+    long live;
+    int ret;
+
+    if (load_pattern(path, data, &pat) != 0) {
+        return 1;
+    }
+    life_rule(data, &pat);
+    data->iters = pat.iters;
+    d->rows = pat.rows;
+    d->cols = pat.cols;
+    if (d->n > d->rows) {
+        // (every rank finds this; one message is enough)
+        if (d->rank == 0) {
+            printf("ERROR: -D needs at least one row per rank (%d rows)\n",
+                    d->rows);
+        }
+        free_pattern(&pat);
+        return 1;
+    }
+    split_range(d->rows, d->n, d->rank, &d->r0, &d->r1);
+    d->band = d->r1 - d->r0 + 1;
+    d->up.peer = (d->rank - 1 + d->n) % d->n;
+    d->down.peer = (d->rank + 1) % d->n;
+    d->up.fd = d->down.fd = -1;
+    ret = band_setup(d, &pat);
+    total = pat.live;
+    free_pattern(&pat);
+    if (ret != 0) {
+        printf("Unable to initialize board\n");
+        return 1;
+    }
+    if (data->print_config == 1) {
+        printf("rank %d:  rows: %d:%d (%d)  cols: 0:%d (%d) \n", d->rank,
+                d->r0, d->r1, d->band, d->cols - 1, d->cols);
+    }
+
+    if (d->ops->setup(d) != 0) {
+        perror("-D: connecting to the neighbor ranks");
+        return 1;
+    }
+    gettimeofday(&start, NULL);
+    if (band_play(data, d, &live) != 0 || ring_sum(d, live, &sum) != 0) {
+        perror("-D: exchanging rows");
+        return 1;
+    }
+    gettimeofday(&stop, NULL);
+
+    if (d->rank == 0) {
+        total += sum;
+        printf("Distributed: %d ranks over %s, %d rows each or so\n", d->n,
+                d->ops->name, d->rows / d->n);
+        fprintf(stdout, "Kernel: %s\n", (data->kernel == KERNEL_PADDED)
+                ? data->kernel_name : "padded");
+        fprintf(stdout, "Total time: %0.3f seconds\n",
+                (stop.tv_sec + stop.tv_usec * .000001)
+                - (start.tv_sec + start.tv_usec * .000001));
+        fprintf(stdout, "Number of live cells after %d rounds: %d\n\n",
+                data->iters, (int)total);
+    }
+    return 0;
+}
+
+/*
+Runs gol in distributed mode (-D): as one rank, or, with no rank in the
+spec, as N local ranks forked from this process
+    data-> The struct containing information for the game (options)
+    path -> the input file
+    returns: the exit status (0: every rank succeeded)
+*/
+int dist_main(struct gol_data *data, const char *path) {
+    struct dist d;
+    pid_t pid;
+    int r, status, failed;
+
+    memset(&d, 0, sizeof(d));
+    parse_spec(data->dist_spec, &d);
+    if (d.rank < 0) {
+        fflush(stdout);
+        for (r = 0; r < d.n; r++) {
+            pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                return 1;
+            }
+            if (pid == 0) {
+                d.rank = r;
+                break;
+            }
+        }
+        if (d.rank < 0) {
+            failed = 0;
+            while (wait(&status) > 0) {
+                failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+            }
+            return failed;
+        }
+    }
+
+    r = dist_rank(data, &d, path);
+    if (d.ops != NULL) {
+        d.ops->close(&d.up);
+        d.ops->close(&d.down);
+    }
+    free(d.board);
+    free(d.next);
+    free(d.to_up);
+    free(d.hosts);
+    free(d.addr);
+    return r;
+}
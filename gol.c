@@ -17,97 +17,39 @@ the user to specify how many threads they would like to run the program on.
  * ./gol file1.txt  2  # run with config file file1.txt, ParaVis animation
  *
  */
-#include <pthreadGridVisi.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <time.h>
 #include <string.h>
+#include <errno.h>
 #include <pthread.h>
+#include "gol.h"
 #include "colors.h"
 
-/****************** Definitions **********************/
-/* Three possible modes in which the GOL simulation can run */
-#define OUTPUT_NONE   (0)   // with no animation
-#define OUTPUT_ASCII  (1)   // with ascii animation
-#define OUTPUT_VISI   (2)   // with ParaVis animation
-
-/* Used to slow down animation run modes: usleep(SLEEP_USECS);
- * Change this value to make the animation run faster or slower
- */
-//#define SLEEP_USECS  (1000000)
-#define SLEEP_USECS    (100000)
-
-/* A global variable to keep track of the number of live cells in the
- * world (this is the ONLY global variable you may use in your program)
- */
-static int total_live = 0;
-
-/* This struct represents all the data you need to keep track of your GOL
- * simulation.  Rather than passing individual arguments into each function,
- * we'll pass in everything in just one of these structs.
- * this is passed to play_gol, the main gol playing loop
- *
- * NOTE: You will need to use the provided fields here, but you'll also
- *       need to add additional fields. (note the nice field comments!)
- * NOTE: DO NOT CHANGE THE NAME OF THIS STRUCT!!!!
- */
-struct gol_data {
-
-    // NOTE: DO NOT CHANGE the names of these 4 fields (but USE them)
-    int curr_iter; //for visi
-    int rows;  // the row dimension
-    int cols;  // the column dimension
-    int iters; // number of iterations to run the gol simulation
-    int output_mode; // set to:  OUTPUT_NONE, OUTPUT_ASCII, or OUTPUT_VISI
-    int* gol_board; //represents the current board (base next round on this)
-    int *next_board; //the next board to play 
-    int threads; //number of threads the user determines
-    int ntids; // the identifier for which thread is running
-    int part_mode; // A 0/1 flag to specify how to parallelize the GOL program 
-    //(0: row-wise grid cell allocation, 1: column-wise grid cell allocation)
-    int print_config; // A 0/1 flag to specify should the per-thread board
-    // allocation be printed
-    int start; // the starting col/row for each thread to run
-    int end; // the ending col/row for each thread to run
-
-    /* fields used by ParaVis library (when run in OUTPUT_VISI mode). */
-    // NOTE: DO NOT CHANGE their definitions BUT USE these fields
-    visi_handle handle;
-    color3 *image_buff;
-};
-
-
 /****************** Function Prototypes **********************/
 
-/* the main gol game playing loop (prototype must match this) */
-void* play_gol(void * arg);
-
 /* init gol data from the input file and run mode cmdline args */
-int init_game_data_from_args(struct gol_data *data, char **argv);
+int init_game_data_from_args(struct gol_data *data,
+        struct gol_shared *shared, int argc, char **argv);
 
-// A mostly implemented function, but a bit more for you to add.
-/* print board to the terminal (for OUTPUT_ASCII mode) */
-void print_board(struct gol_data *data, int round);
+/* parse the optional flags that follow the positional args */
+void parse_options(struct gol_data *data, int argc, char **argv);
 
-/*Checks a cells neighbors (in the copy board) and returns how many of them are alive*/
-int count_neighbors(struct gol_data *data, int i, int j);
+/* use a render frame to set colors for visualization */
+void update_colors(struct gol_data *data, const unsigned char *frame);
 
-/*Updates the playing board based on one iteration of the game*/
-void play_round(struct gol_data *data);
+/* set colors for one rectangle of the board */
+void color_region(struct gol_data *data, const unsigned char *frame,
+        int r0, int r1, int c0, int c1);
 
-//DELETE??
-/*Sets the copy array equal to the current state of the playing board*/
-//void update_copy(struct gol_data *data);
+/*plays every round with the HashLife engine instead of the threads*/
+void play_hashlife(struct gol_data *data);
 
-/* use updated data to set colors for visualization */
-void update_colors(struct gol_data *data);
+/*draws one ParaVisi frame (on the render thread)*/
+void visi_draw(struct gol_data *data, const unsigned char *frame);
 
-/*initialize board with starting cells*/
-void init_board(struct gol_data *data, FILE *file);
-
-void partition (struct gol_data *data);
 
 /**************************************************************/
 
@@ -122,9 +64,6 @@ int connect_animation(void (*applfunc)(struct gol_data *data),
 static char visi_name[] = "GOL!";
 
 
-/**************************************************************/
- static pthread_mutex_t mutex;
- static pthread_barrier_t barrier;
 
 
 /************************ Main Function ***********************/
@@ -135,14 +74,67 @@ int main(int argc, char **argv) {
     double secs;
     struct timeval start, stop;
     struct gol_data *targs;
+    struct gol_shared shared;
+    struct gol_data visi;
+    char rule[RULE_LEN];
     int ntids;
     pthread_t *tid;
+    TRACE_DECL(span);
     
 
     /* check number of command line arguments */
     if (argc < 6){
-        printf("usage: %s <infile.txt> <output_mode>[0|1|2]\n", argv[0]); // CHANGE ACCORDINGLY
+        printf("usage: %s <infile.txt> <output_mode>[0|1|2] "
+                "<num_threads> <partition>[0|1|2] <print_config>[0|1] "
+                "[-k scalar|packed|padded|lut|simd|avx2|avx512] [-a] "
+                "[-e auto|sparse|dense|hashlife] [-C cache_mb] "
+                "[-b ROWSxCOLS] [-i iters] [-t k|auto] [-c census] "
+                "[-T trace.json] [-N] [-B] [-r] [-s N:file] [-R rule] [-I] "
+                "[-D [R/]N:transport:addr] [-O file]\n",
+                argv[0]);
         printf("(0: no visualization, 1: ASCII, 2: ParaVisi)\n");
+        printf("partition: 0 rows, 1 columns, 2 L2-sized tiles\n");
+        printf("-k: board kernel (default scalar, packed: 64 cells/word, "
+                "padded: halo ring, no wrapping math, simd: padded with "
+                "the widest AVX kernel the CPU has, lut: padded in 2x2 "
+                "blocks from a 64K-entry table)\n");
+        printf("-a: skip %dx%d blocks that cannot change this round\n",
+                ACTIVE_BLOCK, ACTIVE_BLOCK);
+        printf("-e: sparse stores only the live cells (rows partition), "
+                "dense the -k board; auto (default) goes sparse below "
+                "1 live cell in %d\n", SPARSE_RATIO);
+        printf("   hashlife: memoized quadtree, one thread, jumps many "
+                "generations at once (-C: node cache MB, default %d)\n",
+                HASHLIFE_CACHE_MB);
+        printf("infile: lab format, RLE, .cells or Life 1.06; -b and -i "
+                "give the board size and iterations the file does not\n");
+        printf("-t: play k generations per sync in cache-sized tiles "
+                "(auto: k from the L2 size; output_mode 0 only)\n");
+        printf("-c: write population, births, deaths and bounding box "
+                "per generation (file.csv: CSV, otherwise binary)\n");
+        printf("-T: record per-thread compute/barrier/render spans as "
+                "Chrome trace JSON (needs make TRACE=1)\n");
+        printf("-N: pin threads by NUMA topology and place each share's "
+                "pages on its thread's node (first touch, huge pages)\n");
+        printf("-B: time each thread's rounds and move the partition "
+                "boundaries to even them out\n");
+        printf("-r: find boards that repeat (still lifes, oscillators, "
+                "empty boards) and skip the periods left\n");
+        printf("-s: save a binary checkpoint every N generations (and at "
+                "the end) in the background; give it as infile to "
+                "resume\n");
+        printf("-R: B/S rule, e.g. B36/S23 HighLife, B2/S Seeds, "
+                "B3678/S34678 Day & Night (default: the file's, or "
+                "B3/S23)\n");
+        printf("-I: one board updated in place (rows partition, int "
+                "boards; not with -a, -t, -c or -B)\n");
+        printf("-D: split the rows between N processes that exchange "
+                "boundary rows over unix:PATH, shm:NAME or "
+                "tcp:PORT[:host0,host1,...]; R/: run only rank R "
+                "(output_mode 0, rows partition)\n");
+        printf("-O: keep the board in file (a checkpoint) and stream it "
+                "through memory in bands, one pass per generation "
+                "(output_mode 0, rows partition)\n");
         exit(1);
     }
 
@@ -152,7 +144,7 @@ int main(int argc, char **argv) {
     
     //different command line arguments for visi library ()
 
-    ret = init_game_data_from_args(&data, argv);
+    ret = init_game_data_from_args(&data, &shared, argc, argv);
     if (ret != 0) {
         printf("Initialization error: file %s, mode %s\n", argv[1], argv[2]);
         exit(1);
@@ -160,22 +152,52 @@ int main(int argc, char **argv) {
     
     /* initialize ParaVisi animation (if applicable) */
     if (data.output_mode == OUTPUT_VISI) {
-        
-        setup_animation(&data);
+        // only the render thread calls draw_ready, so the animation is
+        // set up for one drawing thread
+        visi = data;
+        visi.threads = 1;
+        setup_animation(&visi);
+        data.handle = visi.handle;
+        data.image_buff = visi.image_buff;
+        data.draw_fn = visi_draw;
+    }
+
+    ntids = data.threads;
+
+    if (data.census_path != NULL
+            && census_open(&data, data.census_path,
+                shared.total_live) != 0) {
+        perror(data.census_path);
+        exit(1);
+    }
+    if (data.ckpt_path != NULL
+            && checkpoint_open(&data, data.ckpt_path, data.ckpt_every) != 0) {
+        perror("checkpoint writer");
+        exit(1);
+    }
+    if (data.trace_path != NULL && trace_setup(&data, data.trace_path) != 0) {
+        perror("malloc: trace");
+        exit(1);
     }
-
-    pthread_mutex_init(&mutex, NULL);
-    pthread_barrier_init(&barrier, NULL, data.threads);
-
-    ntids = atoi(argv[3]);
-    // make ntids a sane value if insane
-    if ((ntids < 1) || (ntids > 50)) { ntids = 10; }
 
     tid = malloc(sizeof(pthread_t) * ntids);
     if (!tid) { perror("malloc: pthread_t array"); exit(1); }
     //Malloc the array of the structs needed for parallelization
+    //(cache line aligned so no two threads' structs share a line)
 
-    targs = malloc (sizeof(struct gol_data)*ntids); 
+    targs = aligned_alloc(CACHE_LINE, sizeof(struct gol_data) * ntids);
+    if (!targs) { perror("malloc: gol_data array"); exit(1); }
+
+    /* ASCII output: clear screen & print the initial board */
+    if (data.output_mode == OUTPUT_ASCII) {
+        if (system("clear")) { perror("clear"); exit(1); }
+        print_board(&data, 0);
+    }
+    // the animated modes draw on a render thread (see render.c)
+    if (data.output_mode != OUTPUT_NONE && render_start(&data) != 0) {
+        perror("render thread");
+        exit(1);
+    }
 
     ret = gettimeofday(&start, NULL);
         //throw error if cant get the time
@@ -184,6 +206,14 @@ int main(int argc, char **argv) {
         exit(0);
     }
 
+    //HashLife runs by itself in this thread: no threads to start or join
+    if (data.engine == ENGINE_HASHLIFE){
+        TRACE_START(&data, span);
+        play_hashlife(&data);
+        TRACE_END(&data, TRACE_COMPUTE, span, 0);
+        ntids = 0;
+    }
+
     for (int i = 0; i < ntids; i++){
         targs[i] = data;
         targs[i].ntids = i;
@@ -195,14 +225,36 @@ int main(int argc, char **argv) {
     }
 
 
-    /* ASCII output: clear screen & print the initial board */
-    if (data.output_mode == OUTPUT_ASCII) {
-        if (system("clear")) { perror("clear"); exit(1); }
-        print_board(&data, 0);
+    // (ascii frames are drawn by the render thread, see render.c)
+    if (data.output_mode == OUTPUT_VISI) {  
+        // OUTPUT_VISI: run with ParaVisi animation
+        // tell ParaVisi that it should run play_gol
+        // connect_animation(play_gol, &data);
+        // start ParaVisi animation
+        run_animation(data.handle, data.iters);
+    } else if (data.output_mode != OUTPUT_NONE
+            && data.output_mode != OUTPUT_ASCII){
+        printf("Invalid output mode: %d\n", data.output_mode);
+        printf("Check your game data initialization\n");
+        exit(1);
     }
 
+    for (int i = 0; i < ntids; i++){
+        pthread_join(tid[i], 0);
+    }
+    render_stop(&data);
+    if (census_close(&data) != 0) {
+        perror(data.census_path);
+        exit(1);
+    }
+    ret = checkpoint_close(&data);
+    if (ret != 0) {
+        errno = ret;
+        perror(data.ckpt_path);
+        exit(1);
+    }
 
-    if (data.output_mode == OUTPUT_ASCII) { // run with ascii animation
+    if (data.output_mode == OUTPUT_ASCII) {
  
         // clear the previous print_board output from the terminal:
         // (NOTE: you can comment out this line while debugging)
@@ -211,30 +263,10 @@ int main(int argc, char **argv) {
         // NOTE: DO NOT modify this call to print_board at the end
         //       (it's to help us with grading your output)
 
+        sync_boards(&data);
         if (data.ntids == 0){
             print_board(&data, data.iters);
         }
-        
-        // for (int i = 0; i < ntids; i++){
-        //      pthread_join(tid[i], 0);
-        // }
-        
-
-    }
-    else if (data.output_mode == OUTPUT_VISI) {  
-        // OUTPUT_VISI: run with ParaVisi animation
-        // tell ParaVisi that it should run play_gol
-        // connect_animation(play_gol, &data);
-        // start ParaVisi animation
-        run_animation(data.handle, data.iters);
-    } else if (data.output_mode != OUTPUT_NONE){
-        printf("Invalid output mode: %d\n", data.output_mode);
-        printf("Check your game data initialization\n");
-        exit(1);
-    }
-
-    for (int i = 0; i < ntids; i++){
-        pthread_join(tid[i], 0);
     }
     
     ret = gettimeofday(&stop, NULL);
@@ -252,15 +284,37 @@ int main(int argc, char **argv) {
         /* Print the total runtime, in seconds. */
         // NOTE: do not modify these calls to fprintf
 
+        if (data.active) {
+            active_report(&data);
+        }
+        if (data.balance && data.print_config == 1) {
+            balance_report(&data);
+        }
+        cycle_report(&data);
+        checkpoint_report(&data);
+        if (shared.base_gen > 0) {
+            printf("Resumed at generation %ld, now at generation %ld\n",
+                    shared.base_gen, shared.base_gen + shared.round);
+        }
+        if (data.rule != RULE_LIFE) {
+            rule_format(data.rule, rule);
+            printf("Rule: %s\n", rule);
+        }
+        fprintf(stdout, "Kernel: %s\n", data.kernel_name);
         fprintf(stdout, "Total time: %0.3f seconds\n", secs);
         fprintf(stdout, "Number of live cells after %d rounds: %d\n\n",
-                data.iters, total_live);
+                data.iters, shared.total_live);
     }
 
 
 
-    free(data.gol_board);
-    free(data.next_board);
+    //(after the timing, so writing the trace does not count)
+    if (trace_finish(&data) != 0) {
+        perror(data.trace_path);
+        exit(1);
+    }
+
+    life_free(&data);
     free(targs);
     free(tid);
     targs = NULL;
@@ -278,23 +332,34 @@ int main(int argc, char **argv) {
  *       argv[1]: name of file to read game config state from
  *       argv[2]: run mode value
  * data: pointer to gol_data struct to initialize
+ * shared: the state the threads will share (set up by life_setup)
+ * argc: number of command line args
  * argv: command line args
  *       argv[1]: name of file to read game config state from
  *       argv[2]: run mode
+ *       argv[6...]: optional flags (see parse_options)
  * returns: 0 on success, 1 on error
  */
-int init_game_data_from_args(struct gol_data *data, char **argv) {
-    int ret, i;
-
-    FILE *infile; 
+int init_game_data_from_args(struct gol_data *data,
+        struct gol_shared *shared, int argc, char **argv) {
+    struct pattern pat;
+    int ret;
 
-    data->curr_iter = 0;
+    life_defaults(data);
 
     //Reads in each value from the file
 
     data->threads = atoi(argv[3]);
+    // make the thread count a sane value if insane
+    if ((data->threads < 1) || (data->threads > 50)) { data->threads = 10; }
     data->part_mode = atoi(argv[4]);
+    if (data->part_mode < 0 || data->part_mode > 2){
+        printf("ERROR: Invalid partition mode (0: rows, 1: cols, "
+                "2: tiles)\n");
+        exit(1);
+    }
     data->print_config = atoi(argv[5]);
+    parse_options(data, argc, argv);
 
     if(atoi(argv[2]) == 0){
         data->output_mode = OUTPUT_NONE;
@@ -310,544 +375,370 @@ int init_game_data_from_args(struct gol_data *data, char **argv) {
         printf("ERROR: Invalid Output Mode\n");
         exit(1);
     }
-    infile = fopen(argv[1], "r");
 
-    if (infile == NULL){
-        printf("Unable to open provided file");
+    //distributed mode: this process plays one band, or forks the ranks
+    if (data->dist_spec != NULL) {
+        if (data->output_mode != OUTPUT_NONE || data->part_mode != 0
+                || data->active || data->tb_k != 0 || data->cycle
+                || data->census_path != NULL || data->ckpt_path != NULL
+                || data->balance || data->numa || data->trace_path != NULL
+                || data->stream_path != NULL
+                || data->engine == ENGINE_SPARSE
+                || data->engine == ENGINE_HASHLIFE) {
+            printf("ERROR: -D needs output_mode 0, partition 0, the dense "
+                    "engine and none of -a -t -r -c -s -B -N -T -O\n");
+            exit(1);
+        }
+        exit(dist_main(data, argv[1]));
+    }
+    //out of core: the board is played through a file, not in memory
+    if (data->stream_path != NULL) {
+        if (data->output_mode != OUTPUT_NONE || data->part_mode != 0
+                || data->active || data->tb_k != 0 || data->cycle
+                || data->census_path != NULL || data->ckpt_path != NULL
+                || data->balance || data->numa || data->trace_path != NULL
+                || data->inplace || data->engine == ENGINE_SPARSE
+                || data->engine == ENGINE_HASHLIFE) {
+            printf("ERROR: -O needs output_mode 0, partition 0, the dense "
+                    "engine and none of -a -t -r -c -s -B -N -T -I\n");
+            exit(1);
+        }
+        exit(stream_main(data, argv[1]));
+    }
+    //read the whole input file (any of the formats load.c knows)
+    if (load_pattern(argv[1], data, &pat) != 0){
         exit(1);
     }
+    data->iters = pat.iters;
 
-   
-    ret = fscanf(infile, "%d", &data->rows);
-    if (ret == 0) {
-        printf("Improper file format.\n");
+    if (data->engine == ENGINE_HASHLIFE && data->output_mode == OUTPUT_VISI){
+        printf("ERROR: HashLife has no ParaVisi animation\n");
         exit(1);
     }
 
-
-    ret = fscanf(infile, "%d", &data->cols);
-    if (ret == 0) {
-        printf("Improper file format.\n");
+    //boards, engine and shared state (see life.c)
+    ret = life_setup(data, shared, &pat);
+    free_pattern(&pat);
+    if (ret == LIFE_ERR_ALLOC){
+        printf("Unable to initialize board\n");
         exit(1);
     }
-
-
-    ret = fscanf(infile, "%d", &data->iters);
-    if (ret == 0) {
-        printf("Improper file format.\n");
+    if (ret == LIFE_ERR_TILES){
+        printf("Unable to set up tiles\n");
         exit(1);
     }
-
-
-    ret = fscanf(infile, "%d", &total_live);
-    if (ret == 0) {
-        printf("Improper file format.\n");
+    if (ret == LIFE_ERR_NUMA){
+        printf("Unable to place the boards (-N)\n");
         exit(1);
     }
-
-    //allocating gol_board
-    data->gol_board = malloc(sizeof(int) * data->rows * data->cols);
-
-    if (data->gol_board == NULL){
-        printf("Unable to initialize board\n");
+    if (ret == LIFE_ERR_TBLOCK){
+        printf("ERROR: Invalid number of generations for -t\n");
         exit(1);
     }
-    for (i = 0; i< (data->rows * data->cols); i++){
-        //initialize as all zeroes
-        data->gol_board[i] = 0;
+    if (ret == LIFE_ERR_INPLACE){
+        printf("ERROR: -I needs partition 0, a scalar, padded, lut or "
+                "SIMD kernel and none of -a -t -c -B\n");
+        exit(1);
     }
-    //initialize STARTING board with cells
-    init_board(data, infile);
 
-    //Next board init with all zeroes
-    data->next_board = malloc(sizeof(int) * data->rows * data->cols);
-    if (data->next_board == NULL){
-        printf("Unable to initialize board\n");
+    //temporal blocking only produces the final board
+    if (data->tb_k != 0
+            && (data->output_mode != OUTPUT_NONE || data->active)){
+        printf("ERROR: -t needs output_mode 0 and no -a\n");
         exit(1);
     }
-    for (i = 0; i< (data->rows * data->cols); i++){
-        //initialize as all zeroes
-        data->next_board[i] = 0;
+    //and -r hashes every generation
+    if (data->tb_k != 0 && data->cycle){
+        printf("ERROR: -r does not work with -t\n");
+        exit(1);
     }
-    
-    
-    return 0;
-}
 
-//Function that takes in each struct and changes
-//their start and stop members based on their thread ID 
-
-void partition (struct gol_data *data){
-    
-    int alloc; // the partitioned number of row/col
-    int remainder; // number of row/col that needs to be reassigned
-    int count;
-
-    //partition for horizontal 
-    if (data->part_mode == 0){
-        alloc = (data->rows / data->threads);
-        remainder = (data->rows % data->threads);
-        count = remainder - data->ntids;
-
-        if (count > 0){
-            data->start = (alloc + 1) * data->ntids;
-            data->end = data->start + alloc;
-        }
-        else if (count == 0){
-            data->start = (alloc + 1) * data->ntids;
-            data->end = data->start + alloc - 1;
-        }
-        else {
-            data->start = data->ntids * alloc + remainder;
-            data->end = data->start + alloc - 1;
-        }
+    //HashLife has no boards to save between its jumps
+    if (data->ckpt_path != NULL && data->engine == ENGINE_HASHLIFE){
+        printf("ERROR: -s does not work with HashLife\n");
+        exit(1);
     }
-    //partition for vertical
-    if (data->part_mode == 1){
-        alloc = (data->cols / data->threads);
-        remainder = (data->cols % data->threads);
-        count = remainder - data->ntids;
 
-        if (count > 0){
-            data->start = (alloc + 1) * data->ntids;
-            data->end = data->start + alloc;
-        }
-        else if (count == 0){
-            data->start = (alloc + 1) * data->ntids;
-            data->end = data->start + alloc - 1;
-        }
-        else {
-            data->start = data->ntids * alloc + remainder;
-            data->end = data->start + alloc - 1;
-        }
+    //the census needs every generation of the threads' boards (and
+    //both of them: the births and deaths are the cells that differ)
+    if (data->census_path != NULL && (data->tb_k != 0 || data->cycle
+                || data->inplace || data->engine == ENGINE_HASHLIFE)){
+        printf("ERROR: -c does not work with -t, -r, -I or HashLife\n");
+        exit(1);
     }
-    return;
+
+    return 0;
 }
 
 /*
-* Scans in cell data from an input file and populates the board
-* data -> pointer to gol_data struct
-* file -> input file
+Parses the optional flags given after the five positional arguments
+    data-> The struct containing information for the game
+    argc -> number of command line args
+    argv -> command line args
+       -k scalar|packed|padded|lut|simd|avx2|avx512: board
+          representation/kernel used by play_round. simd, avx2 and avx512
+          use the padded board with an explicit SIMD row kernel (simd:
+          chosen by CPUID); lut plays the padded board in 2x2 blocks from
+          a lookup table (see lut.c).
+       -a: track which blocks changed and skip the ones that cannot
+          change this round (see active.c).
+       -e auto|sparse|dense: sparse stores only the live cells (see
+          sparse.c), dense uses the -k board; auto picks sparse when
+          there is less than one live cell per SPARSE_RATIO cells.
+          hashlife runs the HashLife engine (see hashlife.c) instead of
+          the threads.
+       -C cache_mb: memory for the HashLife node cache.
+       -b ROWSxCOLS, -i iters: board size and number of iterations, for
+          file formats that do not give them (they override the file's).
+       -t k|auto: temporal blocking, k generations per barrier (see
+          tblock.c); auto picks k from the L2 cache size.
+       -c file: per-generation census (see census.c), CSV if the file
+          name ends in .csv, otherwise binary.
+       -T file: write a Chrome trace of every thread's spans (see
+          trace.c); only in a build with GOL_TRACE.
+       -N: NUMA placement: pinned threads, boards first touched by the
+          thread that plays them (see numa.c).
+       -B: load balancing, the partition follows measured compute time
+          (see balance.c).
+       -r: repeat detection, skip ahead once the board repeats (see
+          cycle.c).
+       -s N:file: write a binary checkpoint of the board to file every N
+          generations and at the end, from a background thread (see
+          checkpoint.c); the file is an input that resumes the run.
+       -R rule: the B/S rule to play (see rule.c), instead of the one in
+          the input file or B3/S23.
+       -I: in-place stepping, one int board instead of two, with
+          rolling row buffers per thread (see inplace.c).
+       -D [R/]N:transport:addr: distributed mode (see dist.c), the rows
+          split between N processes that exchange their boundary rows
+          over unix:PATH, shm:NAME or tcp:PORT[:hosts]; with R/ this
+          process is rank R, otherwise it forks all N locally.
+       -O file: out of core (see stream.c), the board is kept in file (a
+          packed checkpoint) and streamed through memory in bands, one
+          pass per generation, by the given number of threads.
 */
-void init_board(struct gol_data *data, FILE *file){
-    int ret, i, j, row, col;
-
-    for (int n = 0; n < total_live; n++){
-
-        ret = fscanf(file, "%d%d", &row, &col);
-        if (ret == 0) {
-        printf("Improper file format.\n");
-        exit(1);
-        }
-
-        if ((row > data->rows - 1) | (col > data->cols - 1 )){
-            printf("One or more cells in the input file are out of range.\n");
-            exit(1);
-        }
-        
-        //initializing board with file data
-        for (i=0; i<data->rows; i++){
-            for (j=0; j<data->cols; j++){
-                //condition for adding a cell
-                if ((i == row) && (j == col)){
-                    data->gol_board[i * data->cols + j] = 1;
+void parse_options(struct gol_data *data, int argc, char **argv) {
+    int opt, ret;
+
+    optind = 6;
+    while ((opt = getopt(argc, argv, "k:ae:C:b:i:t:c:T:NBrs:R:ID:O:"))
+            != -1) {
+        switch (opt) {
+        case 'k':
+            ret = life_kernel(data, optarg);
+            if (ret == 1) {
+                printf("ERROR: Invalid kernel %s\n", optarg);
+                exit(1);
+            }
+            if (ret == 2) {
+                printf("ERROR: This CPU does not support %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'a':
+            data->active = 1;
+            break;
+        case 'e':
+            if (strcmp(optarg, "auto") == 0) {
+                data->engine = ENGINE_AUTO;
+            } else if (strcmp(optarg, "sparse") == 0) {
+                data->engine = ENGINE_SPARSE;
+            } else if (strcmp(optarg, "dense") == 0) {
+                data->engine = ENGINE_DENSE;
+            } else if (strcmp(optarg, "hashlife") == 0) {
+                data->engine = ENGINE_HASHLIFE;
+            } else {
+                printf("ERROR: Invalid engine %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'b':
+            if (sscanf(optarg, "%dx%d", &data->opt_rows, &data->opt_cols)
+                    != 2 || data->opt_rows < 1 || data->opt_cols < 1) {
+                printf("ERROR: Invalid board size %s (use ROWSxCOLS)\n",
+                        optarg);
+                exit(1);
+            }
+            break;
+        case 'i':
+            data->opt_iters = atoi(optarg);
+            if (data->opt_iters < 0) {
+                printf("ERROR: Invalid number of iterations %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 't':
+            if (strcmp(optarg, "auto") == 0) {
+                data->tb_k = -1;
+            } else {
+                data->tb_k = atoi(optarg);
+                if (data->tb_k < 1) {
+                    printf("ERROR: Invalid number of generations %s\n",
+                            optarg);
+                    exit(1);
                 }
             }
-        }
-
-    }
-
-}
-/**************************************************************/
-
-/* the gol application main loop function:
- *  runs rounds of GOL,
- *    * updates program state for next round (world and total_live)
- *    * performs any animation step based on the output/run mode
- *
- *   data: pointer to a struct gol_data  initialized with
- *         all GOL game playing state
- */
-void* play_gol(void * arg) {
-    //  at the end of each round of GOL, determine if there is an
-    //  animation step to take based on the output_mode,
-    //   if ascii animation:
-    //     (a) call system("clear") to clear previous world state from terminal
-    //     (b) call print_board function to print current world state
-    //     (c) call usleep(SLEEP_USECS) to slow down the animation
-    //   if ParaVis animation:
-    //     (a) call your function to update the color3 buffer
-    //     (b) call draw_ready(data->handle)
-    //     (c) call usleep(SLEEP_USECS) to slow down the animation
-    int * temp; 
-    int diff;
-  
-    struct gol_data *data = ((struct gol_data *)arg);
-    
-    pthread_mutex_lock(&mutex);
-    //buffer for printing row/col data
-    diff = data->end - data->start + 1;
-
-
-    printf("Thread ID %d \n", data->ntids);
-
-    if (data->print_config == 1){
-        if (data->part_mode == 0){
-
-            
-            printf("ntid %d:  ", data->ntids);
-            printf("rows: %d:%d (%d)  ", data->start, data->end, diff);
-            printf("cols: 0:%d (%d) \n", data->cols - 1, data->cols);
-            
-        }
-        if (data->part_mode == 1){
-
-    
-            printf("ntid %d:  ", data->ntids);
-            printf("rows: 0:%d (%d) ", data->rows - 1, data->rows);
-            printf("cols: %d:%d (%d) \n", data->start, data->end, diff);
-
-        }
-    }
-
-    pthread_mutex_unlock(&mutex);
-
-    //no output
-    if (data->output_mode == OUTPUT_NONE){
-            
-            
-            for(int i=0; i<data->iters; i++){
-
-
-                pthread_barrier_wait(&barrier);
-                //play one round
-                play_round(data);
-                pthread_barrier_wait(&barrier);
-                //BARRIER/
-
-
-                //switch pointers (no need for copy function)
-                temp = data->gol_board;
-                data->gol_board = data->next_board;
-                data->next_board = temp;
-                
-
+            break;
+        case 'c':
+            data->census_path = optarg;
+            break;
+        case 'N':
+            data->numa = 1;
+            break;
+        case 'B':
+            data->balance = 1;
+            break;
+        case 'r':
+            data->cycle = 1;
+            break;
+        case 's':
+            ret = -1;
+            if (sscanf(optarg, "%d:%n", &data->ckpt_every, &ret) != 1
+                    || ret < 0 || data->ckpt_every < 1
+                    || optarg[ret] == '\0') {
+                printf("ERROR: Invalid checkpoint %s (use N:file)\n",
+                        optarg);
+                exit(1);
             }
-        
-    }
-
-    //output with visi
-    else if (data->output_mode == OUTPUT_VISI){
-
-        for (int i = 0; i < data->iters; i++ ) {  /* run some number of iters */
-
-  
-        
-            pthread_barrier_wait(&barrier);
-            //play one round
-            play_round(data);
-            pthread_barrier_wait(&barrier);
-
-        
-    
-        /* when we're all done updating our grid, update the visualization */
-        update_colors(data);
-        draw_ready(data->handle);
-
-        temp = data->gol_board;
-        data->gol_board = data->next_board;
-        data->next_board = temp;
-
-        usleep(100000);
-    }   
-    }
-
-    //with asciimation
-    else if (data->output_mode == OUTPUT_ASCII){
-       
-            
-        for(int i=0; i<data->iters; i++){
-            
-            //initial board
-
-            system("clear");
-            
-            if(data->ntids == 0){
-                print_board(data, i);
+            data->ckpt_path = optarg + ret;
+            break;
+        case 'R':
+            if (rule_parse(optarg, &data->rule) != 0) {
+                printf("ERROR: Invalid rule %s (use B/S, e.g. B36/S23; "
+                        "no B0)\n", optarg);
+                exit(1);
             }
-           
-
-       
-            pthread_barrier_wait(&barrier);
-
-            play_round(data);
-
-            pthread_barrier_wait(&barrier);
-           
-
-            usleep(100000);
-
-            temp = data->gol_board;
-            data->gol_board = data->next_board;
-            data->next_board = temp;
-            
+            data->opt_rule = optarg;
+            break;
+        case 'I':
+            data->inplace = 1;
+            break;
+        case 'D':
+            if (dist_check(optarg) != 0) {
+                printf("ERROR: Invalid -D %s (use [R/]N:unix:PATH, "
+                        "N:shm:NAME or N:tcp:PORT[:hosts])\n", optarg);
+                exit(1);
+            }
+            data->dist_spec = optarg;
+            break;
+        case 'O':
+            data->stream_path = optarg;
+            break;
+        case 'T':
+#ifdef GOL_TRACE
+            data->trace_path = optarg;
+#else
+            printf("ERROR: -T needs a tracing build (make TRACE=1)\n");
+            exit(1);
+#endif
+            break;
+        case 'C':
+            data->cache_mb = atol(optarg);
+            if (data->cache_mb < 1) {
+                printf("ERROR: Invalid cache size %s\n", optarg);
+                exit(1);
+            }
+            break;
+        default:
+            exit(1);
         }
-
     }
-   return 0; 
-    
 }
 
-/*
-Gets the neighbor counts for every cell using the helper function count_neighbors
-and then sets the value of each cell accordingly. To keep every cell 
-independent, it checks the neighbors of a copy of the originial board
-from the beginning of the round. 
-    data-> The struct containing information for the game 
-    copy-> a copy of the playing board from the beginning of the round
-*/
-void play_round(struct gol_data *data){
-    int neighbors;
-    int live = 0;
-    
-    if(data->part_mode == 0){
-        for (int i=data->start; i<=data->end; i++){
-            for (int j=0; j<data->cols; j++){
-
-                
-                //for dead cell
-                if (data->gol_board[i * data->cols + j] == 0){
-                    neighbors = count_neighbors( data, i, j);
-
-                    if (neighbors == 3){
-                        data->next_board[i * data->cols + j] = 1;
-
-                        live += 1; 
-                    }
-
-                    else {
-                        data->next_board[i * data->cols + j] = 0;
-                    }
-                }
-                
-                
-                    //living cell
-                else if (data->gol_board[i * data->cols + j] == 1){
-
-                    neighbors = count_neighbors( data, i, j);
-
-                    if ((neighbors == 2) || (neighbors == 3)){
-                        //the cell stays alive
-                        data->next_board[i * data->cols + j] = 1;
-                    }
+/**************************************************************/
 
 
-                    else{
-                        //the alive cell dies
-                        data->next_board[i * data->cols + j] = 0;
-                        live -= 1;
-                    }
-                    
-                }
-            }
-        }
+/*
+Plays all the rounds with the HashLife engine (instead of the threads).
+With ascii animation it steps one generation at a time and offers each
+to the render thread (see render.c); otherwise it jumps all data->iters
+generations at once. The result goes back into the
+sparse board so print_board and the live count work as usual.
+    data-> The struct containing information for the game
+*/
+void play_hashlife(struct gol_data *data){
+    struct hashlife *h;
 
+    h = hashlife_create(data, data->cache_mb);
+    if (h == NULL){
+        perror("malloc: hashlife");
+        exit(1);
     }
-    
-
-    if(data->part_mode == 1 ){
-        for (int i=0; i<data->rows; i++){
-            for (int j=data->start; j<=data->end; j++){
-
-                
-                //for dead cell
-                if (data->gol_board[i * data->cols + j] == 0){
-                    neighbors = count_neighbors( data, i, j);
-
-                    if (neighbors == 3){
-                        data->next_board[i * data->cols + j] = 1;
-
-                        live += 1; 
-                    }
-
-                    else {
-                        data->next_board[i * data->cols + j] = 0;
-                    }
-                }
-                
-                
-                    //living cell
-                else if (data->gol_board[i * data->cols + j] == 1){
-
-                    neighbors = count_neighbors( data, i, j);
-
-                    if ((neighbors == 2) || (neighbors == 3)){
-                        //the cell stays alive
-                        data->next_board[i * data->cols + j] = 1;
-                    }
-
 
-                    else{
-                        //the alive cell dies
-                        data->next_board[i * data->cols + j] = 0;
-                        live -= 1;
-                    }
-                    
-                }
-            }
+    //one generation at a time, each offered to the render thread
+    if (data->output_mode == OUTPUT_ASCII){
+        for (int i = 0; i < data->iters; i++){
+            hashlife_step(h, 1);
+            hashlife_read(h, data);
+            render_board(data, i + 1);
         }
-
+    } else {
+        hashlife_step(h, data->iters);
+        hashlife_read(h, data);
     }
-    
 
-    pthread_mutex_lock(&mutex);
-    total_live += live;
-    pthread_mutex_unlock(&mutex);
+    data->shared->total_live = data->sparse_board->n;
+    if (data->print_config == 1){
+        hashlife_report(h);
+    }
+    hashlife_destroy(h);
 }
 
 
 
 
-
-
 /*
-counts how many of a cell's neighbors are alive using addition
-    data-> The struct containing information for the game 
-    copy-> a copy of the playing board from the beginning of the round
-    i -> the row data of the cell whos neighbor is being counted
-    j -> the column data of said cell
+Draws one frame of the ParaVisi animation: called by the render thread
+(data->draw_fn) with the newest frame the threads filled in
+    data-> The struct containing information for the game
+    frame -> the frame (see render.c)
 */
-int count_neighbors( struct gol_data *data, int i, int j) {
-    int count = 0;
-    
-    // Top row neighbors
-
-
-    count = data->gol_board[(((i-1) + data->rows)  % data->rows) * data->cols + (((j-1)+ data->cols) % data->cols)] +  // Top left
-            data->gol_board[(((i-1)+ data->rows) % data->rows) * data->cols + ((j + data->cols) % data->cols)] +                       // Top center
-            data->gol_board[(((i-1)+ data->rows) % data->rows) * data->cols + (((j+1)+ data->cols) % data->cols)] +   // Top right
-            
-            // Middle row neighbors
-            data->gol_board[((i+ data->rows) % data->rows) * data->cols + (((j-1)+ data->cols) % data->cols)] +       // Middle left
-            data->gol_board[((i+ data->rows) % data->rows) * data->cols + (((j+1)+ data->cols) % data->cols)] +       // Middle right
-            
-            // Bottom row neighbors
-            data->gol_board[(((i+1)+ data->rows) % data->rows) * data->cols + (((j-1)+ data->cols) % data->cols)] +   // Bottom left
-            data->gol_board[(((i+1)+ data->rows) % data->rows) * data->cols + ((j + data->cols) % data->cols)] +                    // Bottom center
-            data->gol_board[(((i+1)+ data->rows) % data->rows) * data->cols + (((j+1)+ data->cols) % data->cols)];    // Bottom right
-    
-
+void visi_draw(struct gol_data *data, const unsigned char *frame) {
 
-    return count;
+    update_colors(data, frame);
+    draw_ready(data->handle);
 }
 
-/*  
-Sets all of the values in the copy array equal to the playing board
-    data-> The struct containing information for the game 
-    copy-> a copy of the playing board from the beginning of the round
- */
-void update_copy(struct gol_data *data){
-    
-    for (int i=0; i<data->rows; i++){
-            for (int j=0; j<data->cols; j++){
-                //copy over all values
-                data->next_board[i * data->cols + j] = data->gol_board[i * data->cols + j];
-            }
-        }
-        
-   
-};
-
-/**************************************************************/
-
-/* Print the board to the terminal.
- *   data: gol game specific data
- *   round: the current round number
- * NOTE: You may add extra printfs if you'd like, but please
- *       leave these fprintf calls exactly as they are to make
- *       grading easier!
+/* Describes how the pixels in the image buffer should be
+ * colored based on the data in a render frame.
+ (Take this for the main function)
  */
-void print_board(struct gol_data *data, int round) {
-
-    int i, j;
-
-    /* Print the round number. */
-    fprintf(stderr, "Round: %d\n", round);
-
-    for (i = 0; i < data->rows; ++i) {
-        for (j = 0; j < data->cols; ++j) {
-            if (data->gol_board[i * data->cols + j] == 1){
-                fprintf(stderr, " @");
-            }
-            else {
-                fprintf(stderr, " .");
-            }
-          
-          
-        }
-        fprintf(stderr, "\n");
-    }
+void update_colors(struct gol_data *data, const unsigned char *frame) {
 
-    /* Print the total number of live cells. */
-    fprintf(stderr, "Live cells: %d\n\n", total_live);
+    color_region(data, frame, 0, data->rows - 1, 0, data->cols - 1);
 }
 
-
-
-/* Describes how the pixels in the image buffer should be
- * colored based on the data in the grid.
- (Take this for the main function)
+/* Colors the pixels for rows r0..r1, cols c0..c1: live cells black and
+ * dead cells in the color of the thread that played them.
+ *   data: gol game specific data
+ *   frame: the render frame (RENDER_LIVE or the thread id per cell)
+ *   r0, r1: the first and last row
+ *   c0, c1: the first and last column
  */
-void update_colors(struct gol_data *data) {
+void color_region(struct gol_data *data, const unsigned char *frame,
+        int r0, int r1, int c0, int c1) {
 
-    int i, j, r, c, index, buff_i;
-    int start, end;
+    int i, j, r, c, buff_i;
     color3 *buff;
 
     buff = data->image_buff;  // just for readability
     r = data->rows;
     c = data->cols;
-    start = data->start;
-    end = data->end;
-    if(data->part_mode == 0){
-        for (i = start; i <= end; i++) {
-            for (j = 0; j < c; j++) {
-                index = i*c + j;
-                // translate row index to y-coordinate value because in
-                // the image buffer, (r,c)=(0,0) is the _lower_ left but
-                // in the grid, (r,c)=(0,0) is _upper_ left.
-                buff_i = (r - (i+1))*c + j;
-
-                // update animation buffer
-                if (data->gol_board[index] == 1) {
-                    buff[buff_i] = c3_black;  // set live cells to black
-                } else {
-                    buff[buff_i] = colors[((data->ntids)%8)]; // dead to my tid color
-                } 
-            }
+    for (i = r0; i <= r1; i++) {
+        for (j = c0; j <= c1; j++) {
+            // translate row index to y-coordinate value because in
+            // the image buffer, (r,c)=(0,0) is the _lower_ left but
+            // in the grid, (r,c)=(0,0) is _upper_ left.
+            buff_i = (r - (i+1))*c + j;
+
+            // update animation buffer
+            if (frame[(size_t)i * c + j] == RENDER_LIVE) {
+                buff[buff_i] = c3_black;  // set live cells to black
+            } else {
+                buff[buff_i] = colors[frame[(size_t)i * c + j] % 8];
+            } 
         }
     }
-
-    if(data->part_mode == 1){
-        for (i = 0; i < r; i++) {
-            for (j = start; j <= end; j++) {
-                index = i*c + j;
-                // translate row index to y-coordinate value because in
-                // the image buffer, (r,c)=(0,0) is the _lower_ left but
-                // in the grid, (r,c)=(0,0) is _upper_ left.
-                buff_i = (r - (i+1))*c + j;
-
-                // update animation buffer
-                if (data->gol_board[index] == 1) {
-                    buff[buff_i] = c3_black;  // set live cells to black
-                } else {
-                    buff[buff_i] = colors[((data->ntids)%8)]; // dead to my tid color
-                } 
-            }
-        }
-    }
-
-
 }
 
 
@@ -0,0 +1,458 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Shared definitions for the Game of Life program: the gol_data struct that
+every thread gets a copy of, the run/kernel modes, and the prototypes of
+functions that live outside of gol.c.
+*/
+#ifndef __GOL_H__
+#define __GOL_H__
+
+#ifdef GOL_NO_VISI
+/* gol_bench is built without ParaVis: its two fields in gol_data are
+ * only pointers, so opaque types keep the struct the same */
+typedef struct visi_struct *visi_handle;
+typedef struct color3_struct color3;
+#else
+#include <pthreadGridVisi.h>
+#endif
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "barrier.h"
+#include "trace.h"
+
+/****************** Definitions **********************/
+/* Three possible modes in which the GOL simulation can run */
+#define OUTPUT_NONE   (0)   // with no animation
+#define OUTPUT_ASCII  (1)   // with ascii animation
+#define OUTPUT_VISI   (2)   // with ParaVis animation
+
+/* Board representations play_round can step (chosen with -k) */
+#define KERNEL_SCALAR (0)   // one int per cell, count_neighbors per cell
+#define KERNEL_PACKED (1)   // 64 cells per uint64_t, bitwise adder kernel
+#define KERNEL_PADDED (2)   // ints with a halo ring, branch-free stencil
+#define KERNEL_SPARSE (3)   // sorted list of live cells only (see -e)
+
+/* How the board representation is picked (-e) */
+#define ENGINE_AUTO   (0)   // sparse when the board is almost empty
+#define ENGINE_DENSE  (1)   // always the -k kernel
+#define ENGINE_SPARSE (2)   // always the sparse engine
+#define ENGINE_HASHLIFE (3) // memoized quadtree, one thread (hashlife.c)
+
+/* The time between two frames of the animation run modes (the render
+ * thread draws at most one frame per SLEEP_USECS; the game does not wait)
+ * Change this value to make the animation run faster or slower
+ */
+//#define SLEEP_USECS  (1000000)
+#define SLEEP_USECS    (100000)
+
+/* Life-like rules (see rule.c): bit n of the mask is birth with n live
+ * neighbors, bit 9 + n survival with n neighbors */
+#define RULE_LIFE     (0x1808u)   // B3/S23, Conway's Game of Life
+#define RULE_HIGHLIFE (0x1848u)   // B36/S23
+#define RULE_SEEDS    (0x0004u)   // B2/S
+#define RULE_DAYNIGHT (0x3b1c8u)  // B3678/S34678
+#define RULE_LEN      (24)        // room for the longest rulestring
+#define RULE_BORN(rule, n)  (((rule) >> (n)) & 1)
+#define RULE_STAYS(rule, n) (((rule) >> (9 + (n))) & 1)
+// next state of a cell (alive: 0 or 1) with n live neighbors
+#define RULE_NEXT(rule, alive, n) (((rule) >> ((n) + 9 * (alive))) & 1)
+
+/* a live cell in a render frame (other values: the thread that played a
+ * dead cell, see render.c) */
+#define RENDER_LIVE   (255)
+
+/* default size of the HashLife node cache in MB (-C) */
+#define HASHLIFE_CACHE_MB (256)
+
+/* auto picks the sparse engine below one live cell per this many cells */
+#define SPARSE_RATIO  (4096)
+
+/* first bytes of a checkpoint file (-s, see checkpoint.c) */
+#define CHECKPOINT_MAGIC "GOLCKPT1"
+#define CHECKPOINT_HEAD (64) // bytes of header before the board
+
+/* life_setup errors */
+#define LIFE_ERR_ALLOC  (1) // out of memory
+#define LIFE_ERR_TILES  (2) // tile_setup failed (part_mode 2)
+#define LIFE_ERR_NUMA   (3) // -N placement failed
+#define LIFE_ERR_TBLOCK (4) // -t k is too big
+#define LIFE_ERR_INPLACE (5) // -I with a board or mode it cannot update
+
+/* side, in cells, of the blocks whose activity -a tracks (a multiple of
+ * 64 so a block is whole words of a packed board) */
+#define ACTIVE_BLOCK (64)
+
+/* the most rounds whose active block counts -a keeps for its report (the
+ * first ones, so a long run does not size the counts by its length) */
+#define ACTIVE_MAX_ROUNDS (1 << 16)
+
+/* steps one contiguous run of n cells of a padded board (up/mid/down are
+ * the rows above, at and below the run); returns the live cell change */
+typedef int (*row_kernel_fn)(const int *up, const int *mid,
+        const int *down, int *out, int n, unsigned rule);
+
+/* The live cells of one generation for the sparse engine, as keys
+ * (row * cols + col) in increasing order */
+struct sparse_set {
+    uint64_t *cells; // the keys
+    long n; // number of live cells
+    long cap; // space in cells
+};
+
+/* A parsed input file (see load.c): the board it asks for and its live
+ * cells, already placed on that board */
+struct pattern {
+    int rows, cols; // board size
+    int iters; // number of iterations
+    int live; // live cell count to report (the header's, for lab files)
+    long *cells; // row, col of every live cell
+    long ncells; // number of cells in cells
+    long cap; // space in cells (in cells, not longs)
+    long height, width; // the pattern's own size (not lab files)
+    char rule[32]; // rule from an RLE header, or ""
+    long generation; // checkpoints: generation of the board (else 0)
+    long target; // checkpoints: the generation its run was playing to
+    const char *snap_cells; // checkpoints: the board as stored in the
+                            // file (see checkpoint.c), or NULL
+    int snap_keys; // 1: snap_cells holds keys, 0: rows of bits
+    void *store; // memory snap_cells points into, freed by free_pattern
+    size_t store_len; // its length if it is mapped (0: malloc'd)
+};
+
+/* What one thread counted in the round it just played, in its own cache
+ * line; end_round adds the threads' counts up with no lock */
+struct census_counts {
+    long live; // change in the number of live cells
+    long births, deaths; // census (-c): cells born and cells that died
+    int min_r, max_r, min_c, max_c; // census: box of the live cells
+    long ns; // -B: nanoseconds spent playing the round
+    uint64_t hash; // -r: hash of this thread's share of the new board
+} __attribute__((aligned(CACHE_LINE)));
+
+/* State shared by all the threads of one simulation (each thread's
+ * gol_data points at the same one). The boards are double buffered and
+ * cur says which buffer holds the current generation; the last thread to
+ * reach the end-of-round barrier flips it once for everybody.
+ */
+struct gol_shared {
+    struct spin_barrier barrier; // the one barrier per generation
+    int *boards[2]; // int boards (scalar and padded kernels)
+    uint64_t *packed[2]; // packed boards (packed kernel)
+    struct sparse_set *sparse[2]; // live cell lists (sparse engine)
+    struct sparse_thread *sparse_threads; // per-thread counts and results
+    int cur; // index of the current generation in boards/packed
+    int round; // number of rounds completed
+    int stop; // round at which this run of play_gol ends (start_loop)
+    int total_live; // live cells on the current board
+    pthread_mutex_t print_lock; // one thread's print_config at a time
+
+    // active-block tracking (-a, see active.c)
+    int blocks_y, blocks_x; // dimensions of the block grid
+    int *changed; // per block: last round in which a cell of it changed
+    int *active_counts; // per round: number of blocks that were played
+                        // (the first ACTIVE_MAX_ROUNDS rounds)
+
+    struct census_counts *counts; // per thread, reduced by end_round
+    FILE *census; // per-generation census output (-c), or NULL
+    int census_csv; // 1: census is CSV, 0: binary (see census.c)
+
+    struct trace_thread *trace; // per-thread spans (-T), or NULL
+    const char *trace_path; // where the trace goes
+    uint64_t trace_t0; // trace_now() when the trace started
+    int trace_rounds; // generations recorded (at most TRACE_MAX_ROUNDS)
+
+    // trace_now() as the first round starts and as the last one ends
+    uint64_t loop_start, loop_end;
+
+    // load balancing (-B, see balance.c)
+    int *cuts; // thread t plays units cuts[t]..cuts[t + 1] - 1, or NULL
+    int *bal_next; // room for the new cuts while they are worked out
+    long *bal_ns; // per thread: compute time in the current window
+    int bal_rounds; // rounds measured in the current window
+    int rebalances; // number of times the cuts moved
+
+    // repeat detection (-r, see cycle.c)
+    struct cycle *cycle; // hashes and snapshot, or NULL
+    long period; // period the board repeats with (0: none found yet,
+                 // -1: gave up)
+
+    // checkpoints (-s, see checkpoint.c)
+    struct checkpoint *ckpt; // the writer and its buffer, or NULL
+    long base_gen; // generation of the input board (round 0)
+
+    // in-place stepping (-I, see inplace.c): every thread's first and
+    // last rows, the set shared->cur old and the other one new
+    int *edges;
+
+    // animation (output modes 1 and 2, see render.c)
+    struct render *render; // frames and render thread, or NULL
+};
+
+/* This struct represents all the data you need to keep track of your GOL
+ * simulation.  Rather than passing individual arguments into each function,
+ * we'll pass in everything in just one of these structs.
+ * this is passed to play_gol, the main gol playing loop
+ *
+ * NOTE: You will need to use the provided fields here, but you'll also
+ *       need to add additional fields. (note the nice field comments!)
+ * NOTE: DO NOT CHANGE THE NAME OF THIS STRUCT!!!!
+ */
+struct gol_data {
+
+    // NOTE: DO NOT CHANGE the names of these 4 fields (but USE them)
+    int curr_iter; //for visi
+    int rows;  // the row dimension
+    int cols;  // the column dimension
+    int iters; // number of iterations to run the gol simulation
+    int output_mode; // set to:  OUTPUT_NONE, OUTPUT_ASCII, or OUTPUT_VISI
+    int* gol_board; //represents the current board (base next round on this)
+    int *next_board; //the next board to play
+    int threads; //number of threads the user determines
+    int ntids; // the identifier for which thread is running
+    int part_mode; // A 0/1/2 flag to specify how to parallelize the GOL program
+    //(0: row-wise grid cell allocation, 1: column-wise grid cell allocation,
+    // 2: L2-sized tiles, start/end are then positions in tile_order)
+    int print_config; // A 0/1 flag to specify should the per-thread board
+    // allocation be printed
+    int start; // the starting col/row for each thread to run
+    int end; // the ending col/row for each thread to run
+
+    int kernel; // board representation: one of the KERNEL_* values
+    int words; // uint64_t words per row of a packed board
+    uint64_t *packed_board; // current board, 64 cells per word (packed)
+    uint64_t *packed_next; // the next packed board to play
+    struct sparse_set *sparse_board; // current live cells (sparse engine)
+    struct sparse_set *sparse_next; // the next generation's live cells
+    int engine; // one of the ENGINE_* values (-e)
+    long cache_mb; // HashLife node cache size in MB (-C)
+    int opt_rows, opt_cols; // board size from -b (0: from the file)
+    int opt_iters; // iterations from -i (-1: from the file)
+    unsigned rule; // the B/S rule as a mask (see rule.c)
+    const char *opt_rule; // rule from -R (NULL: the file's, or B3/S23)
+    const char *dist_spec; // distributed mode spec (-D), or NULL
+    const char *stream_path; // out-of-core board file (-O), or NULL
+    row_kernel_fn row_fn; // padded row kernel (portable loop or SIMD)
+    int lut; // 1: padded board played in 2x2 blocks from a table (-k lut)
+    const char *kernel_name; // kernel reported in the run summary
+    int active; // 1: skip blocks that cannot change (-a)
+    int tb_k; // generations per sync with temporal blocking (-t, 0: off)
+    int tb_tile; // side of a temporal blocking tile, in cells
+    int tb_steps; // generations in the block being played (<= tb_k)
+    int *tb_buf[2]; // this thread's tile buffers (see tblock.c)
+    size_t tb_cap; // size of each tile buffer, in cells
+    const char *census_path; // census file (-c), or NULL
+    const char *trace_path; // Chrome trace file (-T), or NULL
+    int numa; // 1: first-touch boards and pinned threads (-N)
+    int *cpus; // CPU of each thread with -N (shared), or NULL
+    // draws a render frame for ParaVisi (NULL: ascii frames)
+    void (*draw_fn)(struct gol_data *data, const unsigned char *frame);
+    int quiet; // 1: no "Thread ID" line per thread (gol_bench)
+    int balance; // 1: move the partition to even out compute time (-B)
+    int cycle; // 1: find repeating boards and skip ahead (-r)
+    int inplace; // 1: one int board, updated in place (-I)
+    int *ip_buf; // this thread's rolling rows with -I (see inplace.c)
+    const char *ckpt_path; // checkpoint file (-s), or NULL
+    int ckpt_every; // generations between checkpoints (-s)
+
+    int tile_h, tile_w; // tile size in cells (part_mode 2)
+    int tiles_y, tiles_x; // dimensions of the tile grid
+    int ntiles; // tiles_y * tiles_x
+    int *tile_order; // tile indices in Morton order (shared by threads)
+    long l2_bytes; // L2 cache size the tiles were sized for
+
+    struct gol_shared *shared; // boards and barrier shared by all threads
+    int sense; // this thread's barrier sense (see barrier.c)
+
+    /* fields used by ParaVis library (when run in OUTPUT_VISI mode). */
+    // NOTE: DO NOT CHANGE their definitions BUT USE these fields
+    visi_handle handle;
+    color3 *image_buff;
+} __attribute__((aligned(CACHE_LINE))); // threads' copies never share a line
+
+
+/****************** Function Prototypes **********************/
+
+/* packed.c: bit-packed board with a 64-cells-per-step kernel */
+int packed_alloc(struct gol_data *data);
+int packed_get_cell(struct gol_data *data, int i, int j);
+void packed_set_cell(struct gol_data *data, int i, int j);
+int packed_round(struct gol_data *data, int r0, int r1, int w0, int w1);
+int packed_changed(struct gol_data *data, int r0, int r1, int w0, int w1);
+
+/* padded.c: board with a ghost-cell halo instead of modulo wrapping */
+int padded_alloc(struct gol_data *data);
+int padded_get_cell(struct gol_data *data, int i, int j);
+void padded_set_cell(struct gol_data *data, int i, int j);
+void padded_fill_halo(struct gol_data *data, int *board,
+        int r0, int r1, int c0, int c1);
+int padded_row(const int *up, const int *mid, const int *down,
+        int *out, int n, unsigned rule);
+int padded_round(struct gol_data *data, int r0, int r1, int c0, int c1);
+int padded_changed(struct gol_data *data, int r0, int r1, int c0, int c1);
+int *padded_at(struct gol_data *data, int *board, int i, int j);
+
+/* lut.c: 4x4 -> 2x2 lookup table kernel for the padded board */
+const uint8_t *lut_table(unsigned rule);
+int lut_pair(struct gol_data *data, const uint8_t *table, const int *up,
+        const int *mid, const int *down, const int *low, int *out0,
+        int *out1, int n);
+int lut_round(struct gol_data *data, const uint8_t *table,
+        int r0, int r1, int c0, int c1);
+
+/* simd.c: AVX2/AVX-512 row kernels for the padded board */
+int simd_select(struct gol_data *data, const char *want);
+
+/* tiles.c: cache-sized 2D tiles for part_mode 2 */
+int tile_setup(struct gol_data *data);
+void tile_bounds(struct gol_data *data, int k,
+        int *r0, int *r1, int *c0, int *c1);
+void tile_print_config(struct gol_data *data);
+long l2_cache_bytes(void);
+
+/* load.c: input file parser (lab format, RLE, .cells, Life 1.06) */
+int load_buffer(const char *buf, size_t len, const char *name,
+        struct gol_data *data, struct pattern *pat);
+int load_pattern(const char *path, struct gol_data *data,
+        struct pattern *pat);
+void free_pattern(struct pattern *pat);
+
+/* sparse.c: live-cell list engine for almost empty boards */
+int sparse_alloc(struct gol_data *data);
+void sparse_free(struct sparse_set *set);
+int sparse_get_cell(struct gol_data *data, int i, int j);
+void sparse_set_cell(struct gol_data *data, int i, int j);
+void sparse_finish_load(struct gol_data *data);
+int sparse_setup(struct gol_data *data);
+void sparse_cleanup(struct gol_data *data);
+int sparse_round(struct gol_data *data, int r0, int r1);
+void sparse_merge(struct gol_data *data);
+struct sparse_set *sparse_result(struct gol_data *data);
+long sparse_lower_bound(const struct sparse_set *set, uint64_t key);
+
+/* hashlife.c: quadtree engine that jumps many generations at once */
+struct hashlife;
+struct hashlife *hashlife_create(struct gol_data *data, long cache_mb);
+void hashlife_step(struct hashlife *h, long gens);
+void hashlife_read(struct hashlife *h, struct gol_data *data);
+void hashlife_report(struct hashlife *h);
+void hashlife_destroy(struct hashlife *h);
+
+/* active.c: skipping blocks that did not change (-a) */
+int active_setup(struct gol_data *data);
+int active_region(struct gol_data *data, int r0, int r1, int c0, int c1);
+void active_reset(struct gol_data *data);
+void active_report(struct gol_data *data);
+
+/* inplace.c: one board updated in place with rolling row buffers (-I) */
+int inplace_setup(struct gol_data *data);
+void inplace_fill(struct gol_data *data);
+int inplace_region(struct gol_data *data, int r0, int r1, int c0, int c1);
+void inplace_free(struct gol_data *data);
+
+/* tblock.c: several generations per sync in cache-sized tiles (-t) */
+int tblock_setup(struct gol_data *data);
+int tblock_region(struct gol_data *data, int r0, int r1, int c0, int c1);
+void tblock_free(struct gol_data *data);
+
+/* numa.c: first-touch board placement and thread pinning (-N) */
+int numa_setup(struct gol_data *data);
+void numa_pin(struct gol_data *data);
+void *board_alloc(struct gol_data *data, size_t n, size_t size);
+int numa_first_touch(struct gol_data *data);
+
+/* balance.c: moving the partition between generations (-B) */
+int balance_setup(struct gol_data *data);
+void balance_round(struct gol_data *data);
+void balance_apply(struct gol_data *data);
+void balance_report(struct gol_data *data);
+
+/* cycle.c: repeat detection and fast-forward (-r) */
+struct cycle;
+int cycle_setup(struct gol_data *data);
+int cycle_reset(struct gol_data *data);
+void cycle_share(struct gol_data *data);
+void cycle_round(struct gol_data *data);
+void cycle_report(struct gol_data *data);
+long cycle_period(struct gol_data *data, long *start);
+void cycle_free(struct gol_data *data);
+
+/* checkpoint.c: binary board snapshots written in the background (-s) */
+struct checkpoint;
+void checkpoint_head(struct gol_data *data, long generation, long target,
+        long live, void *out);
+int checkpoint_open(struct gol_data *data, const char *path, int every);
+void checkpoint_plan(struct gol_data *data);
+void checkpoint_share(struct gol_data *data);
+void checkpoint_round(struct gol_data *data);
+int checkpoint_close(struct gol_data *data);
+void checkpoint_report(struct gol_data *data);
+void checkpoint_free(struct gol_data *data);
+int checkpoint_parse(const char *buf, size_t len, const char *name,
+        struct gol_data *data, struct pattern *pat);
+void checkpoint_place(struct gol_data *data, struct pattern *pat);
+
+/* rule.c: B/S rulestrings */
+int rule_parse(const char *s, unsigned *rule);
+void rule_format(unsigned rule, char *buf);
+
+/* render.c: frames drawn by a render thread (output modes 1 and 2) */
+struct render;
+int render_start(struct gol_data *data);
+void render_plan(struct gol_data *data);
+void render_share(struct gol_data *data);
+void render_round(struct gol_data *data);
+void render_board(struct gol_data *data, int round);
+void render_stop(struct gol_data *data);
+
+/* dist.c: the board split between processes that exchange rows (-D) */
+int dist_check(const char *spec);
+int dist_main(struct gol_data *data, const char *path);
+
+/* stream.c: the board streamed through a file on disk (-O) */
+int stream_main(struct gol_data *data, const char *path);
+
+/* census.c: per-generation population, births, deaths and box (-c) */
+int census_open(struct gol_data *data, const char *path, long live);
+void census_share(struct gol_data *data);
+void census_round(struct gol_data *data, long live);
+int census_close(struct gol_data *data);
+
+/* life.c: the engine shared by gol, libgol, gol_bench and gol_ensemble
+ * (no ParaVis) */
+void life_defaults(struct gol_data *data);
+int life_kernel(struct gol_data *data, const char *name);
+int life_setup(struct gol_data *data, struct gol_shared *shared,
+        struct pattern *pat);
+int life_reset(struct gol_data *data, struct pattern *pat);
+void life_rule(struct gol_data *data, struct pattern *pat);
+int life_share(struct gol_data *data, struct gol_shared *shared,
+        int live);
+void life_free(struct gol_data *data);
+int alloc_boards(struct gol_data *data);
+int get_cell(struct gol_data *data, int i, int j);
+void set_cell(struct gol_data *data, int i, int j);
+int *board_row(struct gol_data *data, int *board, int i);
+void init_board(struct gol_data *data, struct pattern *pat);
+void sync_boards(struct gol_data *data);
+void partition(struct gol_data *data);
+int part_units(struct gol_data *data);
+void share_bounds(struct gol_data *data, int u0, int u1, int *start,
+        int *end);
+void split_range(int units, int threads, int id, int *start, int *end);
+void *play_gol(void *arg);
+void start_loop(void *arg);
+void end_round(void *arg);
+void play_round(struct gol_data *data);
+int play_region(struct gol_data *data, int r0, int r1, int c0, int c1);
+int region_changed(struct gol_data *data, int r0, int r1, int c0, int c1);
+int scalar_round(struct gol_data *data, int r0, int r1, int c0, int c1);
+int count_neighbors(struct gol_data *data, int i, int j);
+void print_board(struct gol_data *data, int round);
+
+#endif  /* __GOL_H__ */
@@ -0,0 +1,431 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Benchmark sweep for the game engine (life.c and the kernels), built
+without ParaVis or Qt. For every kernel, board size, density and
+partition mode it runs the worker threads on a seeded random board at
+1, 2, 4, ... up to the thread limit, and times only the generation loop
+(from the barrier before the first round to the end of the last one, so
+thread creation and startup printing are left out). Each configuration
+gets an untimed warmup run and then several timed trials; the median is
+reported with cells per second, and speedup and efficiency against one
+thread on the same board. The live cell count at the end is reported
+too, so a kernel that gets faster by being wrong stands out.
+
+ * To run:
+ * ./gol_bench [-k scalar,packed,padded,lut] [-s 256,1024,4096]
+ *             [-d 0.3] [-m 0,1,2] [-p max_threads] [-g gens]
+ *             [-w warmup_gens] [-r trials] [-x seed] [-f json|csv]
+ *             [-o file]
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "gol.h"
+
+/* most entries in a comma separated option list */
+#define MAX_LIST (16)
+
+/* most timed trials per configuration */
+#define MAX_TRIALS (100)
+
+/* the sweep to run */
+struct bench_config {
+    const char *kernels[MAX_LIST];
+    int nkernels;
+    int sizes[MAX_LIST];
+    int nsizes;
+    double densities[MAX_LIST];
+    int ndensities;
+    int modes[MAX_LIST];
+    int nmodes;
+    int max_threads;
+    int gens, warmup, trials;
+    unsigned long seed;
+    int csv; // 1: CSV, 0: JSON
+};
+
+/* the result of one configuration */
+struct bench_result {
+    const char *kernel;
+    int size, mode, threads;
+    double density;
+    double min, median, mean; // seconds for all gens
+    double cells_per_sec, speedup, efficiency;
+    int live; // live cells after the last generation
+};
+
+/*
+Splits a comma separated list in place
+    s -> the list (its commas become '\0')
+    out -> where the pieces go
+    returns: the number of pieces (at most MAX_LIST)
+*/
+static int split_list(char *s, char **out) {
+    int n;
+
+    n = 0;
+    while (s != NULL && *s != '\0' && n < MAX_LIST) {
+        out[n++] = s;
+        s = strchr(s, ',');
+        if (s != NULL) {
+            *s++ = '\0';
+        }
+    }
+    return n;
+}
+
+/* qsort comparison for trial times */
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+Places live cells on a fresh board: each cell is alive with probability
+density, from a generator seeded by seed (the same board every time)
+    data-> The struct containing information for the game
+    density -> fraction of live cells
+    seed -> generator seed
+    returns: the number of live cells
+*/
+static int random_board(struct gol_data *data, double density,
+        unsigned long seed) {
+    uint64_t x, limit;
+    int i, j, live;
+
+    x = seed * 0x9E3779B97F4A7C15ULL + 1;
+    limit = (uint64_t)(density * 4294967296.0);
+    live = 0;
+    for (i = 0; i < data->rows; i++) {
+        for (j = 0; j < data->cols; j++) {
+            // xorshift64
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            if ((x >> 32) < limit) {
+                set_cell(data, i, j);
+                live++;
+            }
+        }
+    }
+    return live;
+}
+
+/*
+Plays gens generations of one configuration on a new board
+    kernel, size, density, mode, threads -> the configuration
+    gens -> generations to play
+    seed -> board seed
+    live -> set to the live cells after the last generation
+    returns: seconds spent in the generation loop
+*/
+static double run(const char *kernel, int size, double density, int mode,
+        int threads, int gens, unsigned long seed, int *live) {
+    struct gol_data data;
+    struct gol_shared shared;
+    struct gol_data *targs;
+    pthread_t *tid;
+    int i, n;
+
+    life_defaults(&data);
+    data.rows = size;
+    data.cols = size;
+    data.iters = gens;
+    data.threads = threads;
+    data.part_mode = mode;
+    data.quiet = 1;
+    life_kernel(&data, kernel);
+
+    if (alloc_boards(&data) != 0
+            || (mode == 2 && tile_setup(&data) != 0)) {
+        perror("malloc: boards");
+        exit(1);
+    }
+    n = random_board(&data, density, seed);
+    if (data.kernel == KERNEL_PADDED) {
+        padded_fill_halo(&data, data.gol_board, 0, size - 1, 0, size - 1);
+    }
+    if (life_share(&data, &shared, n) != 0) {
+        perror("malloc: thread counts");
+        exit(1);
+    }
+
+    tid = malloc(sizeof(pthread_t) * threads);
+    targs = aligned_alloc(CACHE_LINE, sizeof(struct gol_data) * threads);
+    if (tid == NULL || targs == NULL) {
+        perror("malloc: threads");
+        exit(1);
+    }
+    for (i = 0; i < threads; i++) {
+        targs[i] = data;
+        targs[i].ntids = i;
+        partition(&targs[i]);
+        if (pthread_create(&tid[i], NULL, play_gol, &targs[i]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+    }
+
+    *live = shared.total_live;
+    life_free(&data);
+    free(targs);
+    free(tid);
+    return (shared.loop_end - shared.loop_start) / 1e9;
+}
+
+/*
+Warms up and times one configuration
+    cfg -> the sweep (gens, warmup, trials, seed)
+    r -> the configuration to run (kernel, size, density, mode,
+        threads); the times and live count are filled in
+*/
+static void measure(struct bench_config *cfg, struct bench_result *r) {
+    double times[MAX_TRIALS], sum;
+    unsigned long seed;
+    int t, live;
+
+    // every configuration of a size and density plays the same board
+    seed = cfg->seed ^ ((unsigned long)r->size << 20)
+        ^ (unsigned long)(r->density * 1000);
+    if (cfg->warmup > 0) {
+        run(r->kernel, r->size, r->density, r->mode, r->threads,
+                cfg->warmup, seed, &live);
+    }
+    sum = 0;
+    for (t = 0; t < cfg->trials; t++) {
+        times[t] = run(r->kernel, r->size, r->density, r->mode, r->threads,
+                cfg->gens, seed, &r->live);
+        sum += times[t];
+    }
+    qsort(times, cfg->trials, sizeof(double), cmp_double);
+    r->min = times[0];
+    r->median = times[cfg->trials / 2];
+    r->mean = sum / cfg->trials;
+    r->cells_per_sec = (double)r->size * r->size * cfg->gens / r->median;
+}
+
+/*
+Prints one result as a JSON object or CSV line
+    out -> where to print
+    cfg -> the sweep (format, gens, trials)
+    r -> the result
+    first -> 1 for the first result (JSON: no comma before it)
+*/
+static void print_result(FILE *out, struct bench_config *cfg,
+        struct bench_result *r, int first) {
+
+    if (cfg->csv) {
+        fprintf(out, "%s,%d,%d,%g,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.4g,"
+                "%.3f,%.3f,%d\n", r->kernel, r->size, r->size,
+                r->density, r->mode, r->threads, cfg->gens, cfg->trials,
+                r->min, r->median, r->mean, r->cells_per_sec, r->speedup,
+                r->efficiency, r->live);
+        return;
+    }
+    fprintf(out, "%s  {\"kernel\": \"%s\", \"rows\": %d, \"cols\": %d, "
+            "\"density\": %g, \"part_mode\": %d, \"threads\": %d, "
+            "\"gens\": %d, \"trials\": %d, \"min_s\": %.6f, "
+            "\"median_s\": %.6f, \"mean_s\": %.6f, "
+            "\"cells_per_sec\": %.4g, \"speedup\": %.3f, "
+            "\"efficiency\": %.3f, \"live\": %d}", first ? "" : ",\n",
+            r->kernel, r->size, r->size, r->density, r->mode, r->threads,
+            cfg->gens, cfg->trials, r->min, r->median, r->mean,
+            r->cells_per_sec, r->speedup, r->efficiency, r->live);
+}
+
+/* prints the usage message and exits */
+static void usage(const char *prog) {
+
+    printf("usage: %s [-k scalar,packed,padded,lut] [-s 256,1024,4096] "
+            "[-d 0.3] [-m 0,1,2] [-p max_threads] [-g gens] "
+            "[-w warmup_gens] [-r trials] [-x seed] [-f json|csv] "
+            "[-o file]\n", prog);
+    printf("threads run 1, 2, 4, ... up to -p (default: online CPUs); "
+            "results go to -o (default stdout)\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    struct bench_config cfg;
+    struct bench_result r;
+    struct gol_data check;
+    char *list[MAX_LIST];
+    FILE *out;
+    double base;
+    int opt, i, n, k, s, d, m, threads, first;
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.kernels[0] = "scalar";
+    cfg.kernels[1] = "packed";
+    cfg.kernels[2] = "padded";
+    cfg.kernels[3] = "lut";
+    cfg.nkernels = 4;
+    cfg.sizes[0] = 256;
+    cfg.sizes[1] = 1024;
+    cfg.sizes[2] = 4096;
+    cfg.nsizes = 3;
+    cfg.densities[0] = 0.3;
+    cfg.ndensities = 1;
+    cfg.nmodes = 3;
+    for (i = 0; i < 3; i++) {
+        cfg.modes[i] = i;
+    }
+    cfg.max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    cfg.gens = 100;
+    cfg.warmup = 10;
+    cfg.trials = 5;
+    cfg.seed = 1;
+    out = stdout;
+
+    while ((opt = getopt(argc, argv, "k:s:d:m:p:g:w:r:x:f:o:")) != -1) {
+        switch (opt) {
+        case 'k':
+            cfg.nkernels = split_list(optarg, list);
+            for (i = 0; i < cfg.nkernels; i++) {
+                cfg.kernels[i] = list[i];
+            }
+            break;
+        case 's':
+            cfg.nsizes = split_list(optarg, list);
+            for (i = 0; i < cfg.nsizes; i++) {
+                cfg.sizes[i] = atoi(list[i]);
+            }
+            break;
+        case 'd':
+            cfg.ndensities = split_list(optarg, list);
+            for (i = 0; i < cfg.ndensities; i++) {
+                cfg.densities[i] = atof(list[i]);
+            }
+            break;
+        case 'm':
+            cfg.nmodes = split_list(optarg, list);
+            for (i = 0; i < cfg.nmodes; i++) {
+                cfg.modes[i] = atoi(list[i]);
+            }
+            break;
+        case 'p':
+            cfg.max_threads = atoi(optarg);
+            break;
+        case 'g':
+            cfg.gens = atoi(optarg);
+            break;
+        case 'w':
+            cfg.warmup = atoi(optarg);
+            break;
+        case 'r':
+            cfg.trials = atoi(optarg);
+            break;
+        case 'x':
+            cfg.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'f':
+            cfg.csv = (strcmp(optarg, "csv") == 0);
+            if (!cfg.csv && strcmp(optarg, "json") != 0) {
+                usage(argv[0]);
+            }
+            break;
+        case 'o':
+            out = fopen(optarg, "w");
+            if (out == NULL) {
+                perror(optarg);
+                exit(1);
+            }
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    // check the lists before running anything
+    if (cfg.max_threads < 1 || cfg.gens < 1 || cfg.warmup < 0
+            || cfg.trials < 1 || cfg.trials > MAX_TRIALS) {
+        usage(argv[0]);
+    }
+    for (i = 0; i < cfg.nkernels; i++) {
+        if (life_kernel(&check, cfg.kernels[i]) != 0) {
+            printf("ERROR: Invalid or unsupported kernel %s\n",
+                    cfg.kernels[i]);
+            exit(1);
+        }
+    }
+    for (i = 0; i < cfg.nsizes; i++) {
+        if (cfg.sizes[i] < 1) {
+            usage(argv[0]);
+        }
+    }
+    for (i = 0; i < cfg.nmodes; i++) {
+        if (cfg.modes[i] < 0 || cfg.modes[i] > 2) {
+            usage(argv[0]);
+        }
+    }
+
+    if (cfg.csv) {
+        fprintf(out, "kernel,rows,cols,density,part_mode,threads,gens,"
+                "trials,min_s,median_s,mean_s,cells_per_sec,speedup,"
+                "efficiency,live\n");
+    } else {
+        fprintf(out, "[\n");
+    }
+
+    first = 1;
+    n = 0;
+    for (k = 0; k < cfg.nkernels; k++) {
+        for (s = 0; s < cfg.nsizes; s++) {
+            for (d = 0; d < cfg.ndensities; d++) {
+                for (m = 0; m < cfg.nmodes; m++) {
+                    base = 0;
+                    for (threads = 1; ; threads *= 2) {
+                        if (threads > cfg.max_threads) {
+                            threads = cfg.max_threads;
+                        }
+                        memset(&r, 0, sizeof(r));
+                        r.kernel = cfg.kernels[k];
+                        r.size = cfg.sizes[s];
+                        r.density = cfg.densities[d];
+                        r.mode = cfg.modes[m];
+                        r.threads = threads;
+                        measure(&cfg, &r);
+                        if (threads == 1) {
+                            base = r.median;
+                        }
+                        r.speedup = base / r.median;
+                        r.efficiency = r.speedup / threads;
+                        print_result(out, &cfg, &r, first);
+                        fflush(out);
+                        first = 0;
+                        fprintf(stderr, "%s %dx%d d=%g mode %d, %d "
+                                "threads: %.4f s (%.3g cells/s)\n",
+                                r.kernel, r.size, r.size, r.density,
+                                r.mode, threads, r.median,
+                                r.cells_per_sec);
+                        n++;
+                        if (threads == cfg.max_threads) {
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (!cfg.csv) {
+        fprintf(out, "\n]\n");
+    }
+    if (out != stdout && fclose(out) != 0) {
+        perror("fclose");
+        exit(1);
+    }
+    fprintf(stderr, "%d configurations\n", n);
+    return 0;
+}
@@ -0,0 +1,335 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Ensemble mode: plays many independent boards (for example thousands of
+256x256 random soups) in one process, built without ParaVis or Qt. The
+manifest lists the boards' input files, one per line. Every worker
+thread plays a whole board by itself, start to end (one thread per
+board, so no barrier waits between the threads), then takes the next
+one from a shared counter. A worker keeps its boards from one entry to
+the next: a board of the same size is cleared and reused (life_reset),
+so only a change of size allocates. Every board's result is written to
+one CSV file as soon as it is done (in the order they finish; the first
+field is the board's line in the manifest), and the throughput in boards
+per second is printed at the end.
+
+ * To run:
+ * ./gol_ensemble [-w workers] [-k kernel] [-e dense|sparse] [-i iters]
+ *                [-b ROWSxCOLS] [-a] [-r] [-R rule] [-o results.csv]
+ *                manifest
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "gol.h"
+
+/* The run: the boards to play and where their results go */
+struct ensemble {
+    char **paths; // input file of every board
+    int n; // number of boards
+    int next; // next board to hand out (taken with an atomic add)
+    struct gol_data config; // the options every board is played with
+    FILE *out; // the results
+    pthread_mutex_t out_lock; // one result line at a time
+    long done; // boards played (under out_lock)
+    long failed; // boards that could not be loaded or set up
+    double cells; // cells times generations played, for cells/s
+};
+
+/* One worker thread: its board, kept from one entry to the next */
+struct ens_worker {
+    struct gol_data data; // its own copy (threads = 1)
+    struct gol_shared shared;
+    struct ensemble *ens;
+    int have; // 1: data holds boards from life_setup
+    long reused; // entries played on the previous entry's boards
+    pthread_t tid;
+} __attribute__((aligned(CACHE_LINE)));
+
+/*
+Reads the manifest: one input file per line; blank lines and lines
+starting with '#' are skipped
+    path -> the manifest
+    ens -> its paths and n are filled in
+    returns: 0 on success, 1 on error (printed)
+*/
+static int read_manifest(const char *path, struct ensemble *ens) {
+    FILE *f;
+    char *line = NULL, *p;
+    size_t len = 0, cap = 0;
+    char **grown;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    ens->paths = NULL;
+    ens->n = 0;
+    while (getline(&line, &len, f) != -1) {
+        p = line + strspn(line, " \t");
+        p[strcspn(p, "\r\n")] = '\0';
+        if (*p == '\0' || *p == '#') {
+            continue;
+        }
+        if ((size_t)ens->n == cap) {
+            cap = (cap > 0) ? 2 * cap : 256;
+            grown = realloc(ens->paths, sizeof(char *) * cap);
+            if (grown == NULL) {
+                perror("malloc: manifest");
+                return 1;
+            }
+            ens->paths = grown;
+        }
+        ens->paths[ens->n] = strdup(p);
+        if (ens->paths[ens->n] == NULL) {
+            perror("malloc: manifest");
+            return 1;
+        }
+        ens->n++;
+    }
+    free(line);
+    fclose(f);
+    return 0;
+}
+
+/*
+Gets a worker's boards ready for a new pattern: clears and refills the
+boards it has when the size matches, builds new ones otherwise
+    w -> the worker
+    pat -> the loaded pattern
+    returns: 0 on success, 1 on error
+*/
+static int board_ready(struct ens_worker *w, struct pattern *pat) {
+    struct gol_data *data = &w->data;
+
+    if (w->have && life_reset(data, pat) == 0) {
+        w->reused++;
+        return 0;
+    }
+    if (w->have) {
+        life_free(data);
+        w->have = 0;
+    }
+    *data = w->ens->config;
+    data->shared = NULL;
+    data->iters = pat->iters;
+    if (life_setup(data, &w->shared, pat) != 0) {
+        if (data->shared != NULL) {
+            life_free(data);
+        }
+        return 1;
+    }
+    // (the per-round -a counts are only for gol's report)
+    free(w->shared.active_counts);
+    w->shared.active_counts = NULL;
+    partition(data);
+    w->have = 1;
+    return 0;
+}
+
+/*
+Thread function of a worker: plays boards from the manifest until there
+are none left, writing each one's result line
+    arg -> the worker's struct ens_worker
+*/
+static void *ens_run(void *arg) {
+    struct ens_worker *w = (struct ens_worker *)arg;
+    struct ensemble *ens = w->ens;
+    struct gol_data *data = &w->data;
+    struct pattern pat;
+    long period, start;
+    int i, ok;
+
+    for (;;) {
+        i = __atomic_fetch_add(&ens->next, 1, __ATOMIC_RELAXED);
+        if (i >= ens->n) {
+            break;
+        }
+        ok = (load_pattern(ens->paths[i], &ens->config, &pat) == 0);
+        if (ok) {
+            ok = (board_ready(w, &pat) == 0);
+            free_pattern(&pat);
+        }
+        if (!ok) {
+            pthread_mutex_lock(&ens->out_lock);
+            fprintf(ens->out, "%d,%s,,,,,,,error\n", i, ens->paths[i]);
+            ens->failed++;
+            pthread_mutex_unlock(&ens->out_lock);
+            continue;
+        }
+
+        data->iters = pat.iters;
+        play_gol(data);
+        sync_boards(data);
+        start = 0;
+        period = cycle_period(data, &start);
+
+        pthread_mutex_lock(&ens->out_lock);
+        fprintf(ens->out, "%d,%s,%d,%d,%d,%d,%ld,%ld,ok\n", i,
+                ens->paths[i], data->rows, data->cols, data->shared->round,
+                data->shared->total_live, period, start);
+        ens->done++;
+        ens->cells += (double)data->rows * data->cols * data->iters;
+        pthread_mutex_unlock(&ens->out_lock);
+    }
+    if (w->have) {
+        life_free(data);
+    }
+    return NULL;
+}
+
+/* prints the usage message and exits */
+static void usage(const char *prog) {
+
+    printf("usage: %s [-w workers] [-k kernel] [-e dense|sparse] "
+            "[-i iters] [-b ROWSxCOLS] [-a] [-r] [-R rule] "
+            "[-o results.csv] manifest\n", prog);
+    printf("manifest: one input file per line; one worker thread per "
+            "board (default: online CPUs); results go to -o (default "
+            "stdout)\n");
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    struct ensemble ens;
+    struct gol_data *config = &ens.config;
+    struct ens_worker *workers;
+    long reused;
+    uint64_t t0, t1;
+    double secs;
+    int opt, i, nworkers;
+
+    memset(&ens, 0, sizeof(ens));
+    life_defaults(config);
+    config->threads = 1;
+    config->part_mode = 0;
+    config->engine = ENGINE_DENSE;
+    config->quiet = 1;
+    nworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    ens.out = stdout;
+
+    while ((opt = getopt(argc, argv, "w:k:e:i:b:arR:o:")) != -1) {
+        switch (opt) {
+        case 'w':
+            nworkers = atoi(optarg);
+            break;
+        case 'k':
+            if (life_kernel(config, optarg) != 0) {
+                printf("ERROR: Invalid or unsupported kernel %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'e':
+            if (strcmp(optarg, "dense") == 0) {
+                config->engine = ENGINE_DENSE;
+            } else if (strcmp(optarg, "sparse") == 0) {
+                config->engine = ENGINE_SPARSE;
+            } else {
+                // (auto could pick a different board per entry, so no
+                // reuse; HashLife is gol only)
+                printf("ERROR: Invalid engine %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'i':
+            config->opt_iters = atoi(optarg);
+            if (config->opt_iters < 0) {
+                printf("ERROR: Invalid number of iterations %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'b':
+            if (sscanf(optarg, "%dx%d", &config->opt_rows,
+                        &config->opt_cols) != 2 || config->opt_rows < 1
+                    || config->opt_cols < 1) {
+                printf("ERROR: Invalid board size %s (use ROWSxCOLS)\n",
+                        optarg);
+                exit(1);
+            }
+            break;
+        case 'a':
+            config->active = 1;
+            break;
+        case 'r':
+            config->cycle = 1;
+            break;
+        case 'R':
+            if (rule_parse(optarg, &config->rule) != 0) {
+                printf("ERROR: Invalid rule %s\n", optarg);
+                exit(1);
+            }
+            config->opt_rule = optarg;
+            break;
+        case 'o':
+            ens.out = fopen(optarg, "w");
+            if (ens.out == NULL) {
+                perror(optarg);
+                exit(1);
+            }
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || nworkers < 1) {
+        usage(argv[0]);
+    }
+    if (read_manifest(argv[optind], &ens) != 0) {
+        exit(1);
+    }
+    if (nworkers > ens.n) {
+        nworkers = (ens.n > 0) ? ens.n : 1;
+    }
+
+    workers = aligned_alloc(CACHE_LINE,
+            sizeof(struct ens_worker) * nworkers);
+    if (workers == NULL) {
+        perror("malloc: workers");
+        exit(1);
+    }
+    pthread_mutex_init(&ens.out_lock, NULL);
+    fprintf(ens.out, "board,file,rows,cols,generations,live,period,"
+            "cycle_start,status\n");
+
+    t0 = trace_now();
+    for (i = 0; i < nworkers; i++) {
+        memset(&workers[i], 0, sizeof(struct ens_worker));
+        workers[i].ens = &ens;
+        if (pthread_create(&workers[i].tid, NULL, ens_run,
+                    &workers[i]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    reused = 0;
+    for (i = 0; i < nworkers; i++) {
+        pthread_join(workers[i].tid, NULL);
+        reused += workers[i].reused;
+    }
+    t1 = trace_now();
+
+    if (ens.out != stdout && fclose(ens.out) != 0) {
+        perror("fclose");
+        exit(1);
+    }
+    secs = (t1 - t0) / 1e9;
+    fprintf(stderr, "%ld boards (%ld failed) on %d workers in %.3f s: "
+            "%.1f boards/s, %.3g cells/s; %ld played on reused boards\n",
+            ens.done, ens.failed, nworkers, secs,
+            (secs > 0) ? ens.done / secs : 0.0,
+            (secs > 0) ? ens.cells / secs : 0.0, reused);
+    pthread_mutex_destroy(&ens.out_lock);
+    for (i = 0; i < ens.n; i++) {
+        free(ens.paths[i]);
+    }
+    free(ens.paths);
+    free(workers);
+    return ens.failed > 0;
+}
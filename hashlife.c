@@ -0,0 +1,736 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+HashLife engine (-e hashlife). The world is a quadtree of canonical
+nodes: a level k node is a 2^k x 2^k square, built from four level k-1
+children, and every distinct square is stored once (nodes are looked up
+in a hash table by their children before a new one is made). Each node
+memoizes its result: its center 2^(k-1) square 2^j generations later,
+for any j <= k-2. Squares that repeat in space or in time are only ever
+worked out once, so settled patterns advance by huge jumps.
+
+The board is a torus, which is an infinite plane tiled with copies of
+the board. For each jump a node is built that holds a 2S x 2S window of
+that tiling, where S is the smallest power of 2 with S >= rows and
+S >= cols. The window starts S/2 cells up and left of the board, so its
+result (the center S x S square) starts exactly at cell (0, 0). That
+result is read back into a list of live cells and tiled again for the
+next jump. When the board is square with a power-of-2 side the tiling
+never has to leave the tree. The window is then just four copies of the
+board node, and its result is the board shifted by S/2, which is turned
+back by swapping its quadrants.
+
+Jumps are as long as the window allows (S/2 generations), and since a
+node stands for exactly one board, the engine also watches the board
+node for a repeat. Once the board cycles, whole laps of the cycle are
+skipped without computing anything.
+
+The node cache is bounded. Once a jump leaves more than the limit of
+nodes (-C), everything that the board (or the last window) cannot reach
+is swept, and if that is not enough the memoized results are dropped as
+well.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/* highest node level (a 2^30 cell window is enough for any int board) */
+#define HL_MAX_LEVEL (31)
+
+/* the two level 0 nodes (index 0 means "no node") */
+#define HL_DEAD  (1)
+#define HL_ALIVE (2)
+
+struct hl_node {
+    uint32_t nw, ne, sw, se; // children (level > 0)
+    uint32_t next; // next node in the same hash table chain
+    uint32_t result; // memoized center after 2^res_j generations, or 0
+    uint64_t pop; // live cells in the square
+    int8_t level; // log2 of the side, -1 for a free slot
+    int8_t res_j; // the step exponent result was computed for
+    uint8_t mark; // reachable (during garbage collection)
+};
+
+struct hashlife {
+    struct hl_node *nodes; // all nodes, by index
+    uint32_t cap; // slots in nodes
+    uint32_t used; // slots ever handed out
+    uint32_t count; // nodes in use
+    uint32_t free_list; // freed slots, chained through next
+    uint32_t *table; // hash table heads (chains through next)
+    uint32_t table_size; // a power of 2
+    uint32_t empty[HL_MAX_LEVEL + 1]; // the all-dead node of each level
+    long limit; // nodes to keep after a jump
+    int gcs; // garbage collections run
+
+    int rows, cols; // the torus
+    unsigned rule; // the B/S rule (see rule.c)
+    int level; // level of the window node (2S x 2S)
+    int square; // 1: square power-of-2 torus, the board stays a node
+    uint32_t board; // square: the board (a level - 1 node), otherwise
+                    // the last window; what garbage collection keeps
+    uint32_t saved; // board node kept for cycle detection (or 0)
+    long gens; // generations advanced so far
+    long period; // cycle length in generations once one is found, or 0
+    long period_at; // generation at which it was found
+    struct sparse_set cells; // otherwise: live cells (row * cols + col)
+    uint64_t *pts; // window cells as (y << 32 | x), for building
+    size_t npts, ptscap;
+};
+
+/* qsort comparison for cell keys */
+static int cmp_key(const void *a, const void *b) {
+    uint64_t ka, kb;
+
+    ka = *(const uint64_t *)a;
+    kb = *(const uint64_t *)b;
+    return (ka > kb) - (ka < kb);
+}
+
+/* hash of a node's four children */
+static uint32_t hl_hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint64_t x;
+
+    x = nw * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ ne) * 0xC2B2AE3D27D4EB4FULL;
+    x = (x ^ sw) * 0x165667B19E3779F9ULL;
+    x = (x ^ se) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(x >> 32);
+}
+
+/*
+Puts every node in use back into a hash table of size buckets
+    h -> the engine
+    size -> the new table size (a power of 2)
+*/
+static void hl_rehash(struct hashlife *h, uint32_t size) {
+    struct hl_node *n;
+    uint32_t i, b;
+
+    free(h->table);
+    h->table = calloc(size, sizeof(uint32_t));
+    if (h->table == NULL) {
+        perror("malloc: hashlife table");
+        exit(1);
+    }
+    h->table_size = size;
+    for (i = HL_ALIVE + 1; i < h->used; i++) {
+        n = &h->nodes[i];
+        if (n->level < 0) {
+            continue;
+        }
+        b = hl_hash(n->nw, n->ne, n->sw, n->se) & (size - 1);
+        n->next = h->table[b];
+        h->table[b] = i;
+    }
+}
+
+/*
+Gets a free node slot (this may move h->nodes)
+    h -> the engine
+    returns: the slot's index
+*/
+static uint32_t hl_alloc(struct hashlife *h) {
+    struct hl_node *nodes;
+    uint32_t i;
+
+    if (h->free_list != 0) {
+        i = h->free_list;
+        h->free_list = h->nodes[i].next;
+        return i;
+    }
+    if (h->used == h->cap) {
+        nodes = realloc(h->nodes, sizeof(struct hl_node) * 2 * h->cap);
+        if (nodes == NULL) {
+            perror("malloc: hashlife nodes");
+            exit(1);
+        }
+        h->nodes = nodes;
+        h->cap *= 2;
+    }
+    return h->used++;
+}
+
+/*
+Returns the canonical node with these four children, making it if it
+does not exist yet
+    h -> the engine
+    nw, ne, sw, se -> the children (all of the same level)
+    returns: the node's index
+*/
+static uint32_t hl_join(struct hashlife *h, uint32_t nw, uint32_t ne,
+        uint32_t sw, uint32_t se) {
+    struct hl_node *n;
+    uint32_t b, i;
+
+    b = hl_hash(nw, ne, sw, se) & (h->table_size - 1);
+    for (i = h->table[b]; i != 0; i = h->nodes[i].next) {
+        n = &h->nodes[i];
+        if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) {
+            return i;
+        }
+    }
+
+    i = hl_alloc(h);
+    n = &h->nodes[i];
+    n->nw = nw;
+    n->ne = ne;
+    n->sw = sw;
+    n->se = se;
+    n->level = h->nodes[nw].level + 1;
+    n->pop = h->nodes[nw].pop + h->nodes[ne].pop
+        + h->nodes[sw].pop + h->nodes[se].pop;
+    n->result = 0;
+    n->res_j = -1;
+    n->mark = 0;
+    n->next = h->table[b];
+    h->table[b] = i;
+
+    h->count++;
+    if (h->count > h->table_size) {
+        hl_rehash(h, 2 * h->table_size);
+    }
+    return i;
+}
+
+/* the level k-2 square at the center of level k node n */
+static uint32_t hl_center(struct hashlife *h, uint32_t n) {
+    struct hl_node *x = &h->nodes[n];
+
+    return hl_join(h, h->nodes[x->nw].se, h->nodes[x->ne].sw,
+            h->nodes[x->sw].ne, h->nodes[x->se].nw);
+}
+
+/* the level k-1 square centered between side by side level k-1 nodes */
+static uint32_t hl_horizontal(struct hashlife *h, uint32_t w, uint32_t e) {
+    struct hl_node *a = &h->nodes[w], *b = &h->nodes[e];
+
+    return hl_join(h, a->ne, b->nw, a->se, b->sw);
+}
+
+/* the level k-1 square centered between stacked level k-1 nodes */
+static uint32_t hl_vertical(struct hashlife *h, uint32_t n, uint32_t s) {
+    struct hl_node *a = &h->nodes[n], *b = &h->nodes[s];
+
+    return hl_join(h, a->sw, a->se, b->nw, b->ne);
+}
+
+/*
+Steps the center 2x2 of a level 2 (4x4) node one generation
+    h -> the engine
+    n -> the level 2 node
+    returns: the level 1 result
+*/
+static uint32_t hl_base(struct hashlife *h, uint32_t n) {
+    struct hl_node *x = &h->nodes[n];
+    uint32_t q[4], out[4];
+    int grid[4][4], k, y, x0, dy, dx, sum;
+
+    // the 16 cells, from the four level 1 children
+    q[0] = x->nw;
+    q[1] = x->ne;
+    q[2] = x->sw;
+    q[3] = x->se;
+    for (k = 0; k < 4; k++) {
+        y = (k / 2) * 2;
+        x0 = (k % 2) * 2;
+        grid[y][x0] = h->nodes[q[k]].nw == HL_ALIVE;
+        grid[y][x0 + 1] = h->nodes[q[k]].ne == HL_ALIVE;
+        grid[y + 1][x0] = h->nodes[q[k]].sw == HL_ALIVE;
+        grid[y + 1][x0 + 1] = h->nodes[q[k]].se == HL_ALIVE;
+    }
+
+    for (k = 0; k < 4; k++) {
+        y = 1 + k / 2;
+        x0 = 1 + k % 2;
+        sum = 0;
+        for (dy = -1; dy <= 1; dy++) {
+            for (dx = -1; dx <= 1; dx++) {
+                sum += grid[y + dy][x0 + dx];
+            }
+        }
+        sum -= grid[y][x0];
+        out[k] = RULE_NEXT(h->rule, grid[y][x0], sum) ? HL_ALIVE : HL_DEAD;
+    }
+    return hl_join(h, out[0], out[1], out[2], out[3]);
+}
+
+/*
+Returns the center of level k node n after 2^j generations (j <= k-2),
+memoized in the node
+    h -> the engine
+    n -> the node (level >= 2)
+    j -> log2 of the number of generations
+    returns: the level k-1 result
+*/
+static uint32_t hl_result(struct hashlife *h, uint32_t n, int j) {
+    uint32_t sub[9], quad[4], r;
+    uint32_t nw, ne, sw, se;
+    int k, i, full;
+
+    k = h->nodes[n].level;
+    if (h->nodes[n].pop == 0) {
+        return h->empty[k - 1];
+    }
+    if (h->nodes[n].result != 0 && h->nodes[n].res_j == j) {
+        return h->nodes[n].result;
+    }
+    if (k == 2) {
+        r = hl_base(h, n);
+        h->nodes[n].result = r;
+        h->nodes[n].res_j = 0;
+        return r;
+    }
+
+    // the nine overlapping level k-1 squares, in row order
+    nw = h->nodes[n].nw;
+    ne = h->nodes[n].ne;
+    sw = h->nodes[n].sw;
+    se = h->nodes[n].se;
+    sub[0] = nw;
+    sub[1] = hl_horizontal(h, nw, ne);
+    sub[2] = ne;
+    sub[3] = hl_vertical(h, nw, sw);
+    sub[4] = hl_center(h, n);
+    sub[5] = hl_vertical(h, ne, se);
+    sub[6] = sw;
+    sub[7] = hl_horizontal(h, sw, se);
+    sub[8] = se;
+
+    // full speed: both halves advance 2^(k-3); slower: the first half
+    // only takes the centers and the second half does all 2^j
+    full = (j == k - 2);
+    for (i = 0; i < 9; i++) {
+        sub[i] = full ? hl_result(h, sub[i], k - 3) : hl_center(h, sub[i]);
+    }
+    quad[0] = hl_join(h, sub[0], sub[1], sub[3], sub[4]);
+    quad[1] = hl_join(h, sub[1], sub[2], sub[4], sub[5]);
+    quad[2] = hl_join(h, sub[3], sub[4], sub[6], sub[7]);
+    quad[3] = hl_join(h, sub[4], sub[5], sub[7], sub[8]);
+    for (i = 0; i < 4; i++) {
+        quad[i] = hl_result(h, quad[i], full ? k - 3 : j);
+    }
+
+    r = hl_join(h, quad[0], quad[1], quad[2], quad[3]);
+    h->nodes[n].result = r;
+    h->nodes[n].res_j = j;
+    return r;
+}
+
+/*
+Builds the node of a 2^level square from the live cells in it
+    h -> the engine
+    level -> the level of the node
+    pts -> the live cells, (y << 32 | x) from the window's corner;
+           reordered in place
+    n -> number of cells
+    returns: the node
+*/
+static uint32_t hl_build(struct hashlife *h, int level, uint64_t *pts,
+        size_t n) {
+    uint64_t bit, tmp;
+    size_t top, left, right, a, b;
+    uint32_t q[4];
+
+    if (n == 0) {
+        return h->empty[level];
+    }
+    if (level == 0) {
+        return HL_ALIVE;
+    }
+
+    // split rows at the middle, then each half's columns
+    bit = (uint64_t)1 << (level - 1);
+    a = 0;
+    b = n;
+    while (a < b) {
+        if ((pts[a] >> 32) & bit) {
+            tmp = pts[a];
+            pts[a] = pts[--b];
+            pts[b] = tmp;
+        } else {
+            a++;
+        }
+    }
+    top = a;
+
+    for (a = 0, b = top; a < b;) {
+        if (pts[a] & bit) {
+            tmp = pts[a];
+            pts[a] = pts[--b];
+            pts[b] = tmp;
+        } else {
+            a++;
+        }
+    }
+    left = a;
+    for (a = top, b = n; a < b;) {
+        if (pts[a] & bit) {
+            tmp = pts[a];
+            pts[a] = pts[--b];
+            pts[b] = tmp;
+        } else {
+            a++;
+        }
+    }
+    right = a;
+
+    q[0] = hl_build(h, level - 1, pts, left);
+    q[1] = hl_build(h, level - 1, pts + left, top - left);
+    q[2] = hl_build(h, level - 1, pts + top, right - top);
+    q[3] = hl_build(h, level - 1, pts + right, n - right);
+    return hl_join(h, q[0], q[1], q[2], q[3]);
+}
+
+/* adds a window cell for hl_build */
+static void pts_push(struct hashlife *h, uint64_t y, uint64_t x) {
+    uint64_t *pts;
+
+    if (h->npts == h->ptscap) {
+        h->ptscap = (h->ptscap < 1024) ? 1024 : 2 * h->ptscap;
+        pts = realloc(h->pts, sizeof(uint64_t) * h->ptscap);
+        if (pts == NULL) {
+            perror("malloc: hashlife cells");
+            exit(1);
+        }
+        h->pts = pts;
+    }
+    h->pts[h->npts++] = (y << 32) | x;
+}
+
+/*
+Builds the window node: the torus tiling from S/2 cells above and left
+of cell (0, 0) to 3S/2 cells below and right of it
+    h -> the engine
+    returns: the level h->level node
+*/
+static uint32_t hl_window(struct hashlife *h) {
+    long s, half, i, y, x, r, c;
+
+    s = 1L << (h->level - 1);
+    half = s / 2;
+    h->npts = 0;
+    for (i = 0; i < h->cells.n; i++) {
+        r = (long)(h->cells.cells[i] / h->cols);
+        c = (long)(h->cells.cells[i] % h->cols);
+        // every copy of (r, c) with -S/2 <= y, x < 3S/2
+        for (y = r - ((r + half) / h->rows) * h->rows; y < s + half;
+                y += h->rows) {
+            for (x = c - ((c + half) / h->cols) * h->cols; x < s + half;
+                    x += h->cols) {
+                pts_push(h, y + half, x + half);
+            }
+        }
+    }
+    return hl_build(h, h->level, h->pts, h->npts);
+}
+
+/*
+Adds the live cells of node n, whose corner is cell (oy, ox), that lie
+on the board to a cell list
+    h -> the engine
+    n -> the node
+    oy, ox -> the board cell at the node's top left corner
+    out -> the list to add to
+*/
+static void hl_collect_cells(struct hashlife *h, uint32_t n, long oy,
+        long ox, struct sparse_set *out) {
+    struct hl_node *x = &h->nodes[n];
+    long half;
+    uint64_t *cells;
+
+    if (x->pop == 0 || oy >= h->rows || ox >= h->cols) {
+        return;
+    }
+    if (x->level == 0) {
+        if (out->n == out->cap) {
+            out->cap = (out->cap < 16) ? 16 : 2 * out->cap;
+            cells = realloc(out->cells, sizeof(uint64_t) * out->cap);
+            if (cells == NULL) {
+                perror("malloc: hashlife cells");
+                exit(1);
+            }
+            out->cells = cells;
+        }
+        out->cells[out->n++] = (uint64_t)oy * h->cols + ox;
+        return;
+    }
+    half = 1L << (x->level - 1);
+    hl_collect_cells(h, x->nw, oy, ox, out);
+    hl_collect_cells(h, x->ne, oy, ox + half, out);
+    hl_collect_cells(h, x->sw, oy + half, ox, out);
+    hl_collect_cells(h, x->se, oy + half, ox + half, out);
+}
+
+/* marks node n and what it reaches (its results too, if keep) */
+static void hl_mark(struct hashlife *h, uint32_t n, int keep) {
+    struct hl_node *x;
+
+    if (n == 0 || h->nodes[n].mark) {
+        return;
+    }
+    x = &h->nodes[n];
+    x->mark = 1;
+    if (x->level > 0) {
+        hl_mark(h, x->nw, keep);
+        hl_mark(h, x->ne, keep);
+        hl_mark(h, x->sw, keep);
+        hl_mark(h, x->se, keep);
+    }
+    if (keep) {
+        hl_mark(h, x->result, keep);
+    }
+}
+
+/*
+Frees every node that the board (and the empty nodes) cannot reach
+    h -> the engine
+    keep -> 1: memoized results count as reachable, 0: forget them all
+*/
+static void hl_sweep(struct hashlife *h, int keep) {
+    struct hl_node *x;
+    uint32_t i;
+    int k;
+
+    if (!keep) {
+        for (i = HL_ALIVE + 1; i < h->used; i++) {
+            h->nodes[i].result = 0;
+        }
+    }
+    for (k = 0; k <= HL_MAX_LEVEL; k++) {
+        hl_mark(h, h->empty[k], keep);
+    }
+    hl_mark(h, h->board, keep);
+    hl_mark(h, h->saved, keep);
+
+    for (i = HL_ALIVE + 1; i < h->used; i++) {
+        x = &h->nodes[i];
+        if (x->level < 0) {
+            continue;
+        }
+        if (!x->mark) {
+            x->level = -1;
+            x->next = h->free_list;
+            h->free_list = i;
+            h->count--;
+        }
+        x->mark = 0;
+    }
+    h->nodes[HL_DEAD].mark = 0;
+    h->nodes[HL_ALIVE].mark = 0;
+    hl_rehash(h, h->table_size);
+}
+
+/*
+Brings the node cache back under its limit (run between jumps only,
+when the board is the only live root)
+    h -> the engine
+*/
+static void hl_gc(struct hashlife *h) {
+
+    h->gcs++;
+    hl_sweep(h, 1);
+    if (h->count > h->limit / 2) {
+        hl_sweep(h, 0);
+    }
+}
+
+/*
+Creates a HashLife engine holding the current (sparse) board
+    data-> The struct containing information for the game
+    cache_mb -> memory for the node cache, in MB
+    returns: the engine, or NULL on error
+*/
+struct hashlife *hashlife_create(struct gol_data *data, long cache_mb) {
+    struct hashlife *h;
+    long s, i;
+    int k;
+
+    h = calloc(1, sizeof(struct hashlife));
+    if (h == NULL) {
+        return NULL;
+    }
+    h->cap = 1024;
+    h->nodes = calloc(h->cap, sizeof(struct hl_node));
+    h->table_size = 1024;
+    h->table = calloc(h->table_size, sizeof(uint32_t));
+    if (h->nodes == NULL || h->table == NULL) {
+        hashlife_destroy(h);
+        return NULL;
+    }
+    h->limit = cache_mb * 1024 * 1024 / sizeof(struct hl_node);
+    h->rows = data->rows;
+    h->cols = data->cols;
+    h->rule = data->rule;
+
+    // the two leaves, then the empty square of every level
+    h->used = HL_ALIVE + 1;
+    h->nodes[HL_DEAD].level = 0;
+    h->nodes[HL_ALIVE].level = 0;
+    h->nodes[HL_ALIVE].pop = 1;
+    h->empty[0] = HL_DEAD;
+    for (k = 1; k <= HL_MAX_LEVEL; k++) {
+        h->empty[k] = hl_join(h, h->empty[k - 1], h->empty[k - 1],
+                h->empty[k - 1], h->empty[k - 1]);
+    }
+
+    // window of 2S x 2S with S a power of 2 >= rows, cols (and >= 2)
+    s = 2;
+    h->level = 2;
+    while (s < h->rows || s < h->cols) {
+        s *= 2;
+        h->level++;
+    }
+    h->square = (h->rows == s && h->cols == s);
+
+    h->cells.cells = malloc(sizeof(uint64_t) * (data->sparse_board->n + 1));
+    if (h->cells.cells == NULL) {
+        hashlife_destroy(h);
+        return NULL;
+    }
+    h->cells.cap = data->sparse_board->n + 1;
+    h->cells.n = data->sparse_board->n;
+    memcpy(h->cells.cells, data->sparse_board->cells,
+            sizeof(uint64_t) * h->cells.n);
+
+    if (h->square) {
+        h->npts = 0;
+        for (i = 0; i < h->cells.n; i++) {
+            pts_push(h, h->cells.cells[i] / h->cols,
+                    h->cells.cells[i] % h->cols);
+        }
+        h->board = hl_build(h, h->level - 1, h->pts, h->npts);
+    }
+    return h;
+}
+
+/*
+Advances the board gens generations, in jumps of up to S/2
+    h -> the engine
+    gens -> number of generations
+*/
+void hashlife_step(struct hashlife *h, long gens) {
+    struct hl_node *r;
+    uint32_t w, res;
+    long power, lam, skip;
+    int j;
+
+    power = 1;
+    lam = 0;
+    h->saved = 0;
+    while (gens > 0) {
+        j = h->level - 2;
+        while ((1L << j) > gens) {
+            j--;
+        }
+
+        // the node that holds the whole board right now
+        if (h->square) {
+            w = hl_join(h, h->board, h->board, h->board, h->board);
+        } else {
+            w = hl_window(h);
+        }
+
+        // nodes are canonical, so the board repeats exactly when the
+        // node does: look for a cycle over full size jumps (Brent) and
+        // skip every whole lap of it that still fits
+        if (j == h->level - 2 && h->period == 0) {
+            lam++;
+            if (w == h->saved) {
+                h->period = lam << j;
+                h->period_at = h->gens;
+                skip = (gens >> j) / lam * lam;
+                gens -= skip << j;
+                h->gens += skip << j;
+                continue;
+            }
+            if (lam == power) {
+                h->saved = w;
+                power *= 2;
+                lam = 0;
+            }
+        }
+
+        res = hl_result(h, w, j);
+        if (h->square) {
+            // the result is the board shifted by S/2 in both directions,
+            // which swapping its quadrants undoes
+            r = &h->nodes[res];
+            h->board = hl_join(h, r->se, r->sw, r->ne, r->nw);
+        } else {
+            h->board = w;
+            h->cells.n = 0;
+            hl_collect_cells(h, res, 0, 0, &h->cells);
+        }
+        gens -= 1L << j;
+        h->gens += 1L << j;
+
+        if (h->count > h->limit) {
+            hl_gc(h);
+        }
+    }
+}
+
+/*
+Copies the engine's board into data->sparse_board (sorted, like the
+sparse engine keeps it)
+    h -> the engine
+    data-> The struct containing information for the game
+*/
+void hashlife_read(struct hashlife *h, struct gol_data *data) {
+    struct sparse_set *out = data->sparse_board;
+
+    if (h->square) {
+        out->n = 0;
+        hl_collect_cells(h, h->board, 0, 0, out);
+    } else {
+        if (out->cap < h->cells.n) {
+            free(out->cells);
+            out->cells = malloc(sizeof(uint64_t) * h->cells.n);
+            if (out->cells == NULL) {
+                perror("malloc: hashlife cells");
+                exit(1);
+            }
+            out->cap = h->cells.n;
+        }
+        memcpy(out->cells, h->cells.cells, sizeof(uint64_t) * h->cells.n);
+        out->n = h->cells.n;
+    }
+    qsort(out->cells, out->n, sizeof(uint64_t), cmp_key);
+}
+
+/*
+Prints the node cache statistics
+    h -> the engine
+*/
+void hashlife_report(struct hashlife *h) {
+
+    printf("HashLife: %u nodes cached (limit %ld), %d collections, "
+            "%s\n", h->count, h->limit, h->gcs,
+            h->square ? "board kept as a node" : "board re-tiled per jump");
+    if (h->period != 0) {
+        printf("HashLife: board repeats every %ld generations "
+                "(found at generation %ld)\n", h->period, h->period_at);
+    }
+}
+
+/*
+Frees the engine
+    h -> the engine (may be NULL)
+*/
+void hashlife_destroy(struct hashlife *h) {
+
+    if (h == NULL) {
+        return;
+    }
+    free(h->nodes);
+    free(h->table);
+    free(h->cells.cells);
+    free(h->pts);
+    free(h);
+}
@@ -0,0 +1,231 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+In-place stepping (-I): one board instead of two. The int boards are
+otherwise double buffered, which doubles the memory a big board needs;
+with -I next_board is the same buffer as gol_board, and each thread
+overwrites its rows with the next generation as it goes, top to bottom.
+
+A row's next state needs the old states of the rows above and below it,
+so every thread keeps a rolling buffer of four padded rows (old rows,
+with their wrapped neighbors at [-1] and [cols]): row i is written only
+after the old copies of rows i - 1 .. i + 1 are in the buffer, and row
+i + 1 is still old on the board when it is copied in. -k lut writes two
+rows at a time, i and i + 1, from the old rows i - 1 .. i + 2, which is
+why there are four. The rows just outside a thread's share belong to
+its neighbors, who overwrite them in the same round, so every thread
+also leaves copies of its own first and last rows in shared->edges: two
+sets, one read in this round (the old rows, indexed by shared->cur) and
+one written with the new rows for the next round. end_round flips cur,
+so the sets swap without a copy. Memory is one board plus four rows per
+thread and four per thread in edges.
+
+Rows partition only (the edges are whole rows), on the int boards: the
+padded board with its row kernel (padded or SIMD) or the lut table, and
+the scalar board, whose rows are played with the padded row kernel too
+(on the padded copies; kernel_name says so).
+Not with -a, -t and -c, which compare the old board with the new one,
+or with -B, which moves the shares.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/*
+Copies board row i into a padded row (the cells at [0, cols), their
+wrapped neighbors at [-1] and [cols])
+    data-> The struct containing information for the game
+    i -> the row
+    out -> cols + 2 ints; out[-1] is the first
+*/
+static void load_row(struct gol_data *data, int i, int *out) {
+    const int *row = board_row(data, data->gol_board, i);
+
+    memcpy(out, row, sizeof(int) * data->cols);
+    out[-1] = row[data->cols - 1];
+    out[data->cols] = row[0];
+}
+
+/*
+Returns the padded copy of a thread's first or last row in one set of
+shared->edges
+    data-> The struct containing information for the game
+    set -> 0 or 1 (the set read in a round is shared->cur)
+    t -> the thread
+    last -> 0 for its first row, 1 for its last
+    returns: a pointer to the row's cell 0
+*/
+static int *edge_row(struct gol_data *data, int set, int t, int last) {
+    size_t stride = (size_t)data->cols + 2;
+
+    return data->shared->edges
+        + ((size_t)(set * data->threads + t) * 2 + last) * stride + 1;
+}
+
+/*
+Returns the old copy of row i, which a neighbor thread owns (the one
+whose share of the rows partition holds it)
+    data-> The struct containing information for the game
+    i -> the row (wrapped around the torus)
+    returns: its padded copy in the set of edges read this round
+*/
+static const int *neighbor_row(struct gol_data *data, int i) {
+    int t, r0, r1;
+
+    // (the shares are in order: the first one that ends at or after i)
+    i = (i + data->rows) % data->rows;
+    t = -1;
+    do {
+        t++;
+        split_range(data->rows, data->threads, t, &r0, &r1);
+    } while (r1 < i);
+    return edge_row(data, data->shared->cur, t, i == r1);
+}
+
+/*
+Copies every thread's first and last rows from the board into the set
+of edges read in the next round (before the first round, and by
+life_reset)
+    data-> The struct containing information for the game
+*/
+void inplace_fill(struct gol_data *data) {
+    int t, r0, r1;
+
+    for (t = 0; t < data->threads; t++) {
+        split_range(data->rows, data->threads, t, &r0, &r1);
+        if (r0 <= r1) {
+            load_row(data, r0, edge_row(data, data->shared->cur, t, 0));
+            load_row(data, r1, edge_row(data, data->shared->cur, t, 1));
+        }
+    }
+}
+
+/*
+Allocates shared->edges and fills in the first round's set (after the
+board is loaded)
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int inplace_setup(struct gol_data *data) {
+    size_t n;
+
+    n = (size_t)4 * data->threads * ((size_t)data->cols + 2);
+    data->shared->edges = calloc(n, sizeof(int));
+    if (data->shared->edges == NULL) {
+        return 1;
+    }
+    inplace_fill(data);
+    return 0;
+}
+
+/*
+Returns the old copy of row i for a thread playing rows r0..r1: buffer
+(i - r0) % 4 inside the share (copied in by old_load), the neighbors'
+copies just outside it
+    data-> The struct containing information for the game
+    r0, r1 -> the thread's share
+    i -> the row, r0 - 1 .. r1 + 1
+*/
+static const int *old_row(struct gol_data *data, int r0, int r1, int i) {
+
+    if (i < r0 || i > r1) {
+        return neighbor_row(data, i);
+    }
+    return data->ip_buf + (size_t)((i - r0) % 4) * (data->cols + 2) + 1;
+}
+
+/*
+Copies row i into its buffer, while it is still old on the board (rows
+outside the share are left to neighbor_row)
+    data-> The struct containing information for the game
+    r0, r1 -> the thread's share
+    i -> the row
+*/
+static void old_load(struct gol_data *data, int r0, int r1, int i) {
+
+    if (i >= r0 && i <= r1) {
+        load_row(data, i, (int *)old_row(data, r0, r1, i));
+    }
+}
+
+/*
+Fills in the halo cells of a row of the padded board just written
+    data-> The struct containing information for the game
+    out -> the row
+*/
+static void row_halo(struct gol_data *data, int *out) {
+
+    if (data->kernel == KERNEL_PADDED) {
+        out[-1] = out[data->cols - 1];
+        out[data->cols] = out[0];
+    }
+}
+
+/*
+Plays one round on rows r0..r1 (all the columns) in place, and leaves
+copies of the new first and last rows for the neighbors (used by
+play_round in place of play_region)
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row (the thread's share)
+    c0, c1 -> the first and last column (the whole row)
+    returns: the change in the number of live cells in the rows
+*/
+int inplace_region(struct gol_data *data, int r0, int r1, int c0, int c1) {
+    const uint8_t *table;
+    int *out;
+    int i, live;
+
+    if (r0 > r1 || c0 > c1) {
+        return 0;
+    }
+    if (data->ip_buf == NULL) {
+        data->ip_buf = malloc(sizeof(int) * 4 * ((size_t)data->cols + 2));
+        if (data->ip_buf == NULL) {
+            perror("malloc: in-place row buffers");
+            exit(1);
+        }
+    }
+    table = data->lut ? lut_table(data->rule) : NULL;
+
+    old_load(data, r0, r1, r0);
+    live = 0;
+    for (i = r0; i <= r1; i++) {
+        out = board_row(data, data->gol_board, i);
+        old_load(data, r0, r1, i + 1);
+        if (table != NULL && i < r1) {
+            // -k lut: rows i and i + 1 from the table
+            old_load(data, r0, r1, i + 2);
+            live += lut_pair(data, table, old_row(data, r0, r1, i - 1),
+                    old_row(data, r0, r1, i), old_row(data, r0, r1, i + 1),
+                    old_row(data, r0, r1, i + 2), out,
+                    board_row(data, data->gol_board, i + 1), data->cols);
+            row_halo(data, out);
+            i++;
+            out = board_row(data, data->gol_board, i);
+        } else {
+            live += data->row_fn(old_row(data, r0, r1, i - 1),
+                    old_row(data, r0, r1, i), old_row(data, r0, r1, i + 1),
+                    out, data->cols, data->rule);
+        }
+        row_halo(data, out);
+    }
+
+    load_row(data, r0, edge_row(data, !data->shared->cur, data->ntids, 0));
+    load_row(data, r1, edge_row(data, !data->shared->cur, data->ntids, 1));
+    return live;
+}
+
+/*
+Frees a thread's rolling row buffers
+    data-> The struct containing information for the game
+*/
+void inplace_free(struct gol_data *data) {
+
+    free(data->ip_buf);
+    data->ip_buf = NULL;
+}
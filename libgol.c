@@ -0,0 +1,388 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+The engine API behind libgol.h. A handle holds what gol's main keeps on
+its stack (the template gol_data, the gol_shared and the threads'
+copies) plus a small thread pool: the workers are started once by
+gol_create and then wait on a condition variable. gol_step publishes a
+request for n generations and wakes them; each runs play_gol for n
+rounds on its share, exactly as gol's threads do (one barrier per
+round), and the last one to finish wakes the caller. Generations,
+active blocks and balancing state carry over from one step to the next.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "gol.h"
+#include "libgol.h"
+
+/* one simulation */
+struct gol_engine {
+    struct gol_data data; // the template the workers were copied from
+    struct gol_shared shared; // boards, barrier and counts
+    struct gol_data *targs; // the workers' copies
+    struct pool_worker *workers;
+    pthread_t *tid;
+    int started; // workers running
+
+    pthread_mutex_t lock; // guards the fields below
+    pthread_cond_t go; // a new request (or quit)
+    pthread_cond_t done; // every worker finished the request
+    long seq; // number of requests so far
+    int steps; // generations in the current request
+    int finished; // workers done with the current request
+    int quit; // 1: workers exit
+};
+
+/* what a pool thread needs: its gol_data and the handle */
+struct pool_worker {
+    struct gol_engine *e;
+    struct gol_data *data;
+};
+
+/*
+Sets every field of a config to its default (what gol does with no
+options: one thread, rows, scalar kernel, auto engine)
+    cfg -> the config
+*/
+void gol_config_init(struct gol_config *cfg) {
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->threads = 1;
+    cfg->kernel = "scalar";
+    cfg->engine = "auto";
+}
+
+/*
+Thread function of the pool: plays every request, then waits for the
+next one, until gol_destroy
+    arg -> the thread's struct pool_worker
+*/
+static void *pool_run(void *arg) {
+    struct pool_worker *w = (struct pool_worker *)arg;
+    struct gol_engine *e = w->e;
+    long seq;
+
+    seq = 0;
+    pthread_mutex_lock(&e->lock);
+    for (;;) {
+        while (e->seq == seq && !e->quit) {
+            pthread_cond_wait(&e->go, &e->lock);
+        }
+        if (e->quit) {
+            break;
+        }
+        seq = e->seq;
+        w->data->iters = e->steps;
+        pthread_mutex_unlock(&e->lock);
+
+        play_gol(w->data);
+
+        pthread_mutex_lock(&e->lock);
+        if (++e->finished == e->data.threads) {
+            pthread_cond_signal(&e->done);
+        }
+    }
+    pthread_mutex_unlock(&e->lock);
+    return NULL;
+}
+
+/*
+Sets up the options of a new handle from a config
+    e -> the handle
+    cfg -> the config (NULL: the defaults)
+    returns: 0 on success, 1 for an invalid config
+*/
+static int apply_config(struct gol_engine *e, const struct gol_config *cfg) {
+    struct gol_data *data = &e->data;
+    struct gol_config def;
+
+    if (cfg == NULL) {
+        gol_config_init(&def);
+        cfg = &def;
+    }
+    life_defaults(data);
+    data->quiet = 1;
+    data->threads = cfg->threads;
+    data->part_mode = cfg->part_mode;
+    data->opt_rows = cfg->rows;
+    data->opt_cols = cfg->cols;
+    data->active = cfg->active;
+    data->balance = cfg->balance;
+    data->tb_k = cfg->tb_k;
+    data->numa = cfg->numa;
+    data->cycle = cfg->cycle;
+    data->inplace = cfg->inplace;
+    if (cfg->threads < 1 || cfg->part_mode < 0 || cfg->part_mode > 2
+            || cfg->tb_k < -1
+            || (cfg->tb_k != 0 && (cfg->active || cfg->cycle))) {
+        return 1;
+    }
+    if (cfg->kernel != NULL && life_kernel(data, cfg->kernel) != 0) {
+        return 1;
+    }
+    if (cfg->rule != NULL && rule_parse(cfg->rule, &data->rule) != 0) {
+        return 1;
+    }
+    data->opt_rule = cfg->rule;
+    if (cfg->engine == NULL || strcmp(cfg->engine, "auto") == 0) {
+        data->engine = ENGINE_AUTO;
+    } else if (strcmp(cfg->engine, "dense") == 0) {
+        data->engine = ENGINE_DENSE;
+    } else if (strcmp(cfg->engine, "sparse") == 0) {
+        data->engine = ENGINE_SPARSE;
+    } else {
+        // (hashlife is one thread with its own stepping: gol only)
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Builds a handle from a loaded pattern and starts its workers
+    e -> the handle, with its options set
+    pat -> the pattern (freed here)
+    returns: 0 on success, 1 on error
+*/
+static int start_engine(struct gol_engine *e, struct pattern *pat) {
+    struct gol_data *data = &e->data;
+    int i, ret;
+
+    data->iters = 0;
+    ret = life_setup(data, &e->shared, pat);
+    free_pattern(pat);
+    if (ret != 0) {
+        return 1;
+    }
+    // (the per-round -a counts are only for gol's report)
+    free(e->shared.active_counts);
+    e->shared.active_counts = NULL;
+
+    e->tid = malloc(sizeof(pthread_t) * data->threads);
+    e->workers = malloc(sizeof(struct pool_worker) * data->threads);
+    e->targs = aligned_alloc(CACHE_LINE,
+            sizeof(struct gol_data) * data->threads);
+    if (e->tid == NULL || e->workers == NULL || e->targs == NULL) {
+        return 1;
+    }
+    for (i = 0; i < data->threads; i++) {
+        e->targs[i] = *data;
+        e->targs[i].ntids = i;
+        partition(&e->targs[i]);
+        e->workers[i].e = e;
+        e->workers[i].data = &e->targs[i];
+        if (pthread_create(&e->tid[i], NULL, pool_run,
+                    &e->workers[i]) != 0) {
+            return 1;
+        }
+        e->started++;
+    }
+    return 0;
+}
+
+/*
+Allocates an empty handle
+    returns: the handle, or NULL
+*/
+static struct gol_engine *new_engine(void) {
+    struct gol_engine *e;
+
+    e = aligned_alloc(CACHE_LINE, sizeof(struct gol_engine));
+    if (e != NULL) {
+        memset(e, 0, sizeof(*e));
+        pthread_mutex_init(&e->lock, NULL);
+        pthread_cond_init(&e->go, NULL);
+        pthread_cond_init(&e->done, NULL);
+    }
+    return e;
+}
+
+/*
+Creates a simulation from an input file (any format gol reads)
+    path -> the file
+    cfg -> how to run it (NULL: the defaults)
+    returns: the handle, or NULL on error (a file error has been printed)
+*/
+struct gol_engine *gol_create_file(const char *path,
+        const struct gol_config *cfg) {
+    struct gol_engine *e;
+    struct pattern pat;
+
+    e = new_engine();
+    if (e == NULL) {
+        return NULL;
+    }
+    if (apply_config(e, cfg) != 0
+            || load_pattern(path, &e->data, &pat) != 0) {
+        gol_destroy(e);
+        return NULL;
+    }
+    if (start_engine(e, &pat) != 0) {
+        gol_destroy(e);
+        return NULL;
+    }
+    return e;
+}
+
+/*
+Creates a simulation from an input held in memory
+    buf -> the input (any format gol reads; need not end in '\0')
+    len -> its length in bytes
+    name -> a file name for it: the extension picks the format (.rle,
+        .cells), and it is used in error messages
+    cfg -> how to run it (NULL: the defaults)
+    returns: the handle, or NULL on error (a parse error has been printed)
+*/
+struct gol_engine *gol_create_buffer(const char *buf, size_t len,
+        const char *name, const struct gol_config *cfg) {
+    struct gol_engine *e;
+    struct pattern pat;
+
+    e = new_engine();
+    if (e == NULL) {
+        return NULL;
+    }
+    if (apply_config(e, cfg) != 0
+            || load_buffer(buf, len, name, &e->data, &pat) != 0) {
+        gol_destroy(e);
+        return NULL;
+    }
+    if (start_engine(e, &pat) != 0) {
+        gol_destroy(e);
+        return NULL;
+    }
+    return e;
+}
+
+/*
+Plays n generations with the handle's threads and returns when they are
+done
+    e -> the handle
+    n -> generations to play
+    returns: 0 on success, 1 if n is negative
+*/
+int gol_step(struct gol_engine *e, int n) {
+
+    if (n < 0) {
+        return 1;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&e->lock);
+    e->steps = n;
+    e->finished = 0;
+    e->seq++;
+    pthread_cond_broadcast(&e->go);
+    while (e->finished < e->data.threads) {
+        pthread_cond_wait(&e->done, &e->lock);
+    }
+    pthread_mutex_unlock(&e->lock);
+
+    // the template reads the new current board (gol_read_region)
+    sync_boards(&e->data);
+    return 0;
+}
+
+/*
+Returns the number of live cells on the current board
+    e -> the handle
+*/
+long gol_population(struct gol_engine *e) {
+
+    return e->shared.total_live;
+}
+
+/*
+Returns how many generations have been played
+    e -> the handle
+*/
+long gol_generation(struct gol_engine *e) {
+
+    return e->shared.round;
+}
+
+/*
+Gets the board size
+    e -> the handle
+    rows, cols -> set to the number of rows and columns
+*/
+void gol_size(struct gol_engine *e, int *rows, int *cols) {
+
+    *rows = e->data.rows;
+    *cols = e->data.cols;
+}
+
+/*
+Gets the cycle the board is in, once cycle detection (cfg.cycle) has
+found one; later gol_step calls skip its whole periods
+    e -> the handle
+    start -> set to the generation where the cycle starts
+    returns: the period, or 0 if no repeat has been found
+*/
+long gol_cycle(struct gol_engine *e, long *start) {
+
+    return cycle_period(&e->data, start);
+}
+
+/*
+Copies a rectangle of the current board out, one byte per cell (1 alive,
+0 dead), row after row
+    e -> the handle
+    r0, c0 -> the top left cell
+    rows, cols -> the size of the rectangle
+    out -> room for rows * cols bytes
+    returns: 0 on success, 1 if the rectangle is not on the board
+*/
+int gol_read_region(struct gol_engine *e, int r0, int c0, int rows,
+        int cols, unsigned char *out) {
+    struct gol_data *data = &e->data;
+    int i, j;
+
+    if (r0 < 0 || c0 < 0 || rows < 0 || cols < 0
+            || r0 + rows > data->rows || c0 + cols > data->cols) {
+        return 1;
+    }
+    for (i = 0; i < rows; i++) {
+        for (j = 0; j < cols; j++) {
+            out[(size_t)i * cols + j] = get_cell(data, r0 + i, c0 + j);
+        }
+    }
+    return 0;
+}
+
+/*
+Stops the handle's threads and frees everything it holds
+    e -> the handle (may be NULL)
+*/
+void gol_destroy(struct gol_engine *e) {
+    int i;
+
+    if (e == NULL) {
+        return;
+    }
+    if (e->started > 0) {
+        pthread_mutex_lock(&e->lock);
+        e->quit = 1;
+        pthread_cond_broadcast(&e->go);
+        pthread_mutex_unlock(&e->lock);
+        for (i = 0; i < e->started; i++) {
+            pthread_join(e->tid[i], NULL);
+        }
+    }
+    if (e->data.shared != NULL) {
+        life_free(&e->data);
+    }
+    pthread_mutex_destroy(&e->lock);
+    pthread_cond_destroy(&e->go);
+    pthread_cond_destroy(&e->done);
+    free(e->targs);
+    free(e->workers);
+    free(e->tid);
+    free(e);
+}
@@ -0,0 +1,62 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+libgol.a: the Game of Life engine as a library, for programs that host
+many simulations at once (make lib). Every simulation is a struct
+gol_engine handle with its own boards, barrier and pool of worker
+threads; the threads sleep between gol_step calls. Handles share
+nothing, so any number can run side by side in one process, each
+driven by its own caller thread. One handle must not be used by two
+threads at the same time.
+*/
+#ifndef __LIBGOL_H__
+#define __LIBGOL_H__
+
+#include <stddef.h>
+
+/* a simulation (opaque) */
+struct gol_engine;
+
+/* How to run a simulation: the same choices as gol's arguments and
+ * options. Fill it in with gol_config_init, then change what you need. */
+struct gol_config {
+    int threads; // worker threads (default 1)
+    int part_mode; // 0 rows, 1 columns, 2 L2-sized tiles (default 0)
+    const char *kernel; // -k: scalar, packed, padded, lut, simd... (scalar;
+                        // lut builds a 64 KB table per rule, kept until
+                        // the process exits, for the first 8 rules)
+    const char *engine; // -e: auto, dense or sparse (auto)
+    int rows, cols; // -b: board size for formats without one (0: the
+                    // pattern's own)
+    int active; // -a: skip blocks that cannot change (0)
+    int balance; // -B: move the partition to even out the threads (0)
+    int tb_k; // -t: generations per sync in cache-sized tiles (0: off,
+              // -1: auto)
+    int numa; // -N: pinned threads, first-touch boards (0)
+    int cycle; // -r: find repeats and skip whole periods (0; not with
+               // tb_k)
+    int inplace; // -I: one board updated in place (0; rows partition,
+                 // not with active, balance or tb_k)
+    const char *rule; // -R: B/S rule such as "B36/S23" (NULL: the
+                      // input's, or B3/S23)
+};
+
+void gol_config_init(struct gol_config *cfg);
+struct gol_engine *gol_create_file(const char *path,
+        const struct gol_config *cfg);
+struct gol_engine *gol_create_buffer(const char *buf, size_t len,
+        const char *name, const struct gol_config *cfg);
+int gol_step(struct gol_engine *e, int n);
+long gol_population(struct gol_engine *e);
+long gol_generation(struct gol_engine *e);
+void gol_size(struct gol_engine *e, int *rows, int *cols);
+long gol_cycle(struct gol_engine *e, long *start);
+int gol_read_region(struct gol_engine *e, int r0, int c0, int rows,
+        int cols, unsigned char *out);
+void gol_destroy(struct gol_engine *e);
+
+#endif  /* __LIBGOL_H__ */
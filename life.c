@@ -0,0 +1,1028 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+The simulation engine: board allocation and cell access, partitioning,
+the worker thread loop (play_gol) and the per-round kernels dispatch.
+It has no ParaVis code and no globals (everything the threads share is
+in struct gol_shared), so gol (gol.c: arguments, files, animation),
+libgol.a (libgol.c: simulations hosted in another program), gol_bench
+(gol_bench.c: timing sweeps, no Qt) and gol_ensemble (gol_ensemble.c:
+many small boards at once) all link it.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+#include "gol.h"
+
+/*
+Sets every option parse_options can change to its default, and the
+fields the engine fills in later to empty
+    data-> The struct containing information for the game
+*/
+void life_defaults(struct gol_data *data) {
+
+    data->curr_iter = 0;
+    data->ntids = 0;
+    data->output_mode = OUTPUT_NONE;
+    data->print_config = 0;
+    data->kernel = KERNEL_SCALAR;
+    data->kernel_name = "scalar";
+    data->row_fn = padded_row;
+    data->lut = 0;
+    data->active = 0;
+    data->engine = ENGINE_AUTO;
+    data->cache_mb = HASHLIFE_CACHE_MB;
+    data->opt_rows = 0;
+    data->opt_cols = 0;
+    data->opt_iters = -1;
+    data->rule = RULE_LIFE;
+    data->opt_rule = NULL;
+    data->dist_spec = NULL;
+    data->stream_path = NULL;
+    data->tb_k = 0;
+    data->tb_steps = 1;
+    data->tb_buf[0] = NULL;
+    data->tb_buf[1] = NULL;
+    data->tb_cap = 0;
+    data->census_path = NULL;
+    data->trace_path = NULL;
+    data->numa = 0;
+    data->cpus = NULL;
+    data->draw_fn = NULL;
+    data->quiet = 0;
+    data->balance = 0;
+    data->cycle = 0;
+    data->inplace = 0;
+    data->ip_buf = NULL;
+    data->ckpt_path = NULL;
+    data->ckpt_every = 0;
+    data->tile_order = NULL;
+}
+
+/*
+Selects the board kernel by its -k name
+    data-> The struct containing information for the game
+    name -> scalar, packed, padded, lut, simd, avx2 or avx512
+    returns: 0 on success, 1 for an unknown name, 2 if the CPU does not
+        have the SIMD instructions it needs
+*/
+int life_kernel(struct gol_data *data, const char *name) {
+
+    data->row_fn = padded_row;
+    data->lut = 0;
+    if (strcmp(name, "scalar") == 0) {
+        data->kernel = KERNEL_SCALAR;
+        data->kernel_name = "scalar";
+    } else if (strcmp(name, "packed") == 0) {
+        data->kernel = KERNEL_PACKED;
+        data->kernel_name = "packed";
+    } else if (strcmp(name, "padded") == 0) {
+        data->kernel = KERNEL_PADDED;
+        data->kernel_name = "padded";
+    } else if (strcmp(name, "lut") == 0) {
+        data->kernel = KERNEL_PADDED;
+        data->kernel_name = "lut";
+        data->lut = 1;
+    } else if (strcmp(name, "simd") == 0 || strcmp(name, "avx2") == 0
+            || strcmp(name, "avx512") == 0) {
+        data->kernel = KERNEL_PADDED;
+        if (simd_select(data, name) != 0) {
+            return 2;
+        }
+    } else {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Points the shared state at data's boards, ready for data->threads
+workers to play them from generation 0
+    data-> The struct containing information for the game
+    shared -> the state to set up (data->shared is pointed at it)
+    live -> the number of live cells on the boards
+    returns: 0 on success, 1 on error
+*/
+int life_share(struct gol_data *data, struct gol_shared *shared,
+        int live) {
+
+    shared->boards[0] = data->gol_board;
+    shared->boards[1] = data->next_board;
+    shared->packed[0] = data->packed_board;
+    shared->packed[1] = data->packed_next;
+    shared->sparse[0] = data->sparse_board;
+    shared->sparse[1] = data->sparse_next;
+    shared->sparse_threads = NULL;
+    shared->cur = 0;
+    shared->round = 0;
+    shared->total_live = live;
+    shared->changed = NULL;
+    shared->active_counts = NULL;
+    shared->census = NULL;
+    shared->trace = NULL;
+    shared->loop_start = 0;
+    shared->loop_end = 0;
+    shared->cuts = NULL;
+    shared->bal_next = NULL;
+    shared->bal_ns = NULL;
+    shared->cycle = NULL;
+    shared->period = 0;
+    shared->ckpt = NULL;
+    shared->render = NULL;
+    shared->edges = NULL;
+    shared->base_gen = 0;
+    spin_barrier_init(&shared->barrier, data->threads);
+    pthread_mutex_init(&shared->print_lock, NULL);
+    data->shared = shared;
+    data->sense = 0;
+
+    shared->counts = aligned_alloc(CACHE_LINE,
+            sizeof(struct census_counts) * data->threads);
+    if (shared->counts == NULL) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+-k lut: builds the rule's table before the threads need it. With no
+table (out of memory, or LUT_RULES rules already have one) padded_round
+plays the board with the row kernel instead, and kernel_name says so.
+    data-> The struct containing information for the game (rule set)
+*/
+static void lut_ready(struct gol_data *data) {
+
+    if (data->kernel == KERNEL_PADDED && data->lut){
+        data->kernel_name = (lut_table(data->rule) != NULL)
+            ? "lut" : "padded (no lut table)";
+    }
+}
+
+/*
+Builds a simulation from a loaded pattern: picks the engine (-e),
+allocates the boards in the selected kernel's representation, places
+the live cells and sets up the shared state and everything the options
+ask for (tiles, -N, -t, -a, -B, -r), ready for the worker threads
+    data-> The struct containing information for the game (options set)
+    shared -> the shared state to set up
+    pat -> the loaded input (its cells are not freed)
+    returns: 0 on success, or one of the LIFE_ERR_* values
+*/
+int life_setup(struct gol_data *data, struct gol_shared *shared,
+        struct pattern *pat) {
+
+    data->rows = pat->rows;
+    data->cols = pat->cols;
+    life_rule(data, pat);
+
+    //HashLife keeps its own tree; the board in between is a cell list
+    if (data->engine == ENGINE_HASHLIFE){
+        data->kernel = KERNEL_SPARSE;
+        data->kernel_name = "hashlife";
+        data->part_mode = 0;
+        data->active = 0;
+        data->balance = 0;
+        data->cycle = 0; // (HashLife skips cycles by itself)
+    }
+    //almost empty board: store only the live cells
+    else if (data->engine == ENGINE_SPARSE || (data->engine == ENGINE_AUTO
+            && (double)pat->live * SPARSE_RATIO
+                < (double)data->rows * data->cols)){
+        data->kernel = KERNEL_SPARSE;
+        data->kernel_name = "sparse";
+        data->part_mode = 0;  // the sparse engine splits by rows
+        data->active = 0;     // and has no empty blocks to skip
+    }
+
+    //-I: only the int boards, in rows (the sparse engine has one list
+    //of live cells per generation already)
+    if (data->kernel == KERNEL_SPARSE){
+        data->inplace = 0;
+    }
+    if (data->inplace && (data->kernel == KERNEL_PACKED
+                || data->part_mode != 0 || data->active || data->tb_k != 0
+                || data->balance)){
+        return LIFE_ERR_INPLACE;
+    }
+    if (data->inplace && data->kernel == KERNEL_SCALAR){
+        // inplace_region plays padded copies of the rows
+        data->kernel_name = "scalar board, padded rows";
+    }
+
+    //allocating both boards as all zeroes (-N: zeroed just below)
+    if (alloc_boards(data) != 0){
+        return LIFE_ERR_ALLOC;
+    }
+    data->tile_order = NULL;
+    if (data->part_mode == 2 && tile_setup(data) != 0){
+        return LIFE_ERR_TILES;
+    }
+
+    //-N: pick the workers' CPUs and fault each share in from its CPU
+    if (data->numa && (numa_setup(data) != 0
+                || numa_first_touch(data) != 0)){
+        return LIFE_ERR_NUMA;
+    }
+
+    //initialize STARTING board with cells
+    init_board(data, pat);
+    if (data->kernel == KERNEL_SPARSE){
+        sparse_finish_load(data);
+    }
+    if (data->kernel == KERNEL_PADDED){
+        padded_fill_halo(data, data->gol_board,
+                0, data->rows - 1, 0, data->cols - 1);
+    }
+    lut_ready(data);
+
+    //temporal blocking: only the dense kernels
+    if (data->kernel == KERNEL_SPARSE){
+        data->tb_k = 0;
+    }
+    if (data->tb_k != 0 && tblock_setup(data) != 0){
+        return LIFE_ERR_TBLOCK;
+    }
+
+    //the threads share one copy of the boards and the barrier
+    if (life_share(data, shared, pat->live) != 0
+            || (data->balance && balance_setup(data) != 0)
+            || (data->active && active_setup(data) != 0)
+            || (data->kernel == KERNEL_SPARSE && sparse_setup(data) != 0)
+            || (data->cycle && cycle_setup(data) != 0)
+            || (data->inplace && inplace_setup(data) != 0)){
+        return LIFE_ERR_ALLOC;
+    }
+    shared->base_gen = pat->generation;
+    return 0;
+}
+
+/*
+Sets the rule to play: the one from -R, otherwise the input's (checked
+by load_buffer), otherwise Conway's
+    data-> The struct containing information for the game
+    pat -> the loaded input
+*/
+void life_rule(struct gol_data *data, struct pattern *pat) {
+
+    if (data->opt_rule != NULL){
+        return;
+    }
+    if (pat->rule[0] == '\0' || rule_parse(pat->rule, &data->rule) != 0){
+        data->rule = RULE_LIFE;
+    }
+}
+
+/*
+Puts a new pattern on the boards life_setup already built, so a run of
+many boards (gol_ensemble) reuses one set of buffers: clears both
+boards, places the cells and starts the shared state over at
+generation 0. Works for every kernel with -a and -r, not with -t or -B.
+    data-> The struct containing information for the game (as
+        life_setup left it, after any number of play_gol runs)
+    pat -> the loaded input (its cells are not freed)
+    returns: 0 on success, 1 if pat needs boards of another size (or
+        -t/-B are on): use life_free and life_setup instead
+*/
+int life_reset(struct gol_data *data, struct pattern *pat) {
+    struct gol_shared *shared = data->shared;
+    size_t n;
+
+    if (pat->rows != data->rows || pat->cols != data->cols
+            || data->tb_k != 0 || data->balance){
+        return 1;
+    }
+    life_rule(data, pat);
+    lut_ready(data);
+    shared->cur = 0;
+    sync_boards(data);
+    if (data->kernel == KERNEL_SPARSE){
+        data->sparse_board->n = 0;
+        data->sparse_next->n = 0;
+    } else if (data->kernel == KERNEL_PACKED){
+        n = (size_t)data->rows * data->words;
+        memset(data->packed_board, 0, n * sizeof(uint64_t));
+        memset(data->packed_next, 0, n * sizeof(uint64_t));
+    } else {
+        n = (data->kernel == KERNEL_PADDED)
+            ? (size_t)(data->rows + 2) * (data->cols + 2)
+            : (size_t)data->rows * data->cols;
+        memset(data->gol_board, 0, n * sizeof(int));
+        memset(data->next_board, 0, n * sizeof(int));
+    }
+
+    init_board(data, pat);
+    if (data->kernel == KERNEL_SPARSE){
+        sparse_finish_load(data);
+    }
+    if (data->kernel == KERNEL_PADDED){
+        padded_fill_halo(data, data->gol_board,
+                0, data->rows - 1, 0, data->cols - 1);
+    }
+    if (shared->edges != NULL){
+        inplace_fill(data);
+    }
+
+    shared->round = 0;
+    shared->base_gen = pat->generation;
+    shared->total_live = pat->live;
+    shared->loop_start = 0;
+    shared->loop_end = 0;
+    if (shared->changed != NULL){
+        active_reset(data);
+    }
+    if (shared->cycle != NULL && cycle_reset(data) != 0){
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Frees the boards and everything life_setup (or life_share) allocated
+    data-> The struct containing information for the game
+*/
+void life_free(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+
+    free(shared->boards[0]);
+    if (shared->boards[1] != shared->boards[0]){
+        free(shared->boards[1]);
+    }
+    free(shared->packed[0]);
+    free(shared->packed[1]);
+    sparse_cleanup(data);
+    sparse_free(shared->sparse[0]);
+    sparse_free(shared->sparse[1]);
+    free(data->tile_order);
+    free(data->cpus);
+    free(shared->changed);
+    free(shared->active_counts);
+    free(shared->counts);
+    free(shared->cuts);
+    free(shared->bal_next);
+    free(shared->bal_ns);
+    free(shared->edges);
+    cycle_free(data);
+    checkpoint_free(data);
+    pthread_mutex_destroy(&shared->print_lock);
+}
+
+/*
+Allocates the current and next boards, with all cells dead, in the
+representation used by the selected kernel
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int alloc_boards(struct gol_data *data) {
+
+    data->gol_board = NULL;
+    data->next_board = NULL;
+    data->packed_board = NULL;
+    data->packed_next = NULL;
+    data->sparse_board = NULL;
+    data->sparse_next = NULL;
+    data->words = 0;
+
+    if (data->kernel == KERNEL_PACKED) {
+        return packed_alloc(data);
+    }
+    if (data->kernel == KERNEL_SPARSE) {
+        return sparse_alloc(data);
+    }
+    if (data->kernel == KERNEL_PADDED) {
+        return padded_alloc(data);
+    }
+
+    data->gol_board = board_alloc(data, (size_t)data->rows * data->cols,
+            sizeof(int));
+    //-I: the next generation is written over the current one
+    data->next_board = data->inplace ? data->gol_board
+        : board_alloc(data, (size_t)data->rows * data->cols, sizeof(int));
+    if (data->gol_board == NULL || data->next_board == NULL) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Returns the value (0/1) of cell (i, j) on the current board
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+int get_cell(struct gol_data *data, int i, int j) {
+
+    if (data->kernel == KERNEL_PACKED) {
+        return packed_get_cell(data, i, j);
+    }
+    if (data->kernel == KERNEL_PADDED) {
+        return padded_get_cell(data, i, j);
+    }
+    if (data->kernel == KERNEL_SPARSE) {
+        return sparse_get_cell(data, i, j);
+    }
+    return data->gol_board[i * data->cols + j];
+}
+
+/*
+Returns the address of row i of an int board (scalar or padded kernel)
+    data-> The struct containing information for the game
+    board -> the board
+    i -> the row
+    returns: a pointer to cell (i, 0); the row's cells follow it
+*/
+int *board_row(struct gol_data *data, int *board, int i) {
+
+    if (data->kernel == KERNEL_PADDED) {
+        return padded_at(data, board, i, 0);
+    }
+    return board + (size_t)i * data->cols;
+}
+
+/*
+Sets cell (i, j) alive on the current board
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+void set_cell(struct gol_data *data, int i, int j) {
+
+    if (data->kernel == KERNEL_PACKED) {
+        packed_set_cell(data, i, j);
+        return;
+    }
+    if (data->kernel == KERNEL_PADDED) {
+        padded_set_cell(data, i, j);
+        return;
+    }
+    if (data->kernel == KERNEL_SPARSE) {
+        sparse_set_cell(data, i, j);
+        return;
+    }
+    data->gol_board[i * data->cols + j] = 1;
+}
+
+/*
+Points a thread's gol_board/next_board (or packed boards) at the shared
+buffers for the current generation. The boards are never copied; only
+shared->cur changes between rounds.
+    data-> The struct containing information for the game
+*/
+void sync_boards(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+
+    data->gol_board = shared->boards[shared->cur];
+    data->next_board = shared->boards[!shared->cur];
+    data->packed_board = shared->packed[shared->cur];
+    data->packed_next = shared->packed[!shared->cur];
+    data->sparse_board = shared->sparse[shared->cur];
+    data->sparse_next = shared->sparse[!shared->cur];
+}
+
+//Function that takes in each struct and changes
+//their start and stop members based on their thread ID 
+
+void partition (struct gol_data *data){
+    int start, end; // the share, in units (see part_units)
+
+    split_range(part_units(data), data->threads, data->ntids,
+            &start, &end);
+    share_bounds(data, start, end, &data->start, &data->end);
+}
+
+/*
+Returns how many units partition splits between the threads: rows,
+columns (whole words for the packed board, so no two threads ever write
+to the same word) or tiles of the Morton ordered tile list
+    data-> The struct containing information for the game
+*/
+int part_units(struct gol_data *data){
+
+    if (data->part_mode == 1){
+        if (data->kernel == KERNEL_PACKED){
+            return data->words;
+        }
+        return data->cols;
+    }
+    if (data->part_mode == 2){
+        return data->ntiles;
+    }
+    return data->rows;
+}
+
+/*
+Converts a share of units u0..u1 (see part_units) to the first and last
+row, column or tile a thread plays (its start and end)
+    data-> The struct containing information for the game
+    u0, u1 -> the first and last unit
+    start, end -> set to the share's bounds
+*/
+void share_bounds(struct gol_data *data, int u0, int u1, int *start,
+        int *end){
+
+    *start = u0;
+    *end = u1;
+    if (data->part_mode == 1 && data->kernel == KERNEL_PACKED){
+        *start = u0 * 64;
+        *end = u1 * 64 + 63;
+        if (*end > data->cols - 1){
+            *end = data->cols - 1;
+        }
+        if (*start > data->cols){
+            //more threads than words: nothing to do
+            *start = data->cols;
+        }
+    }
+}
+
+/*
+Splits units (rows, cols, words or tiles) as evenly as possible between
+threads; the first (units % threads) threads get one extra
+    units -> how many units there are
+    threads -> how many threads share them
+    id -> which thread's share to compute
+    start, end -> set to the first and last unit of the share
+*/
+void split_range(int units, int threads, int id, int *start, int *end){
+    int alloc; // the partitioned number of units
+    int remainder; // number of units that needs to be reassigned
+    int count;
+
+    alloc = (units / threads);
+    remainder = (units % threads);
+    count = remainder - id;
+
+    if (count > 0){
+        *start = (alloc + 1) * id;
+        *end = *start + alloc;
+    }
+    else if (count == 0){
+        *start = (alloc + 1) * id;
+        *end = *start + alloc - 1;
+    }
+    else {
+        *start = id * alloc + remainder;
+        *end = *start + alloc - 1;
+    }
+}
+
+/*
+* Populates the board with the live cells of the loaded input file
+* data -> pointer to gol_data struct
+* pat -> the parsed input file (see load.c)
+*/
+void init_board(struct gol_data *data, struct pattern *pat){
+
+    for (long n = 0; n < pat->ncells; n++){
+        set_cell(data, pat->cells[2 * n], pat->cells[2 * n + 1]);
+    }
+    //a checkpoint: the cells are still in the (mapped) file
+    if (pat->snap_cells != NULL){
+        checkpoint_place(data, pat);
+    }
+}
+
+/* the gol application main loop function:
+ *  runs rounds of GOL,
+ *    * updates program state for next round (world and total_live)
+ *    * performs any animation step based on the output/run mode
+ *
+ *   data: pointer to a struct gol_data  initialized with
+ *         all GOL game playing state
+ */
+void* play_gol(void * arg) {
+    //  at the end of each round of GOL, determine if there is an
+    //  animation step to take based on the output_mode: with ascii or
+    //  ParaVis animation, when the render thread is waiting for a frame,
+    //  copy this thread's share of the new board into it (render.c);
+    //  the render thread draws it (and paces the frames) by itself
+    int diff, first;
+    uint64_t t0 = 0;
+    TRACE_DECL(span);
+  
+    struct gol_data *data = ((struct gol_data *)arg);
+    
+    numa_pin(data);
+    TRACE_START(data, span);
+    pthread_mutex_lock(&data->shared->print_lock);
+    TRACE_END(data, TRACE_LOCK, span, 0);
+    //buffer for printing row/col data
+    diff = data->end - data->start + 1;
+
+
+    if (!data->quiet){
+        printf("Thread ID %d \n", data->ntids);
+    }
+
+    if (data->print_config == 1){
+        if (data->part_mode == 0){
+
+            
+            printf("ntid %d:  ", data->ntids);
+            printf("rows: %d:%d (%d)  ", data->start, data->end, diff);
+            printf("cols: 0:%d (%d) \n", data->cols - 1, data->cols);
+            
+        }
+        if (data->part_mode == 1){
+
+    
+            printf("ntid %d:  ", data->ntids);
+            printf("rows: 0:%d (%d) ", data->rows - 1, data->rows);
+            printf("cols: %d:%d (%d) \n", data->start, data->end, diff);
+
+        }
+        if (data->part_mode == 2){
+            tile_print_config(data);
+        }
+    }
+
+    pthread_mutex_unlock(&data->shared->print_lock);
+
+    //start the generations together, so loop_start..loop_end times
+    //only them (not thread creation or the printing above)
+    spin_barrier_wait(&data->shared->barrier, &data->sense,
+            start_loop, data);
+
+    //count the rounds in shared->round: end_round may skip ahead (-r)
+    first = data->shared->round;
+    for (int i = 0; i < data->iters; i = data->shared->round - first){
+
+        //play one round (with -t, up to tb_k rounds at once)
+        if (data->tb_k > 0){
+            data->tb_steps = (data->iters - i < data->tb_k)
+                ? data->iters - i : data->tb_k;
+        }
+        TRACE_START(data, span);
+        if (data->balance){
+            t0 = trace_now();
+        }
+        play_round(data);
+        if (data->balance){
+            //for balance_round, which may move this thread's share
+            data->shared->counts[data->ntids].ns = trace_now() - t0;
+        }
+        TRACE_END(data, TRACE_COMPUTE, span, i);
+
+        //animation: this thread's share of the frame, if one is due
+        if (data->shared->render != NULL){
+            TRACE_START(data, span);
+            render_share(data);
+            TRACE_END(data, TRACE_RENDER, span, i);
+        }
+
+        //one barrier per round: the last thread to finish flips the
+        //shared boards (and hands a filled frame on) before anyone goes on
+        TRACE_START(data, span);
+        spin_barrier_wait(&data->shared->barrier, &data->sense,
+                end_round, data);
+        TRACE_END(data, TRACE_BARRIER, span, i);
+        sync_boards(data);
+        if (data->balance){
+            balance_apply(data);
+        }
+    }
+    tblock_free(data);
+    inplace_free(data);
+
+   return 0; 
+    
+}
+
+/*
+Runs in the last thread to reach the barrier before the first round:
+starts the clock for the generation loop, sets the round it ends at and
+whether the first round ends on a checkpoint (-s) or fills a frame
+    arg-> the struct gol_data of the thread that arrived last
+*/
+void start_loop(void *arg) {
+    struct gol_data *data = (struct gol_data *)arg;
+
+    data->shared->stop = data->shared->round + data->iters;
+    if (data->shared->ckpt != NULL){
+        checkpoint_plan(data);
+    }
+    if (data->shared->render != NULL){
+        render_plan(data);
+    }
+    data->shared->loop_start = trace_now();
+}
+
+/*
+Runs in the last thread to reach the end-of-round barrier while all the
+others wait: adds the threads' live cell changes to total_live (and
+writes the census), makes next_board the current board for everybody,
+with -r skips ahead once the board repeats, with -s hands a checkpoint
+to its writer, with animation hands a filled frame to the render
+thread, and with -B moves the partition.
+    arg-> the struct gol_data of the thread that arrived last
+*/
+void end_round(void *arg) {
+    struct gol_data *data = (struct gol_data *)arg;
+    TRACE_DECL(span);
+
+    TRACE_START(data, span);
+
+    //no lock: every other thread is waiting at the barrier
+    for (int t = 0; t < data->threads; t++){
+        data->shared->total_live += data->shared->counts[t].live;
+    }
+
+    //sparse engine: gather the threads' live cells into the next list
+    if (data->kernel == KERNEL_SPARSE){
+        sparse_merge(data);
+    }
+
+    data->shared->cur = !data->shared->cur;
+    data->shared->round += data->tb_steps;
+    if (data->shared->cycle != NULL){
+        cycle_round(data);
+    }
+    if (data->shared->ckpt != NULL){
+        checkpoint_round(data);
+    }
+    if (data->shared->render != NULL){
+        render_round(data);
+    }
+    if (data->shared->round >= data->shared->stop){
+        data->shared->loop_end = trace_now();
+    }
+    if (data->balance){
+        balance_round(data);
+    }
+    if (data->shared->census != NULL){
+        census_round(data, data->shared->total_live);
+    }
+
+    TRACE_END(data, TRACE_SERIAL, span,
+            data->shared->round - data->tb_steps);
+}
+
+/*
+Plays one round on this thread's share of the board (its rows, its
+columns or its tiles) with the selected kernel and leaves the change in
+live cells in the thread's counts for end_round. With -a the share is
+played block by block, skipping the blocks that cannot change. With -t
+the share is played data->tb_steps generations ahead in cache-sized
+tiles instead.
+    data-> The struct containing information for the game 
+*/
+void play_round(struct gol_data *data){
+    int live = 0;
+    int r0, r1, c0, c1;
+    int (*region)(struct gol_data *, int, int, int, int);
+
+    region = data->active ? active_region : play_region;
+    if (data->tb_k > 0){
+        region = tblock_region;
+    }
+    if (data->inplace){
+        region = inplace_region;
+    }
+
+    if(data->part_mode == 0){
+        live = region(data, data->start, data->end,
+                0, data->cols - 1);
+    }
+
+    if(data->part_mode == 1){
+        live = region(data, 0, data->rows - 1,
+                data->start, data->end);
+    }
+
+    if(data->part_mode == 2){
+        for (int k = data->start; k <= data->end; k++){
+            tile_bounds(data, k, &r0, &r1, &c0, &c1);
+            live += region(data, r0, r1, c0, c1);
+        }
+    }
+
+    //this thread's cache line only; end_round adds them up
+    data->shared->counts[data->ntids].live = live;
+    if (data->shared->census != NULL){
+        census_share(data);
+    }
+    if (data->shared->cycle != NULL && data->shared->period == 0){
+        cycle_share(data);
+    }
+    if (data->shared->ckpt != NULL){
+        checkpoint_share(data);
+    }
+}
+
+/*
+Plays one round on the rectangle rows r0..r1, cols c0..c1 with the
+selected kernel (for the packed board, c0 and c1 + 1 must be word aligned
+or the board edges)
+    data-> The struct containing information for the game 
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+    returns: the change in the number of live cells in the rectangle
+*/
+int play_region(struct gol_data *data, int r0, int r1, int c0, int c1){
+
+    if (r0 > r1 || c0 > c1){
+        //(threads past the last row/col/word have an empty range; with
+        //-B a sparse thread can lose its rows, and sparse_merge would
+        //merge the result list it left in an earlier round)
+        if(data->kernel == KERNEL_SPARSE){
+            sparse_result(data)->n = 0;
+        }
+        return 0;
+    }
+
+    //bit-packed board: whole words of cells at a time
+    if(data->kernel == KERNEL_PACKED){
+        return packed_round(data, r0, r1, c0 / 64, c1 / 64);
+    }
+
+    //padded board: branch-free stencil, halo instead of wrapping
+    if(data->kernel == KERNEL_PADDED){
+        return padded_round(data, r0, r1, c0, c1);
+    }
+
+    //sparse engine: whole rows (it always partitions by rows)
+    if(data->kernel == KERNEL_SPARSE){
+        return sparse_round(data, r0, r1);
+    }
+
+    return scalar_round(data, r0, r1, c0, c1);
+}
+
+/*
+Checks whether any cell of the rectangle rows r0..r1, cols c0..c1 differs
+between the current board and the next board (same alignment rules as
+play_region)
+    data-> The struct containing information for the game 
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+    returns: 1 if something changed, 0 if not
+*/
+int region_changed(struct gol_data *data, int r0, int r1, int c0, int c1){
+
+    if(data->kernel == KERNEL_PACKED){
+        return packed_changed(data, r0, r1, c0 / 64, c1 / 64);
+    }
+
+    if(data->kernel == KERNEL_PADDED){
+        return padded_changed(data, r0, r1, c0, c1);
+    }
+
+    for (int i=r0; i<=r1; i++){
+        if (memcmp(&data->gol_board[i * data->cols + c0],
+                    &data->next_board[i * data->cols + c0],
+                    sizeof(int) * (c1 - c0 + 1)) != 0){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+Gets the neighbor counts for every cell using the helper function count_neighbors
+and then sets the value of each cell accordingly. To keep every cell 
+independent, it checks the neighbors of the board from the beginning of
+the round and writes the results into next_board.
+    data-> The struct containing information for the game 
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+    returns: the change in the number of live cells in the rectangle
+*/
+int scalar_round(struct gol_data *data, int r0, int r1, int c0, int c1){
+    int neighbors;
+    int live = 0;
+
+    for (int i=r0; i<=r1; i++){
+        for (int j=c0; j<=c1; j++){
+
+            
+            //for dead cell
+            if (data->gol_board[i * data->cols + j] == 0){
+                neighbors = count_neighbors( data, i, j);
+
+                if (RULE_BORN(data->rule, neighbors)){
+                    data->next_board[i * data->cols + j] = 1;
+
+                    live += 1; 
+                }
+
+                else {
+                    data->next_board[i * data->cols + j] = 0;
+                }
+            }
+            
+            
+                //living cell
+            else if (data->gol_board[i * data->cols + j] == 1){
+
+                neighbors = count_neighbors( data, i, j);
+
+                if (RULE_STAYS(data->rule, neighbors)){
+                    //the cell stays alive
+                    data->next_board[i * data->cols + j] = 1;
+                }
+
+
+                else{
+                    //the alive cell dies
+                    data->next_board[i * data->cols + j] = 0;
+                    live -= 1;
+                }
+                
+            }
+        }
+    }
+
+    return live;
+}
+
+
+
+
+
+
+/*
+counts how many of a cell's neighbors are alive using addition
+    data-> The struct containing information for the game 
+    copy-> a copy of the playing board from the beginning of the round
+    i -> the row data of the cell whos neighbor is being counted
+    j -> the column data of said cell
+*/
+int count_neighbors( struct gol_data *data, int i, int j) {
+    int count = 0;
+    
+    // Top row neighbors
+
+
+    count = data->gol_board[(((i-1) + data->rows)  % data->rows) * data->cols + (((j-1)+ data->cols) % data->cols)] +  // Top left
+            data->gol_board[(((i-1)+ data->rows) % data->rows) * data->cols + ((j + data->cols) % data->cols)] +                       // Top center
+            data->gol_board[(((i-1)+ data->rows) % data->rows) * data->cols + (((j+1)+ data->cols) % data->cols)] +   // Top right
+            
+            // Middle row neighbors
+            data->gol_board[((i+ data->rows) % data->rows) * data->cols + (((j-1)+ data->cols) % data->cols)] +       // Middle left
+            data->gol_board[((i+ data->rows) % data->rows) * data->cols + (((j+1)+ data->cols) % data->cols)] +       // Middle right
+            
+            // Bottom row neighbors
+            data->gol_board[(((i+1)+ data->rows) % data->rows) * data->cols + (((j-1)+ data->cols) % data->cols)] +   // Bottom left
+            data->gol_board[(((i+1)+ data->rows) % data->rows) * data->cols + ((j + data->cols) % data->cols)] +                    // Bottom center
+            data->gol_board[(((i+1)+ data->rows) % data->rows) * data->cols + (((j+1)+ data->cols) % data->cols)];    // Bottom right
+    
+
+
+    return count;
+}
+
+/*  
+Sets all of the values in the copy array equal to the playing board
+    data-> The struct containing information for the game 
+    copy-> a copy of the playing board from the beginning of the round
+ */
+void update_copy(struct gol_data *data){
+    
+    for (int i=0; i<data->rows; i++){
+            for (int j=0; j<data->cols; j++){
+                //copy over all values
+                data->next_board[i * data->cols + j] = data->gol_board[i * data->cols + j];
+            }
+        }
+        
+   
+};
+
+/**************************************************************/
+
+/* Print the board to the terminal.
+ *   data: gol game specific data
+ *   round: the current round number
+ * NOTE: You may add extra printfs if you'd like, but please
+ *       leave these fprintf calls exactly as they are to make
+ *       grading easier!
+ */
+void print_board(struct gol_data *data, int round) {
+
+    int i, j;
+
+    /* Print the round number. */
+    fprintf(stderr, "Round: %d\n", round);
+
+    for (i = 0; i < data->rows; ++i) {
+        for (j = 0; j < data->cols; ++j) {
+            if (get_cell(data, i, j) == 1){
+                fprintf(stderr, " @");
+            }
+            else {
+                fprintf(stderr, " .");
+            }
+          
+          
+        }
+        fprintf(stderr, "\n");
+    }
+
+    /* Print the total number of live cells. */
+    fprintf(stderr, "Live cells: %d\n\n", data->shared->total_live);
+}
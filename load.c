@@ -0,0 +1,648 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Input file loader. The whole file is mapped (or, if it cannot be, read
+in one go) and parsed in a single pass into a list of live cells, so
+loading costs O(file size) no matter how big the board is. Four formats
+are understood, plus gol's own binary checkpoints (see checkpoint.c):
+  - the lab format: rows cols iters live, then live "row col" pairs
+  - RLE (.rle, or a file starting with #-comments and "x = ...")
+  - plaintext (.cells, or a file starting with "!"): '.' dead, 'O' alive
+  - Life 1.06 (a file starting with "#Life 1.06"): "x y" per live cell
+Only the lab format gives the board size and the number of iterations;
+for the others they come from -b and -i, and default to the pattern's
+own size and DEFAULT_ITERS. The pattern is centered on the board.
+Malformed input is reported with the file name and line number. A
+checkpoint is not turned into a list: its file stays mapped and the
+board is filled straight from it (checkpoint_place).
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gol.h"
+
+/* iterations for formats that do not give them (unless -i is used) */
+#define DEFAULT_ITERS (100)
+
+/* file formats */
+#define FMT_LAB     (0)
+#define FMT_RLE     (1)
+#define FMT_CELLS   (2)
+#define FMT_LIFE106 (3)
+#define FMT_CHECKPOINT (4)
+
+/* read position in the file being parsed */
+struct cursor {
+    const char *p; // next character
+    const char *end; // one past the last character
+    const char *path; // for error messages
+    int line; // line number of p
+};
+
+/*
+Prints an error at the cursor's line
+    c -> the cursor
+    msg -> what went wrong
+    returns: 1 (so callers can return parse_error(...))
+*/
+static int parse_error(struct cursor *c, const char *msg) {
+
+    printf("%s:%d: %s\n", c->path, c->line, msg);
+    return 1;
+}
+
+/* skips spaces, tabs and line ends (counting lines) */
+static void skip_blanks(struct cursor *c) {
+
+    while (c->p < c->end && isspace((unsigned char)*c->p)) {
+        if (*c->p == '\n') {
+            c->line++;
+        }
+        c->p++;
+    }
+}
+
+/* skips the rest of the current line, including its '\n' */
+static void skip_line(struct cursor *c) {
+
+    while (c->p < c->end && *c->p != '\n') {
+        c->p++;
+    }
+    if (c->p < c->end) {
+        c->p++;
+        c->line++;
+    }
+}
+
+/* skips spaces and tabs but not line ends */
+static void skip_spaces(struct cursor *c) {
+
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t'
+                || *c->p == '\r')) {
+        c->p++;
+    }
+}
+
+/*
+Reads an optionally signed decimal number
+    c -> the cursor (blanks before the number are skipped)
+    v -> set to the number
+    returns: 0 on success, 1 if there is no number here
+*/
+static int read_long(struct cursor *c, long *v) {
+    long sign, x;
+    int digits;
+
+    skip_blanks(c);
+    sign = 1;
+    if (c->p < c->end && (*c->p == '-' || *c->p == '+')) {
+        sign = (*c->p == '-') ? -1 : 1;
+        c->p++;
+    }
+    x = 0;
+    digits = 0;
+    while (c->p < c->end && isdigit((unsigned char)*c->p)) {
+        if (x > 1000000000000L) {
+            return 1;
+        }
+        x = x * 10 + (*c->p - '0');
+        c->p++;
+        digits++;
+    }
+    if (digits == 0) {
+        return 1;
+    }
+    // "12abc" is not a number either
+    if (c->p < c->end && !isspace((unsigned char)*c->p)) {
+        return 1;
+    }
+    *v = sign * x;
+    return 0;
+}
+
+/*
+Adds a live cell to the pattern
+    pat -> the pattern
+    row, col -> the cell
+    returns: 0 on success, 1 on error
+*/
+static int add_cell(struct pattern *pat, long row, long col) {
+    long *cells;
+    long cap;
+
+    if (pat->ncells == pat->cap) {
+        cap = (pat->cap < 1024) ? 1024 : 2 * pat->cap;
+        cells = realloc(pat->cells, sizeof(long) * 2 * cap);
+        if (cells == NULL) {
+            return 1;
+        }
+        pat->cells = cells;
+        pat->cap = cap;
+    }
+    pat->cells[2 * pat->ncells] = row;
+    pat->cells[2 * pat->ncells + 1] = col;
+    pat->ncells++;
+    return 0;
+}
+
+/*
+Parses the lab format: rows cols iters live, then the live cells
+    c -> the cursor at the start of the file
+    data-> The struct containing information for the game (-b, -i)
+    pat -> filled in
+    returns: 0 on success, 1 on error
+*/
+static int parse_lab(struct cursor *c, struct gol_data *data,
+        struct pattern *pat) {
+    long rows, cols, iters, live, n, row, col;
+    char msg[128];
+
+    if (read_long(c, &rows) != 0 || rows < 1) {
+        return parse_error(c, "expected the number of rows");
+    }
+    if (read_long(c, &cols) != 0 || cols < 1) {
+        return parse_error(c, "expected the number of columns");
+    }
+    if (read_long(c, &iters) != 0 || iters < 0) {
+        return parse_error(c, "expected the number of iterations");
+    }
+    if (read_long(c, &live) != 0 || live < 0) {
+        return parse_error(c, "expected the number of live cells");
+    }
+    pat->rows = (data->opt_rows > 0) ? data->opt_rows : rows;
+    pat->cols = (data->opt_cols > 0) ? data->opt_cols : cols;
+    pat->iters = (data->opt_iters >= 0) ? data->opt_iters : iters;
+    pat->live = live;
+
+    for (n = 0; n < live; n++) {
+        if (read_long(c, &row) != 0 || read_long(c, &col) != 0) {
+            snprintf(msg, sizeof(msg), "expected the row and column of live "
+                    "cell %ld of %ld", n + 1, live);
+            return parse_error(c, msg);
+        }
+        if (row < 0 || row >= pat->rows || col < 0 || col >= pat->cols) {
+            snprintf(msg, sizeof(msg), "cell (%ld, %ld) is outside the "
+                    "%d x %d board", row, col, pat->rows, pat->cols);
+            return parse_error(c, msg);
+        }
+        if (add_cell(pat, row, col) != 0) {
+            return parse_error(c, "out of memory");
+        }
+    }
+    return 0;
+}
+
+/*
+Reads a number from an RLE header value
+    val -> the value's text
+    len -> its length
+    returns: the number, or -1 if the value is not one
+*/
+static long header_number(const char *val, int len) {
+    long x;
+    int i;
+
+    if (len == 0 || len > 10) {
+        return -1;
+    }
+    x = 0;
+    for (i = 0; i < len; i++) {
+        if (!isdigit((unsigned char)val[i])) {
+            return -1;
+        }
+        x = x * 10 + (val[i] - '0');
+    }
+    return x;
+}
+
+/*
+Parses an RLE file: #-comment lines, a "x = w, y = h[, rule = r]"
+header, then runs of b (dead), o (alive) and $ (end of row) up to '!'
+    c -> the cursor at the start of the file
+    pat -> filled in (cells relative to the pattern's corner)
+    returns: 0 on success, 1 on error
+*/
+static int parse_rle(struct cursor *c, struct pattern *pat) {
+    const char *key, *val;
+    long w, h, run, x, y, k;
+    int klen, vlen;
+
+    // comments
+    skip_blanks(c);
+    while (c->p < c->end && *c->p == '#') {
+        skip_line(c);
+        skip_blanks(c);
+    }
+
+    // header: comma separated key = value pairs on one line
+    w = -1;
+    h = -1;
+    for (;;) {
+        skip_spaces(c);
+        if (c->p >= c->end || *c->p == '\n') {
+            break;
+        }
+        key = c->p;
+        while (c->p < c->end && isalpha((unsigned char)*c->p)) {
+            c->p++;
+        }
+        klen = (int)(c->p - key);
+        skip_spaces(c);
+        if (klen == 0 || c->p >= c->end || *c->p != '=') {
+            return parse_error(c, "expected an RLE header "
+                    "\"x = <cols>, y = <rows>\"");
+        }
+        c->p++;
+        skip_spaces(c);
+        val = c->p;
+        while (c->p < c->end && *c->p != ',' && *c->p != '\n'
+                && *c->p != '\r') {
+            c->p++;
+        }
+        vlen = (int)(c->p - val);
+        while (vlen > 0 && isspace((unsigned char)val[vlen - 1])) {
+            vlen--;
+        }
+        if (klen == 1 && *key == 'x') {
+            w = header_number(val, vlen);
+        } else if (klen == 1 && *key == 'y') {
+            h = header_number(val, vlen);
+        } else if (klen == 4 && strncmp(key, "rule", 4) == 0) {
+            if (vlen >= (int)sizeof(pat->rule)) {
+                return parse_error(c, "rule is too long");
+            }
+            memcpy(pat->rule, val, vlen);
+            pat->rule[vlen] = '\0';
+        }
+        skip_spaces(c);
+        if (c->p < c->end && *c->p == ',') {
+            c->p++;
+        }
+    }
+    if (w < 1 || h < 1) {
+        return parse_error(c, "RLE header needs x and y of at least 1");
+    }
+    pat->height = h;
+    pat->width = w;
+
+    // body
+    x = 0;
+    y = 0;
+    for (;;) {
+        skip_blanks(c);
+        if (c->p >= c->end) {
+            return parse_error(c, "RLE pattern does not end with '!'");
+        }
+        run = 1;
+        if (isdigit((unsigned char)*c->p)) {
+            run = 0;
+            while (c->p < c->end && isdigit((unsigned char)*c->p)) {
+                run = run * 10 + (*c->p - '0');
+                if (run > 1000000000L) {
+                    return parse_error(c, "run length is too large");
+                }
+                c->p++;
+            }
+            skip_blanks(c);
+            if (c->p >= c->end) {
+                return parse_error(c, "run length at the end of the file");
+            }
+        }
+        switch (*c->p) {
+        case 'b':
+            x += run;
+            break;
+        case 'o':
+            if (x + run > w || y >= h) {
+                return parse_error(c, "live cell outside the x/y size "
+                        "given in the header");
+            }
+            for (k = 0; k < run; k++) {
+                if (add_cell(pat, y, x + k) != 0) {
+                    return parse_error(c, "out of memory");
+                }
+            }
+            x += run;
+            break;
+        case '$':
+            y += run;
+            x = 0;
+            break;
+        case '!':
+            c->p++;
+            return 0;
+        default:
+            return parse_error(c, "unexpected character in RLE data "
+                    "(expected b, o, $ or !)");
+        }
+        c->p++;
+    }
+}
+
+/*
+Parses a plaintext (.cells) file: !-comment lines, then one line per
+row with '.' for dead and 'O' (or '*') for live cells
+    c -> the cursor at the start of the file
+    pat -> filled in (cells relative to the pattern's corner)
+    returns: 0 on success, 1 on error
+*/
+static int parse_cells(struct cursor *c, struct pattern *pat) {
+    long x, y;
+
+    y = 0;
+    while (c->p < c->end) {
+        if (*c->p == '!') {
+            skip_line(c);
+            continue;
+        }
+        x = 0;
+        while (c->p < c->end && *c->p != '\n') {
+            if (*c->p == 'O' || *c->p == '*') {
+                if (add_cell(pat, y, x) != 0) {
+                    return parse_error(c, "out of memory");
+                }
+                x++;
+            } else if (*c->p == '.') {
+                x++;
+            } else if (*c->p != '\r' && *c->p != ' ' && *c->p != '\t') {
+                return parse_error(c, "unexpected character in plaintext "
+                        "pattern (expected . or O)");
+            }
+            c->p++;
+        }
+        // (trailing empty lines are not part of the pattern)
+        if (x > 0) {
+            pat->height = y + 1;
+        }
+        if (x > pat->width) {
+            pat->width = x;
+        }
+        y++;
+        skip_line(c);
+    }
+    if (pat->height == 0) {
+        pat->height = 1;
+    }
+    if (pat->width == 0) {
+        pat->width = 1;
+    }
+    return 0;
+}
+
+/*
+Parses a Life 1.06 file: the "#Life 1.06" line, then "x y" (column,
+row) for every live cell; coordinates may be negative
+    c -> the cursor at the start of the file
+    pat -> filled in (cells relative to the pattern's corner)
+    returns: 0 on success, 1 on error
+*/
+static int parse_life106(struct cursor *c, struct pattern *pat) {
+    long x, y, minx, miny, maxx, maxy, n;
+
+    skip_line(c);
+    minx = miny = 0;
+    maxx = maxy = -1;
+    for (;;) {
+        skip_blanks(c);
+        if (c->p >= c->end) {
+            break;
+        }
+        if (*c->p == '#') {
+            skip_line(c);
+            continue;
+        }
+        if (read_long(c, &x) != 0 || read_long(c, &y) != 0) {
+            return parse_error(c, "expected the x and y of a live cell");
+        }
+        if (maxx < minx) {
+            minx = maxx = x;
+            miny = maxy = y;
+        }
+        minx = (x < minx) ? x : minx;
+        maxx = (x > maxx) ? x : maxx;
+        miny = (y < miny) ? y : miny;
+        maxy = (y > maxy) ? y : maxy;
+        if (add_cell(pat, y, x) != 0) {
+            return parse_error(c, "out of memory");
+        }
+    }
+
+    // move the bounding box to (0, 0)
+    for (n = 0; n < pat->ncells; n++) {
+        pat->cells[2 * n] -= miny;
+        pat->cells[2 * n + 1] -= minx;
+    }
+    pat->height = (maxy >= miny) ? maxy - miny + 1 : 1;
+    pat->width = (maxx >= minx) ? maxx - minx + 1 : 1;
+    return 0;
+}
+
+/*
+Works out the file format from its name and first characters
+    path -> the file name
+    c -> the cursor at the start of the file (not moved)
+    returns: one of the FMT_* values
+*/
+static int detect_format(const char *path, struct cursor *c) {
+    const char *ext, *p;
+    size_t left;
+
+    if (c->end - c->p >= 8 && memcmp(c->p, CHECKPOINT_MAGIC, 8) == 0) {
+        return FMT_CHECKPOINT;
+    }
+    p = c->p;
+    while (p < c->end && isspace((unsigned char)*p)) {
+        p++;
+    }
+    left = c->end - p;
+    if (left >= 10 && strncmp(p, "#Life 1.06", 10) == 0) {
+        return FMT_LIFE106;
+    }
+
+    ext = strrchr(path, '.');
+    if (ext != NULL && strcmp(ext, ".rle") == 0) {
+        return FMT_RLE;
+    }
+    if (ext != NULL && strcmp(ext, ".cells") == 0) {
+        return FMT_CELLS;
+    }
+    if (left > 0 && *p == '!') {
+        return FMT_CELLS;
+    }
+    if (left > 0 && (*p == '#' || *p == 'x')) {
+        return FMT_RLE;
+    }
+    return FMT_LAB;
+}
+
+/*
+Parses an input held in memory into a list of live cells and works out
+the board size and number of iterations (see the top of this file)
+    buf -> the input (need not end in '\0')
+    len -> its length in bytes
+    name -> a file name for it: its extension picks the format as for
+        a file, and it is used in error messages
+    data-> The struct containing information for the game (-b, -i)
+    pat -> filled in; release with free_pattern
+    returns: 0 on success, 1 on error (the error has been printed)
+*/
+int load_buffer(const char *buf, size_t len, const char *name,
+        struct gol_data *data, struct pattern *pat) {
+    struct cursor c;
+    char msg[128];
+    long n;
+    int fmt, ret, off_r, off_c;
+    unsigned rule;
+
+    memset(pat, 0, sizeof(*pat));
+    c.p = buf;
+    c.end = buf + len;
+    c.path = name;
+    c.line = 1;
+
+    fmt = detect_format(name, &c);
+    if (fmt == FMT_LAB) {
+        ret = parse_lab(&c, data, pat);
+    } else if (fmt == FMT_RLE) {
+        ret = parse_rle(&c, pat);
+    } else if (fmt == FMT_CELLS) {
+        ret = parse_cells(&c, pat);
+    } else if (fmt == FMT_CHECKPOINT) {
+        ret = checkpoint_parse(buf, len, name, data, pat);
+    } else {
+        ret = parse_life106(&c, pat);
+    }
+
+    if (ret != 0) {
+        free_pattern(pat);
+        return 1;
+    }
+    if (pat->rule[0] != '\0' && rule_parse(pat->rule, &rule) != 0) {
+        printf("%s: rule %s is not supported (B/S rules without B0)\n",
+                name, pat->rule);
+        free_pattern(pat);
+        return 1;
+    }
+    if (fmt == FMT_LAB || fmt == FMT_CHECKPOINT) {
+        return 0;
+    }
+
+    // patterns without a board: -b (or the pattern itself), centered
+    pat->rows = (data->opt_rows > 0) ? data->opt_rows : pat->height;
+    pat->cols = (data->opt_cols > 0) ? data->opt_cols : pat->width;
+    pat->iters = (data->opt_iters >= 0) ? data->opt_iters : DEFAULT_ITERS;
+    pat->live = pat->ncells;
+    if (pat->height > pat->rows || pat->width > pat->cols) {
+        snprintf(msg, sizeof(msg), "%s: the pattern is %ld x %ld, bigger "
+                "than the %d x %d board (see -b)", name, pat->height,
+                pat->width, pat->rows, pat->cols);
+        printf("%s\n", msg);
+        free_pattern(pat);
+        return 1;
+    }
+    off_r = (pat->rows - pat->height) / 2;
+    off_c = (pat->cols - pat->width) / 2;
+    for (n = 0; n < pat->ncells; n++) {
+        pat->cells[2 * n] += off_r;
+        pat->cells[2 * n + 1] += off_c;
+    }
+    return 0;
+}
+
+/*
+Loads the input file into a list of live cells (see load_buffer)
+    path -> the input file
+    data-> The struct containing information for the game (-b, -i)
+    pat -> filled in; release with free_pattern
+    returns: 0 on success, 1 on error (the error has been printed)
+*/
+int load_pattern(const char *path, struct gol_data *data,
+        struct pattern *pat) {
+    struct stat st;
+    const char *p;
+    char *buf;
+    void *map;
+    ssize_t got;
+    size_t have;
+    int fd, ret;
+
+    memset(pat, 0, sizeof(*pat));
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        printf("Unable to open provided file %s\n", path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+
+    // map the file; fall back to reading it into one buffer
+    buf = NULL;
+    map = MAP_FAILED;
+    if (st.st_size > 0) {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (map != MAP_FAILED) {
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        p = map;
+        have = st.st_size;
+    } else {
+        buf = malloc(st.st_size + 1);
+        have = 0;
+        while (buf != NULL && have < (size_t)st.st_size) {
+            got = read(fd, buf + have, st.st_size - have);
+            if (got <= 0) {
+                break;
+            }
+            have += got;
+        }
+        p = buf;
+    }
+    close(fd);
+    if (st.st_size > 0 && p == NULL) {
+        printf("Unable to read provided file %s\n", path);
+        return 1;
+    }
+
+    ret = load_buffer(p, have, path, data, pat);
+
+    // a checkpoint's cells are used where they are: keep the memory
+    if (ret == 0 && pat->snap_cells != NULL) {
+        pat->store = (map != MAP_FAILED) ? map : (void *)buf;
+        pat->store_len = (map != MAP_FAILED) ? (size_t)st.st_size : 0;
+        return 0;
+    }
+    if (map != MAP_FAILED) {
+        munmap(map, st.st_size);
+    }
+    free(buf);
+    return ret;
+}
+
+/*
+Frees the cell list of a pattern (and a checkpoint's file)
+    pat -> the pattern
+*/
+void free_pattern(struct pattern *pat) {
+
+    free(pat->cells);
+    pat->cells = NULL;
+    pat->ncells = 0;
+    pat->cap = 0;
+    if (pat->store != NULL && pat->store_len > 0) {
+        munmap(pat->store, pat->store_len);
+    } else {
+        free(pat->store);
+    }
+    pat->store = NULL;
+    pat->snap_cells = NULL;
+}
@@ -0,0 +1,219 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Lookup table kernel for the padded board (-k lut). Cells are played in
+2x2 blocks: the 4x4 neighborhood of a block (one cell around it) is
+packed into a 16-bit index, and one byte of a 64K-entry table gives the
+block's next four states and its change in live cells. The index is
+built from column nibbles (the four cells of one column of the
+neighborhood, top row in bit 0), and the next block to the right shares
+two columns with this one, so each block shifts the index by one byte
+and loads only two new columns: 8 loads and one table read per 4 cells,
+where the stencil does 9 loads per cell.
+
+There is one table per rule, built on first use (life_setup builds it
+before the threads start) and kept for the life of the process, so the
+threads, and every simulation in the process with the same rule, share
+its 64 KB (it stays in L2). A region with an odd number of rows or
+columns plays its last row or column with the row kernel (row_fn).
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "gol.h"
+
+/* most rules with a table in one process */
+#define LUT_RULES (8)
+
+/* columns whose nibbles are built at a time (even) */
+#define LUT_CHUNK (256)
+
+/* table entry: bit 0 the block's top left cell, bit 1 top right, bit 2
+ * bottom left, bit 3 bottom right; bits 4-7 the change in live cells
+ * plus 4 */
+#define LUT_DELTA_SHIFT (4)
+
+/* The tables built so far. Entries below lut_count never change, so
+ * lookups read them with no lock; lut_lock is taken only to add one. */
+static struct {
+    unsigned rule;
+    uint8_t *table;
+} lut_cache[LUT_RULES];
+static int lut_count;
+static pthread_mutex_t lut_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+Fills a table for one rule
+    table -> 65536 entries
+    rule -> the rule (see rule.c)
+*/
+static void lut_fill(uint8_t *table, unsigned rule) {
+    int idx, r, c, dr, dc, n, alive, next, delta, entry;
+
+    for (idx = 0; idx < 65536; idx++) {
+        entry = 0;
+        delta = 0;
+        // (r, c): the block's cells, rows and columns 1-2 of the index
+        for (r = 1; r <= 2; r++) {
+            for (c = 1; c <= 2; c++) {
+                n = 0;
+                for (dr = -1; dr <= 1; dr++) {
+                    for (dc = -1; dc <= 1; dc++) {
+                        if (dr != 0 || dc != 0) {
+                            n += (idx >> (4 * (c + dc) + r + dr)) & 1;
+                        }
+                    }
+                }
+                alive = (idx >> (4 * c + r)) & 1;
+                next = RULE_NEXT(rule, alive, n);
+                entry |= next << (2 * (r - 1) + (c - 1));
+                delta += next - alive;
+            }
+        }
+        table[idx] = (uint8_t)(entry | ((delta + 4) << LUT_DELTA_SHIFT));
+    }
+}
+
+/*
+Returns the table for a rule, building it the first time
+    rule -> the rule (see rule.c)
+    returns: the table, or NULL if it cannot be built (out of memory, or
+        LUT_RULES rules already have one)
+*/
+const uint8_t *lut_table(unsigned rule) {
+    uint8_t *table;
+    int k, n;
+
+    n = __atomic_load_n(&lut_count, __ATOMIC_ACQUIRE);
+    for (k = 0; k < n; k++) {
+        if (lut_cache[k].rule == rule) {
+            return lut_cache[k].table;
+        }
+    }
+
+    pthread_mutex_lock(&lut_lock);
+    table = NULL;
+    for (k = 0; k < lut_count && table == NULL; k++) {
+        if (lut_cache[k].rule == rule) {
+            table = lut_cache[k].table;
+        }
+    }
+    if (table == NULL && lut_count < LUT_RULES) {
+        table = aligned_alloc(CACHE_LINE, 65536);
+        if (table != NULL) {
+            lut_fill(table, rule);
+            lut_cache[lut_count].rule = rule;
+            lut_cache[lut_count].table = table;
+            __atomic_store_n(&lut_count, lut_count + 1, __ATOMIC_RELEASE);
+        }
+    }
+    pthread_mutex_unlock(&lut_lock);
+    return table;
+}
+
+/*
+Plays two rows of the padded board in 2x2 blocks. The columns' nibbles
+are built first, LUT_CHUNK columns at a time into a buffer on the stack
+(a loop the compiler vectorizes), then each block reads two of them.
+    table -> the rule's table
+    up, mid, down, low -> the first cell of the run in the row above, the
+        two rows played and the row below; [-1] and [n] are neighbors
+    out0, out1 -> where the two rows' next states go
+    n -> number of columns (even)
+    returns: the change in the number of live cells over the two rows
+*/
+static int lut_rows(const uint8_t *restrict table, const int *up,
+        const int *mid, const int *down, const int *low,
+        int *restrict out0, int *restrict out1, int n) {
+    uint8_t nib[LUT_CHUNK + 2];
+    unsigned idx, e;
+    int j, k, m, live;
+
+    live = 0;
+    for (j = 0; j < n; j += m) {
+        m = (n - j < LUT_CHUNK) ? n - j : LUT_CHUNK;
+        // nib[k]: column j + k - 1, top row in bit 0
+        for (k = 0; k < m + 2; k++) {
+            nib[k] = (uint8_t)(up[j + k - 1] | (mid[j + k - 1] << 1)
+                    | (down[j + k - 1] << 2) | (low[j + k - 1] << 3));
+        }
+        idx = (nib[0] << 8) | (nib[1] << 12);
+        for (k = 0; k < m; k += 2) {
+            idx = (idx >> 8) | (nib[k + 2] << 8) | (nib[k + 3] << 12);
+            e = table[idx];
+            out0[j + k] = e & 1;
+            out0[j + k + 1] = (e >> 1) & 1;
+            out1[j + k] = (e >> 2) & 1;
+            out1[j + k + 1] = (e >> 3) & 1;
+            live += (int)(e >> LUT_DELTA_SHIFT) - 4;
+        }
+    }
+    return live;
+}
+
+/*
+Plays a run of n cells in two rows from the rule's table, with the row
+kernel for an odd column left over
+    data-> The struct containing information for the game
+    table -> lut_table(data->rule)
+    up, mid, down, low -> the first cell of the run in the row above, the
+        two rows played and the row below; [-1] and [n] are neighbors
+    out0, out1 -> where the two rows' next states go
+    n -> number of columns
+    returns: the change in the number of live cells over the two rows
+*/
+int lut_pair(struct gol_data *data, const uint8_t *table, const int *up,
+        const int *mid, const int *down, const int *low, int *out0,
+        int *out1, int n) {
+    int even, live;
+
+    even = n & ~1;
+    live = lut_rows(table, up, mid, down, low, out0, out1, even);
+    if (even < n) {
+        // the odd column left over, one cell of each row
+        live += data->row_fn(up + even, mid + even, down + even,
+                out0 + even, 1, data->rule);
+        live += data->row_fn(mid + even, down + even, low + even,
+                out1 + even, 1, data->rule);
+    }
+    return live;
+}
+
+/*
+Plays rows r0..r1, cols c0..c1 of the padded board from the rule's table
+into data->next_board (the halo is left to padded_round)
+    data-> The struct containing information for the game
+    table -> lut_table(data->rule)
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+    returns: the change in the number of live cells over the region
+*/
+int lut_round(struct gol_data *data, const uint8_t *table,
+        int r0, int r1, int c0, int c1) {
+    const int *mid;
+    int *out;
+    size_t stride;
+    int i, live;
+
+    live = 0;
+    stride = data->cols + 2;
+    for (i = r0; i + 1 <= r1; i += 2) {
+        mid = padded_at(data, data->gol_board, i, c0);
+        out = padded_at(data, data->next_board, i, c0);
+        live += lut_pair(data, table, mid - stride, mid, mid + stride,
+                mid + 2 * stride, out, out + stride, c1 - c0 + 1);
+    }
+    if (i == r1) {
+        // the odd row left over
+        mid = padded_at(data, data->gol_board, i, c0);
+        live += data->row_fn(mid - stride, mid, mid + stride,
+                padded_at(data, data->next_board, i, c0), c1 - c0 + 1,
+                data->rule);
+    }
+    return live;
+}
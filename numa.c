@@ -0,0 +1,366 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+NUMA placement (-N). Linux puts a page on the node of the CPU that first
+writes it, so with -N the boards are allocated without being touched
+(2 MB aligned, with transparent huge pages requested) and each worker's
+share is zeroed by a thread pinned to the CPU that worker will run on,
+before the main thread places the live cells. The workers are then
+pinned to the same CPUs: threads are spread over the NUMA nodes in
+contiguous groups (neighbouring shares stay on one node), and within a
+node they take one hardware thread per core before doubling up on SMT
+siblings. The topology comes from /sys; a machine without it is one
+node.
+*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include "gol.h"
+
+/* alignment (and madvise unit) of -N boards: one x86 huge page */
+#define HUGE_PAGE (2UL << 20)
+
+/* one CPU the process may run on, with where it sits */
+struct cpu_info {
+    int cpu;
+    int node; // NUMA node
+    int package, core; // socket and core ids
+    int smt; // 0 for a core's first hardware thread, 1 for the next...
+};
+
+/*
+Reads one integer from a /sys file
+    path -> the file
+    fallback -> returned if the file cannot be read
+    returns: the number in the file
+*/
+static int read_sys_int(const char *path, int fallback) {
+    FILE *f;
+    int v;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        return fallback;
+    }
+    if (fscanf(f, "%d", &v) != 1) {
+        v = fallback;
+    }
+    fclose(f);
+    return v;
+}
+
+/*
+Sets node_of[cpu] = node for every cpu in a /sys cpulist ("0-3,8,10-11")
+    path -> the cpulist file
+    node -> the node to record
+    node_of -> per-CPU node, CPU_SETSIZE entries
+*/
+static void read_cpulist(const char *path, int node, int *node_of) {
+    FILE *f;
+    int lo, hi, c;
+    char sep;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        return;
+    }
+    while (fscanf(f, "%d", &lo) == 1) {
+        hi = lo;
+        sep = fgetc(f);
+        if (sep == '-') {
+            if (fscanf(f, "%d", &hi) != 1) {
+                break;
+            }
+            sep = fgetc(f);
+        }
+        for (c = lo; c <= hi && c < CPU_SETSIZE; c++) {
+            node_of[c] = node;
+        }
+        if (sep != ',') {
+            break;
+        }
+    }
+    fclose(f);
+}
+
+/* qsort order: node, then first hardware threads of cores, then core */
+static int cmp_cpu(const void *a, const void *b) {
+    const struct cpu_info *x = a, *y = b;
+
+    if (x->node != y->node) {
+        return x->node - y->node;
+    }
+    if (x->smt != y->smt) {
+        return x->smt - y->smt;
+    }
+    if (x->package != y->package) {
+        return x->package - y->package;
+    }
+    if (x->core != y->core) {
+        return x->core - y->core;
+    }
+    return x->cpu - y->cpu;
+}
+
+/*
+Picks a CPU for every thread (data->cpus) from the CPUs this process may
+use, in topology order
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int numa_setup(struct gol_data *data) {
+    struct cpu_info *cpus;
+    cpu_set_t allowed;
+    DIR *dir;
+    struct dirent *ent;
+    char path[128];
+    int *node_of, *first, *used;
+    int n, c, i, k, node, nodes, t, group;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return 1;
+    }
+    node_of = calloc(CPU_SETSIZE, sizeof(int));
+    cpus = malloc(sizeof(struct cpu_info) * CPU_SETSIZE);
+    data->cpus = malloc(sizeof(int) * data->threads);
+    if (node_of == NULL || cpus == NULL || data->cpus == NULL) {
+        free(node_of);
+        free(cpus);
+        return 1;
+    }
+
+    dir = opendir("/sys/devices/system/node");
+    while (dir != NULL && (ent = readdir(dir)) != NULL) {
+        if (sscanf(ent->d_name, "node%d", &node) == 1) {
+            snprintf(path, sizeof(path),
+                    "/sys/devices/system/node/node%d/cpulist", node);
+            read_cpulist(path, node, node_of);
+        }
+    }
+    if (dir != NULL) {
+        closedir(dir);
+    }
+
+    // the allowed CPUs, in id order so the smt rank is stable
+    n = 0;
+    for (c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, &allowed)) {
+            continue;
+        }
+        cpus[n].cpu = c;
+        cpus[n].node = node_of[c];
+        snprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu%d/topology/physical_package_id",
+                c);
+        cpus[n].package = read_sys_int(path, 0);
+        snprintf(path, sizeof(path),
+                "/sys/devices/system/cpu/cpu%d/topology/core_id", c);
+        cpus[n].core = read_sys_int(path, c);
+        cpus[n].smt = 0;
+        for (i = 0; i < n; i++) {
+            if (cpus[i].package == cpus[n].package
+                    && cpus[i].core == cpus[n].core) {
+                cpus[n].smt++;
+            }
+        }
+        n++;
+    }
+    qsort(cpus, n, sizeof(struct cpu_info), cmp_cpu);
+
+    // first[k]: where node group k starts in cpus (first[nodes] = n)
+    first = malloc(sizeof(int) * (n + 1));
+    used = calloc(n + 1, sizeof(int));
+    if (first == NULL || used == NULL) {
+        free(first);
+        free(used);
+        free(node_of);
+        free(cpus);
+        return 1;
+    }
+    nodes = 0;
+    for (i = 0; i < n; i++) {
+        if (i == 0 || cpus[i].node != cpus[i - 1].node) {
+            first[nodes++] = i;
+        }
+    }
+    first[nodes] = n;
+
+    // contiguous runs of threads per node, as even as possible
+    for (t = 0; t < data->threads; t++) {
+        group = (int)((long)t * nodes / data->threads);
+        k = first[group]
+            + used[group]++ % (first[group + 1] - first[group]);
+        data->cpus[t] = cpus[k].cpu;
+        if (data->print_config == 1) {
+            printf("ntid %d: cpu %d (node %d)\n", t, cpus[k].cpu,
+                    cpus[k].node);
+        }
+    }
+
+    free(first);
+    free(used);
+    free(node_of);
+    free(cpus);
+    return 0;
+}
+
+/*
+Pins the calling thread to the CPU numa_setup chose for thread
+data->ntids (no-op without -N)
+    data-> The struct containing information for the game
+*/
+void numa_pin(struct gol_data *data) {
+    cpu_set_t set;
+
+    if (data->cpus == NULL) {
+        return;
+    }
+    CPU_ZERO(&set);
+    CPU_SET(data->cpus[data->ntids], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/*
+Allocates an all-dead board of n cells of size bytes. With -N the memory
+is left untouched (numa_first_touch zeroes it from the right CPUs) and
+asked to be backed by huge pages.
+    data-> The struct containing information for the game
+    n -> number of cells
+    size -> bytes per cell
+    returns: the board (free it with free), or NULL
+*/
+void *board_alloc(struct gol_data *data, size_t n, size_t size) {
+    void *board;
+    size_t bytes;
+
+    if (!data->numa) {
+        return calloc(n, size);
+    }
+    bytes = (n * size + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    board = aligned_alloc(HUGE_PAGE, bytes);
+    if (board != NULL) {
+        // (only a hint: fine if THP is off or missing)
+        madvise(board, bytes, MADV_HUGEPAGE);
+    }
+    return board;
+}
+
+/*
+Zeroes rows r0..r1, cols c0..c1 of both boards; a share that touches the
+edge of a padded board also gets the halo next to it
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+*/
+static void touch_region(struct gol_data *data, int r0, int r1, int c0,
+        int c1) {
+    int i, w0, w1;
+
+    if (r0 > r1 || c0 > c1) {
+        return;
+    }
+    if (data->kernel == KERNEL_PACKED) {
+        w0 = c0 / 64;
+        w1 = c1 / 64;
+        for (i = r0; i <= r1; i++) {
+            memset(data->packed_board + (size_t)i * data->words + w0, 0,
+                    sizeof(uint64_t) * (w1 - w0 + 1));
+            memset(data->packed_next + (size_t)i * data->words + w0, 0,
+                    sizeof(uint64_t) * (w1 - w0 + 1));
+        }
+        return;
+    }
+    if (data->kernel == KERNEL_PADDED) {
+        r0 -= (r0 == 0);
+        r1 += (r1 == data->rows - 1);
+        c0 -= (c0 == 0);
+        c1 += (c1 == data->cols - 1);
+        for (i = r0; i <= r1; i++) {
+            memset(padded_at(data, data->gol_board, i, c0), 0,
+                    sizeof(int) * (c1 - c0 + 1));
+            memset(padded_at(data, data->next_board, i, c0), 0,
+                    sizeof(int) * (c1 - c0 + 1));
+        }
+        return;
+    }
+    for (i = r0; i <= r1; i++) {
+        memset(data->gol_board + (size_t)i * data->cols + c0, 0,
+                sizeof(int) * (c1 - c0 + 1));
+        memset(data->next_board + (size_t)i * data->cols + c0, 0,
+                sizeof(int) * (c1 - c0 + 1));
+    }
+}
+
+/*
+Thread function for numa_first_touch: zeroes the share of the board the
+worker with the same ntids will play, from that worker's CPU
+    arg -> this thread's copy of the gol_data
+*/
+static void *touch_share(void *arg) {
+    struct gol_data *data = (struct gol_data *)arg;
+    int k, r0, r1, c0, c1;
+
+    numa_pin(data);
+    partition(data);
+    if (data->part_mode == 0) {
+        touch_region(data, data->start, data->end, 0, data->cols - 1);
+    }
+    if (data->part_mode == 1) {
+        touch_region(data, 0, data->rows - 1, data->start, data->end);
+    }
+    if (data->part_mode == 2) {
+        for (k = data->start; k <= data->end; k++) {
+            tile_bounds(data, k, &r0, &r1, &c0, &c1);
+            touch_region(data, r0, r1, c0, c1);
+        }
+    }
+    return NULL;
+}
+
+/*
+Zeroes the boards allocated by board_alloc, every share from the CPU
+that will play it, so its pages land on that CPU's node. The shares
+cover the whole board.
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int numa_first_touch(struct gol_data *data) {
+    struct gol_data *targs;
+    pthread_t *tid;
+    int i, n, ret;
+
+    if (data->kernel == KERNEL_SPARSE) {
+        return 0;
+    }
+    tid = malloc(sizeof(pthread_t) * data->threads);
+    targs = aligned_alloc(CACHE_LINE, sizeof(struct gol_data) * data->threads);
+    if (tid == NULL || targs == NULL) {
+        free(tid);
+        free(targs);
+        return 1;
+    }
+    ret = 0;
+    for (n = 0; n < data->threads; n++) {
+        targs[n] = *data;
+        targs[n].ntids = n;
+        if (pthread_create(&tid[n], NULL, touch_share, &targs[n]) != 0) {
+            ret = 1;
+            break;
+        }
+    }
+    for (i = 0; i < n; i++) {
+        pthread_join(tid[i], NULL);
+    }
+    free(tid);
+    free(targs);
+    return ret;
+}
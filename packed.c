@@ -0,0 +1,255 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Bit-packed board representation for the Game of Life. Each row is stored
+as data->words uint64_t words with column j in bit (j % 64) of word
+(j / 64); bits past the last column are always kept zero. One step of the
+kernel computes the next state of all 64 cells in a word at once by adding
+the eight shifted neighbor words with bitwise full adders, so the board
+takes 1 bit per cell instead of an int. Other rules than Conway's get the
+full 4-bit neighbor count and test it against the rule's counts (with
+the common rules compiled in, so only their counts are tested).
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/*
+Allocates both packed boards (all cells dead) for data->rows x data->cols
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int packed_alloc(struct gol_data *data) {
+    size_t n;
+
+    data->words = (data->cols + 63) / 64;
+    n = (size_t)data->rows * data->words;
+
+    data->packed_board = board_alloc(data, n, sizeof(uint64_t));
+    data->packed_next = board_alloc(data, n, sizeof(uint64_t));
+    if (data->packed_board == NULL || data->packed_next == NULL) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Returns the value (0/1) of cell (i, j) on the current packed board
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+int packed_get_cell(struct gol_data *data, int i, int j) {
+    uint64_t word;
+
+    word = data->packed_board[(size_t)i * data->words + (j >> 6)];
+    return (int)((word >> (j & 63)) & 1);
+}
+
+/*
+Sets cell (i, j) alive on the current packed board
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+void packed_set_cell(struct gol_data *data, int i, int j) {
+    data->packed_board[(size_t)i * data->words + (j >> 6)] |=
+        (uint64_t)1 << (j & 63);
+}
+
+/*
+Computes the west (column j-1) and east (column j+1) neighbor words of
+word w in a row, wrapping around the torus at the row's ends
+    row -> the packed row
+    w -> the word index in the row
+    words -> words per row
+    cols -> the column dimension
+    west -> set to the word whose bit b is the cell left of bit b
+    east -> set to the word whose bit b is the cell right of bit b
+*/
+static inline void shift_words(const uint64_t *row, int w, int words,
+        int cols, uint64_t *west, uint64_t *east) {
+    uint64_t x, in_west, in_east;
+    int last_bit;
+
+    x = row[w];
+    if (w > 0) {
+        in_west = row[w - 1] >> 63;
+    } else {
+        // left of column 0 is the last column
+        last_bit = (cols - 1) & 63;
+        in_west = (row[words - 1] >> last_bit) & 1;
+    }
+
+    if (w < words - 1) {
+        in_east = row[w + 1] << 63;
+    } else {
+        // right of the last column is column 0
+        last_bit = (cols - 1) & 63;
+        in_east = (row[0] & 1) << last_bit;
+    }
+
+    *west = (x << 1) | in_west;
+    *east = (x >> 1) | in_east;
+}
+
+/*
+Applies a rule to 64 cells at once from their neighbor counts held as
+bit planes (count = b0 + 2 b1 + 4 b2 + 8 b3): a cell is set when its
+count is one the rule gives birth on and it is dead, or one it survives
+on and it is alive. With a constant rule the loop unrolls to the tests
+for the rule's own counts.
+    rule -> the rule (see rule.c)
+    x -> the current cells
+    b0, b1, b2, b3 -> the count bit planes
+    returns: the next cells
+*/
+static inline __attribute__((always_inline)) uint64_t rule_word(
+        unsigned rule, uint64_t x, uint64_t b0, uint64_t b1, uint64_t b2,
+        uint64_t b3) {
+    uint64_t next, want, eq;
+    int n;
+
+    next = 0;
+    for (n = 0; n <= 8; n++) {
+        want = (RULE_BORN(rule, n) ? ~x : 0)
+             | (RULE_STAYS(rule, n) ? x : 0);
+        if (want == 0) {
+            continue;
+        }
+        // (a count of 8 is b3 alone, so only 0 has to rule it out)
+        eq = ((n & 1) ? b0 : ~b0) & ((n & 2) ? b1 : ~b1)
+           & ((n & 4) ? b2 : ~b2);
+        eq = (n == 8) ? b3 : ((n == 0) ? eq & ~b3 : eq);
+        next |= want & eq;
+    }
+    return next;
+}
+
+/*
+The packed kernel for one rule (instantiated with a constant rule by
+packed_round for the common ones)
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row to compute
+    w0, w1 -> the first and last word of each row to compute
+    rule -> the rule (see rule.c)
+    returns: the change in the number of live cells over the region
+*/
+static inline __attribute__((always_inline)) int packed_rule(
+        struct gol_data *data, int r0, int r1, int w0, int w1,
+        unsigned rule) {
+    const uint64_t *up, *mid, *down;
+    uint64_t *out;
+    uint64_t uw, ue, mw, me, dw, de, x;
+    uint64_t lo_u, hi_u, lo_m, hi_m, lo_d, hi_d;
+    uint64_t lo, carry, p, q, r, s, two_or_three, next, mask;
+    int i, w, words, rows, cols, live;
+
+    words = data->words;
+    rows = data->rows;
+    cols = data->cols;
+    live = 0;
+
+    for (i = r0; i <= r1; i++) {
+        up = data->packed_board + (size_t)((i - 1 + rows) % rows) * words;
+        mid = data->packed_board + (size_t)i * words;
+        down = data->packed_board + (size_t)((i + 1) % rows) * words;
+        out = data->packed_next + (size_t)i * words;
+
+        for (w = w0; w <= w1; w++) {
+            shift_words(up, w, words, cols, &uw, &ue);
+            shift_words(mid, w, words, cols, &mw, &me);
+            shift_words(down, w, words, cols, &dw, &de);
+            x = mid[w];
+
+            // per-row sums as 2-bit numbers (lo + 2 * hi)
+            lo_u = uw ^ up[w] ^ ue;
+            hi_u = (uw & up[w]) | (ue & (uw ^ up[w]));
+            lo_m = mw ^ me;
+            hi_m = mw & me;
+            lo_d = dw ^ down[w] ^ de;
+            hi_d = (dw & down[w]) | (de & (dw ^ down[w]));
+
+            // add the three rows: count = lo + 2 * (hi_u+hi_m+hi_d+carry)
+            lo = lo_u ^ lo_m ^ lo_d;
+            carry = (lo_u & lo_m) | (lo_d & (lo_u ^ lo_m));
+
+            // the twos place must sum to exactly one for a count of 2 or 3
+            p = hi_u ^ hi_m;
+            q = hi_u & hi_m;
+            r = hi_d ^ carry;
+            s = hi_d & carry;
+            if (rule == RULE_LIFE) {
+                two_or_three = (p ^ r) & ~(q | s | (p & r));
+
+                // 3 neighbors: born or survives, 2: survives if alive
+                next = two_or_three & (lo | x);
+            } else {
+                // twos place sum p^r, fours (q^s)|(p&r), eights q&s
+                next = rule_word(rule, x, lo, p ^ r, (q ^ s) | (p & r),
+                        q & s);
+            }
+
+            if (w == words - 1 && (cols & 63) != 0) {
+                mask = ((uint64_t)1 << (cols & 63)) - 1;
+                next &= mask;
+            }
+            out[w] = next;
+            live += __builtin_popcountll(next) - __builtin_popcountll(x);
+        }
+    }
+    return live;
+}
+
+/*
+Plays one round on the packed board for rows r0..r1 and words w0..w1,
+writing the result to data->packed_next. Neighbor counts are never
+materialized: the eight neighbor words are summed with bitwise adders
+so all 64 cells of a word are decided by a handful of logic operations.
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row to compute
+    w0, w1 -> the first and last word of each row to compute
+    returns: the change in the number of live cells over the region
+*/
+int packed_round(struct gol_data *data, int r0, int r1, int w0, int w1) {
+
+    switch (data->rule) {
+    case RULE_LIFE:
+        return packed_rule(data, r0, r1, w0, w1, RULE_LIFE);
+    case RULE_HIGHLIFE:
+        return packed_rule(data, r0, r1, w0, w1, RULE_HIGHLIFE);
+    case RULE_SEEDS:
+        return packed_rule(data, r0, r1, w0, w1, RULE_SEEDS);
+    case RULE_DAYNIGHT:
+        return packed_rule(data, r0, r1, w0, w1, RULE_DAYNIGHT);
+    default:
+        return packed_rule(data, r0, r1, w0, w1, data->rule);
+    }
+}
+
+/*
+Checks whether any cell of rows r0..r1, words w0..w1 differs between the
+current and the next packed board
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row
+    w0, w1 -> the first and last word of each row
+    returns: 1 if something changed, 0 if not
+*/
+int packed_changed(struct gol_data *data, int r0, int r1, int w0, int w1) {
+    size_t at;
+    int i;
+
+    for (i = r0; i <= r1; i++) {
+        at = (size_t)i * data->words + w0;
+        if (memcmp(&data->packed_board[at], &data->packed_next[at],
+                    sizeof(uint64_t) * (w1 - w0 + 1)) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Ghost-cell padded board for the Game of Life. The board is stored as
+(rows + 2) x (cols + 2) ints: the real cells sit in the middle and a one
+cell halo ring around them holds copies of the cells on the opposite edge
+of the torus. With the halo in place every cell has all eight neighbors
+at fixed offsets, so the kernel needs no % wrapping and no branches and
+runs over contiguous rows that the compiler can vectorize.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/* index of cell (i, j) in a padded board; i/j may be -1 or rows/cols */
+#define PAD_IDX(data, i, j) \
+    ((size_t)((i) + 1) * ((data)->cols + 2) + ((j) + 1))
+
+/*
+Returns the address of cell (i, j) of a padded board (the cells of a row
+are contiguous, as on an unpadded board)
+    data-> The struct containing information for the game
+    board -> the board
+    i, j -> the cell (either may be -1 or rows/cols for the halo)
+    returns: a pointer to the cell
+*/
+int *padded_at(struct gol_data *data, int *board, int i, int j) {
+    return &board[PAD_IDX(data, i, j)];
+}
+
+/*
+Allocates both padded boards (all cells, and the halo, dead)
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int padded_alloc(struct gol_data *data) {
+    size_t n;
+
+    n = (size_t)(data->rows + 2) * (data->cols + 2);
+    data->gol_board = board_alloc(data, n, sizeof(int));
+    // -I: one board (see inplace.c)
+    data->next_board = data->inplace ? data->gol_board
+        : board_alloc(data, n, sizeof(int));
+    if (data->gol_board == NULL || data->next_board == NULL) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Returns the value (0/1) of cell (i, j) on the current padded board
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+int padded_get_cell(struct gol_data *data, int i, int j) {
+    return data->gol_board[PAD_IDX(data, i, j)];
+}
+
+/*
+Sets cell (i, j) alive on the current padded board. The halo is not
+updated; call padded_fill_halo once all cells are placed.
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+void padded_set_cell(struct gol_data *data, int i, int j) {
+    data->gol_board[PAD_IDX(data, i, j)] = 1;
+}
+
+/*
+Refreshes the halo copies of the cells in rows r0..r1, cols c0..c1 of a
+padded board. Each thread calls this for the region it just computed, so
+every halo cell is written exactly once per round by the thread that owns
+the cell it mirrors.
+    data-> The struct containing information for the game
+    board -> the padded board to update
+    r0, r1 -> the first and last row of the region
+    c0, c1 -> the first and last column of the region
+*/
+void padded_fill_halo(struct gol_data *data, int *board,
+        int r0, int r1, int c0, int c1) {
+    int i, rows, cols;
+    size_t width;
+
+    rows = data->rows;
+    cols = data->cols;
+    if (r0 > r1 || c0 > c1) {
+        return;
+    }
+    width = sizeof(int) * (c1 - c0 + 1);
+
+    // left and right halo columns
+    for (i = r0; i <= r1; i++) {
+        if (c0 == 0) {
+            board[PAD_IDX(data, i, cols)] = board[PAD_IDX(data, i, 0)];
+        }
+        if (c1 == cols - 1) {
+            board[PAD_IDX(data, i, -1)] = board[PAD_IDX(data, i, cols - 1)];
+        }
+    }
+
+    // the last row is the halo above row 0 (plus two corners)
+    if (r1 == rows - 1) {
+        memcpy(&board[PAD_IDX(data, -1, c0)],
+                &board[PAD_IDX(data, rows - 1, c0)], width);
+        if (c0 == 0) {
+            board[PAD_IDX(data, -1, cols)] = board[PAD_IDX(data, rows - 1, 0)];
+        }
+        if (c1 == cols - 1) {
+            board[PAD_IDX(data, -1, -1)] =
+                board[PAD_IDX(data, rows - 1, cols - 1)];
+        }
+    }
+
+    // the first row is the halo below the last row (plus two corners)
+    if (r0 == 0) {
+        memcpy(&board[PAD_IDX(data, rows, c0)],
+                &board[PAD_IDX(data, 0, c0)], width);
+        if (c0 == 0) {
+            board[PAD_IDX(data, rows, cols)] = board[PAD_IDX(data, 0, 0)];
+        }
+        if (c1 == cols - 1) {
+            board[PAD_IDX(data, rows, -1)] = board[PAD_IDX(data, 0, cols - 1)];
+        }
+    }
+}
+
+/*
+The portable row loop for one rule: with a constant rule (the instances
+in padded_row) the mask test folds away and only the compares for the
+rule's neighbor counts are left, which the compiler vectorizes like the
+hand-written Conway test; with a rule known only at run time each cell
+takes one shift of the mask (RULE_NEXT)
+    up, mid, down -> the three input rows
+    out -> where the n next states are written
+    n -> number of cells in the run
+    rule -> the rule (see rule.c)
+    folded -> 1 when rule is a compile-time constant
+    returns: the change in the number of live cells over the run
+*/
+static inline __attribute__((always_inline)) int row_rule(
+        const int *restrict up, const int *restrict mid,
+        const int *restrict down, int *restrict out, int n,
+        unsigned rule, int folded) {
+    int j, k, neighbors, alive, born, stays, next, live;
+
+    live = 0;
+    for (j = 0; j < n; j++) {
+        neighbors = up[j - 1] + up[j] + up[j + 1]
+                  + mid[j - 1] + mid[j + 1]
+                  + down[j - 1] + down[j] + down[j + 1];
+        alive = mid[j];
+        if (rule == RULE_LIFE) {
+            // born with 3 neighbors, survives with 2 or 3
+            next = (neighbors == 3) | (alive & (neighbors == 2));
+        } else if (folded) {
+            born = 0;
+            stays = 0;
+            for (k = 0; k <= 8; k++) {
+                if (RULE_BORN(rule, k)) {
+                    born |= (neighbors == k);
+                }
+                if (RULE_STAYS(rule, k)) {
+                    stays |= (neighbors == k);
+                }
+            }
+            next = (born & (alive ^ 1)) | (stays & alive);
+        } else {
+            next = RULE_NEXT(rule, alive, neighbors);
+        }
+        out[j] = next;
+        live += next - alive;
+    }
+    return live;
+}
+
+/*
+Portable row kernel (the default for -k padded and the fallback for
+-k simd): computes the next state of one contiguous run of n cells. up,
+mid and down point at the first cell of the run in the rows above, at and
+below it; their [-1] and [n] elements are the neighbors (or halo) to
+either side. The common rules have their own compiled copies.
+    up, mid, down -> the three input rows
+    out -> where the n next states are written
+    n -> number of cells in the run
+    rule -> the rule (see rule.c)
+    returns: the change in the number of live cells over the run
+*/
+int padded_row(const int *restrict up, const int *restrict mid,
+        const int *restrict down, int *restrict out, int n, unsigned rule) {
+
+    switch (rule) {
+    case RULE_LIFE:
+        return row_rule(up, mid, down, out, n, RULE_LIFE, 1);
+    case RULE_HIGHLIFE:
+        return row_rule(up, mid, down, out, n, RULE_HIGHLIFE, 1);
+    case RULE_SEEDS:
+        return row_rule(up, mid, down, out, n, RULE_SEEDS, 1);
+    case RULE_DAYNIGHT:
+        return row_rule(up, mid, down, out, n, RULE_DAYNIGHT, 1);
+    default:
+        return row_rule(up, mid, down, out, n, rule, 0);
+    }
+}
+
+/*
+Plays one round on the padded board for rows r0..r1, cols c0..c1, writes
+the results to data->next_board and refreshes the halo cells they mirror
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row to compute
+    c0, c1 -> the first and last column to compute
+    returns: the change in the number of live cells over the region
+*/
+int padded_round(struct gol_data *data, int r0, int r1, int c0, int c1) {
+    int i, live;
+    size_t stride;
+    const int *mid;
+    const uint8_t *table;
+
+    live = 0;
+    stride = data->cols + 2;
+    if (c0 > c1) {
+        return 0;
+    }
+
+    // -k lut: 2x2 blocks from the rule's table (see lut.c)
+    table = data->lut ? lut_table(data->rule) : NULL;
+    if (table != NULL) {
+        live = lut_round(data, table, r0, r1, c0, c1);
+    }
+    for (i = r0; i <= r1 && table == NULL; i++) {
+        mid = &data->gol_board[PAD_IDX(data, i, c0)];
+        live += data->row_fn(mid - stride, mid, mid + stride,
+                &data->next_board[PAD_IDX(data, i, c0)], c1 - c0 + 1,
+                data->rule);
+    }
+    padded_fill_halo(data, data->next_board, r0, r1, c0, c1);
+    return live;
+}
+
+/*
+Checks whether any cell of rows r0..r1, cols c0..c1 differs between the
+current and the next padded board
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+    returns: 1 if something changed, 0 if not
+*/
+int padded_changed(struct gol_data *data, int r0, int r1, int c0, int c1) {
+    size_t at;
+    int i;
+
+    for (i = r0; i <= r1; i++) {
+        at = PAD_IDX(data, i, c0);
+        if (memcmp(&data->gol_board[at], &data->next_board[at],
+                    sizeof(int) * (c1 - c0 + 1)) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
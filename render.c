@@ -0,0 +1,423 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+The render pipeline for the animated output modes (ascii and ParaVisi).
+Drawing is done by one render thread, so the worker threads never wait
+for the terminal or the display: the generations run at full speed and
+the render thread shows the newest board it can, dropping the rest.
+
+Frames are one byte per cell: RENDER_LIVE for a live cell, otherwise the
+id of the thread that played the cell (ParaVisi colors dead cells by
+thread). There are three of them: the render thread draws the front
+frame, the newest finished frame waits in the ready slot, and the
+workers fill the back one. When the render thread wants a new frame it
+says so (want); the round after that, every worker copies its own share
+of the board it just played into the back frame (as the census and -r
+do), and end_round swaps it into the ready slot and wakes the render
+thread. Nobody ever waits for a frame, and rounds played while the
+render thread is busy cost nothing. HashLife, which has no workers,
+hands its board over after each generation instead (render_board).
+
+The render thread draws at most one frame every SLEEP_USECS. An ascii
+frame is built in one buffer and written with a single write(): the
+first one clears the screen, later ones move the cursor to the rows that
+changed since the last frame and redraw only those.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include "gol.h"
+
+/* The frames and the render thread */
+struct render {
+    unsigned char *frames[3]; // rows * cols bytes each
+    int round[3]; // round of the board in each frame
+    int live[3]; // its live cells
+    int back; // the frame the workers fill (end_round's side)
+    int ready; // the newest finished frame
+    int front; // the frame being drawn (the render thread's side)
+    int due; // 1: the round being played fills the back frame
+    int want; // 1: the render thread is waiting for a frame
+
+    unsigned char *shown; // ascii: live cells (0/1) of the last frame
+    int drawn; // frames drawn so far
+    char *text; // ascii: the frame being written
+    size_t cap; // room in text
+
+    pthread_t tid;
+    pthread_mutex_t lock; // guards ready, fresh, want and quit
+    pthread_cond_t cond; // a frame is ready (or quit)
+    int fresh; // 1: ready holds a frame not drawn yet
+    int quit; // 1: draw what is ready and exit
+};
+
+/*
+Fills rows r0..r1, cols c0..c1 of a frame from the next board: live
+cells get RENDER_LIVE, dead ones the thread's id
+    data-> The struct containing information for the game
+    frame -> the frame
+    r0, r1, c0, c1 -> the rectangle
+*/
+static void fill_region(struct gol_data *data, unsigned char *frame,
+        int r0, int r1, int c0, int c1) {
+    const int *row;
+    const uint64_t *prow;
+    unsigned char *out, dead;
+    int i, j;
+
+    dead = (unsigned char)data->ntids;
+    for (i = r0; i <= r1; i++) {
+        out = frame + (size_t)i * data->cols;
+        if (data->kernel == KERNEL_PACKED) {
+            prow = data->packed_next + (size_t)i * data->words;
+            for (j = c0; j <= c1; j++) {
+                out[j] = ((prow[j / 64] >> (j % 64)) & 1)
+                    ? RENDER_LIVE : dead;
+            }
+        } else {
+            row = board_row(data, data->next_board, i);
+            for (j = c0; j <= c1; j++) {
+                out[j] = row[j] ? RENDER_LIVE : dead;
+            }
+        }
+    }
+}
+
+/*
+Fills this thread's rows of a frame from its sparse engine result (the
+next generation of its rows, before end_round merges them)
+    data-> The struct containing information for the game
+    frame -> the frame
+*/
+static void fill_sparse(struct gol_data *data, unsigned char *frame) {
+    const struct sparse_set *out;
+    long k;
+
+    memset(frame + (size_t)data->start * data->cols, data->ntids,
+            (size_t)(data->end - data->start + 1) * data->cols);
+    out = sparse_result(data);
+    for (k = 0; k < out->n; k++) {
+        frame[out->cells[k]] = RENDER_LIVE;
+    }
+}
+
+/*
+Makes sure the ascii text buffer has room for n more bytes
+    r -> the render state
+    len -> bytes already in it
+    n -> bytes to add
+    returns: 0 on success, 1 if out of memory
+*/
+static int text_room(struct render *r, size_t len, size_t n) {
+    char *grown;
+    size_t cap;
+
+    if (len + n <= r->cap) {
+        return 0;
+    }
+    cap = (r->cap > 0) ? r->cap : 4096;
+    while (cap < len + n) {
+        cap *= 2;
+    }
+    grown = realloc(r->text, cap);
+    if (grown == NULL) {
+        return 1;
+    }
+    r->text = grown;
+    r->cap = cap;
+    return 0;
+}
+
+/*
+Draws an ascii frame: the first one whole after clearing the screen,
+later ones only the rows that changed, each after an ANSI cursor move;
+the whole frame goes out in one write()
+    data-> The struct containing information for the game
+    frame -> the frame
+    round, live -> the round and live cells it shows
+*/
+static void draw_ascii(struct gol_data *data, const unsigned char *frame,
+        int round, int live) {
+    struct render *r = data->shared->render;
+    const unsigned char *cells;
+    unsigned char *shown;
+    size_t len, row_bytes;
+    ssize_t put;
+    int i, j, same;
+
+    row_bytes = 2 * (size_t)data->cols + 1;
+    len = 0;
+    if (text_room(r, 0, 64)) {
+        return;
+    }
+    if (r->drawn == 0) {
+        len += sprintf(r->text, "\033[H\033[2J");
+    }
+    len += sprintf(r->text + len, "\033[H\033[KRound: %d\n", round);
+    for (i = 0; i < data->rows; i++) {
+        cells = frame + (size_t)i * data->cols;
+        shown = r->shown + (size_t)i * data->cols;
+        same = (r->drawn > 0);
+        for (j = 0; j < data->cols && same; j++) {
+            same = ((cells[j] == RENDER_LIVE) == shown[j]);
+        }
+        if (same) {
+            continue;
+        }
+        if (text_room(r, len, row_bytes + 32)) {
+            return;
+        }
+        // rows start on line 2 of the screen (line 1 is the round)
+        len += sprintf(r->text + len, "\033[%d;1H", i + 2);
+        for (j = 0; j < data->cols; j++) {
+            shown[j] = (cells[j] == RENDER_LIVE);
+            r->text[len++] = ' ';
+            r->text[len++] = shown[j] ? '@' : '.';
+        }
+        r->text[len++] = '\n';
+    }
+    if (text_room(r, len, 64)) {
+        return;
+    }
+    len += sprintf(r->text + len, "\033[%d;1H\033[KLive cells: %d\n",
+            data->rows + 2, live);
+
+    for (i = 0; (size_t)i < len; i += put) {
+        put = write(STDERR_FILENO, r->text + i, len - i);
+        if (put < 0 && errno == EINTR) {
+            put = 0;
+        } else if (put <= 0) {
+            break;
+        }
+    }
+}
+
+/*
+Thread function of the render thread: draws every frame it is handed,
+at most one per SLEEP_USECS, until render_stop
+    arg -> the struct gol_data the game was set up with
+*/
+static void *render_run(void *arg) {
+    struct gol_data *data = (struct gol_data *)arg;
+    struct render *r = data->shared->render;
+    struct timespec next;
+    int swap;
+
+    pthread_mutex_lock(&r->lock);
+    for (;;) {
+        __atomic_store_n(&r->want, 1, __ATOMIC_RELEASE);
+        while (!r->fresh && !r->quit) {
+            pthread_cond_wait(&r->cond, &r->lock);
+        }
+        if (!r->fresh) {
+            break;
+        }
+        swap = r->front;
+        r->front = r->ready;
+        r->ready = swap;
+        r->fresh = 0;
+        pthread_mutex_unlock(&r->lock);
+
+        clock_gettime(CLOCK_REALTIME, &next);
+        if (data->draw_fn != NULL) {
+            data->draw_fn(data, r->frames[r->front]);
+        } else {
+            draw_ascii(data, r->frames[r->front], r->round[r->front],
+                    r->live[r->front]);
+        }
+        r->drawn++;
+
+        // pace the frames (render_stop cuts the wait short)
+        next.tv_nsec += SLEEP_USECS * 1000L;
+        next.tv_sec += next.tv_nsec / 1000000000L;
+        next.tv_nsec %= 1000000000L;
+        pthread_mutex_lock(&r->lock);
+        while (!r->quit && pthread_cond_timedwait(&r->cond, &r->lock,
+                    &next) != ETIMEDOUT) {
+        }
+    }
+    pthread_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+/*
+Allocates the frames and starts the render thread (before the worker
+threads start)
+    data-> The struct containing information for the game (draw_fn set
+        for ParaVisi, NULL for ascii)
+    returns: 0 on success, 1 on error
+*/
+int render_start(struct gol_data *data) {
+    struct render *r;
+    size_t n;
+    int k;
+
+    r = calloc(1, sizeof(struct render));
+    if (r == NULL) {
+        return 1;
+    }
+    data->shared->render = r;
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    n = (size_t)data->rows * data->cols;
+    for (k = 0; k < 3; k++) {
+        r->frames[k] = malloc(n);
+        if (r->frames[k] == NULL) {
+            return 1;
+        }
+    }
+    r->shown = calloc(n, 1);
+    if (r->shown == NULL) {
+        return 1;
+    }
+    r->front = 0;
+    r->ready = 1;
+    r->back = 2;
+    if (pthread_create(&r->tid, NULL, render_run, data) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Decides whether the round about to be played fills a frame: only when
+the render thread is waiting for one (runs in start_loop and end_round)
+    data-> The struct containing information for the game
+*/
+void render_plan(struct gol_data *data) {
+    struct render *r = data->shared->render;
+
+    r->due = data->shared->round < data->shared->stop
+        && __atomic_load_n(&r->want, __ATOMIC_ACQUIRE);
+}
+
+/*
+Copies this thread's share of the board it just played (rows, columns or
+tiles) into the back frame, in a round that fills one
+    data-> The struct containing information for the game
+*/
+void render_share(struct gol_data *data) {
+    struct render *r = data->shared->render;
+    unsigned char *frame;
+    int k, r0, r1, c0, c1;
+
+    if (!r->due) {
+        return;
+    }
+    frame = r->frames[r->back];
+    if (data->kernel == KERNEL_SPARSE) {
+        fill_sparse(data, frame);
+        return;
+    }
+    if (data->part_mode == 0) {
+        fill_region(data, frame, data->start, data->end, 0,
+                data->cols - 1);
+    }
+    if (data->part_mode == 1) {
+        fill_region(data, frame, 0, data->rows - 1, data->start,
+                data->end);
+    }
+    if (data->part_mode == 2) {
+        for (k = data->start; k <= data->end; k++) {
+            tile_bounds(data, k, &r0, &r1, &c0, &c1);
+            fill_region(data, frame, r0, r1, c0, c1);
+        }
+    }
+}
+
+/*
+Hands the filled back frame to the render thread (it becomes the ready
+one)
+    r -> the render state
+    round, live -> the round and live cells the frame shows
+*/
+static void hand_off(struct render *r, int round, int live) {
+    int swap;
+
+    r->round[r->back] = round;
+    r->live[r->back] = live;
+    pthread_mutex_lock(&r->lock);
+    swap = r->ready;
+    r->ready = r->back;
+    r->back = swap;
+    r->fresh = 1;
+    __atomic_store_n(&r->want, 0, __ATOMIC_RELEASE);
+    pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+/*
+Runs in end_round after the boards are flipped: hands a filled frame to
+the render thread and plans the next round
+    data-> The struct containing information for the game
+*/
+void render_round(struct gol_data *data) {
+    struct render *r = data->shared->render;
+
+    if (r->due) {
+        hand_off(r, data->shared->round, data->shared->total_live);
+    }
+    render_plan(data);
+}
+
+/*
+Hands the render thread a frame of data->sparse_board if it is waiting
+for one (for HashLife, which has no worker threads: called by the one
+thread that plays it, after each generation)
+    data-> The struct containing information for the game
+    round -> the generation on the board
+*/
+void render_board(struct gol_data *data, int round) {
+    struct render *r = data->shared->render;
+    const struct sparse_set *board = data->sparse_board;
+    unsigned char *frame;
+    long k;
+
+    if (!__atomic_load_n(&r->want, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    frame = r->frames[r->back];
+    memset(frame, 0, (size_t)data->rows * data->cols);
+    for (k = 0; k < board->n; k++) {
+        frame[board->cells[k]] = RENDER_LIVE;
+    }
+    hand_off(r, round, (int)board->n);
+}
+
+/*
+Stops the render thread (after the worker threads are joined; a frame
+still waiting is drawn first) and frees the frames
+    data-> The struct containing information for the game
+*/
+void render_stop(struct gol_data *data) {
+    struct render *r = data->shared->render;
+    int k;
+
+    if (r == NULL) {
+        return;
+    }
+    if (r->tid != 0) {
+        pthread_mutex_lock(&r->lock);
+        r->quit = 1;
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+        pthread_join(r->tid, NULL);
+    }
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->cond);
+    for (k = 0; k < 3; k++) {
+        free(r->frames[k]);
+    }
+    free(r->shown);
+    free(r->text);
+    free(r);
+    data->shared->render = NULL;
+}
@@ -0,0 +1,113 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Life-like rules (B/S rulestrings, from an RLE header, a checkpoint or
+-R). A rule is kept as one 18-bit mask: bit n is set when a dead cell
+with n live neighbors is born, bit 9 + n when a live cell with n
+neighbors survives, so every kernel decides a cell with one shift of
+the mask (RULE_NEXT) and no branch. The kernels also keep copies
+specialized for the common rules (RULE_LIFE and the others in gol.h),
+where the compiler folds the constant mask into a few compares; other
+rules take the general path, which costs the same shift per cell.
+
+Rules that give birth with 0 neighbors (B0) are refused: they turn an
+empty board full, which the sparse and HashLife engines and -a cannot
+represent (they assume empty space stays empty).
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "gol.h"
+
+/*
+Reads the digits of one half of a rulestring into a 9-bit mask
+    s -> the first digit; moved past the last one
+    mask -> the digits' bits are set in it
+    returns: 0 on success, 1 for a digit over 8
+*/
+static int read_counts(const char **s, unsigned *mask) {
+
+    while (isdigit((unsigned char)**s)) {
+        if (**s == '9') {
+            return 1;
+        }
+        *mask |= 1u << (**s - '0');
+        (*s)++;
+    }
+    return 0;
+}
+
+/*
+Parses a rulestring: B3/S23 (either half first, either case, the S half
+may be empty: B2/S or B2) or the older S/B digits form 23/3
+    s -> the rulestring
+    rule -> set to the rule's mask on success
+    returns: 0 on success, 1 if s is not a rule or gives birth on 0
+*/
+int rule_parse(const char *s, unsigned *rule) {
+    unsigned born, stays;
+    int letters;
+
+    born = 0;
+    stays = 0;
+    letters = (toupper((unsigned char)*s) == 'B'
+            || toupper((unsigned char)*s) == 'S');
+    if (!letters) {
+        if (read_counts(&s, &stays) != 0 || *s++ != '/'
+                || read_counts(&s, &born) != 0) {
+            return 1;
+        }
+    }
+    while (letters && *s != '\0') {
+        if (toupper((unsigned char)*s) == 'B') {
+            s++;
+            if (read_counts(&s, &born) != 0) {
+                return 1;
+            }
+        } else if (toupper((unsigned char)*s) == 'S') {
+            s++;
+            if (read_counts(&s, &stays) != 0) {
+                return 1;
+            }
+        } else {
+            return 1;
+        }
+        if (*s == '/') {
+            s++;
+        }
+    }
+    if (*s != '\0' || (born & 1)) {
+        return 1;
+    }
+    *rule = born | (stays << 9);
+    return 0;
+}
+
+/*
+Writes a rule as a B/S rulestring (B3/S23 for Conway's rule)
+    rule -> the rule's mask
+    buf -> room for RULE_LEN bytes
+*/
+void rule_format(unsigned rule, char *buf) {
+    int n;
+
+    *buf++ = 'B';
+    for (n = 0; n <= 8; n++) {
+        if (RULE_BORN(rule, n)) {
+            *buf++ = '0' + n;
+        }
+    }
+    *buf++ = '/';
+    *buf++ = 'S';
+    for (n = 0; n <= 8; n++) {
+        if (RULE_STAYS(rule, n)) {
+            *buf++ = '0' + n;
+        }
+    }
+    *buf = '\0';
+}
@@ -0,0 +1,411 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Sparse live-cell engine (-e sparse, or picked automatically for very low
+density boards). Only live cells are stored: a generation is a sorted
+list of cell keys (row * cols + col), so memory follows the population
+instead of rows * cols. Each thread owns a band of rows. It finds the
+live cells on its rows and the rows just outside them with a binary
+search, adds each one's contribution to its neighbors in a private
+open-addressing hash table, and keeps the cells the rule makes alive
+(3 neighbors, or 2 and alive, for B3/S23). The bands are in row order,
+so the last thread to reach the barrier just concatenates the threads'
+sorted results.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/* empty slot of a neighbor count table (no cell has this key) */
+#define SLOT_EMPTY (~(uint64_t)0)
+
+/* set in a count table value when the cell itself is alive */
+#define ALIVE_BIT (16)
+
+/* per-thread state: the neighbor count table and the thread's result */
+struct sparse_thread {
+    struct sparse_set out; // next generation of this thread's rows
+    uint64_t *keys; // count table keys (SLOT_EMPTY when unused)
+    unsigned char *counts; // neighbor count, | ALIVE_BIT if alive
+    size_t cap; // table size (a power of 2)
+    int bits; // log2(cap)
+} __attribute__((aligned(CACHE_LINE)));
+
+/*
+Adds a key to the end of a cell list, growing it as needed
+    set -> the list
+    key -> the cell key to add
+    returns: 0 on success, 1 on error
+*/
+static int set_push(struct sparse_set *set, uint64_t key) {
+    uint64_t *cells;
+    long cap;
+
+    if (set->n == set->cap) {
+        cap = (set->cap < 16) ? 16 : set->cap * 2;
+        cells = realloc(set->cells, sizeof(uint64_t) * cap);
+        if (cells == NULL) {
+            return 1;
+        }
+        set->cells = cells;
+        set->cap = cap;
+    }
+    set->cells[set->n++] = key;
+    return 0;
+}
+
+/*
+Finds the first cell in a sorted list whose key is not below key
+    set -> the sorted list
+    key -> the key to look for
+    returns: the position of that cell (set->n if there is none)
+*/
+long sparse_lower_bound(const struct sparse_set *set, uint64_t key) {
+    long lo, hi, mid;
+
+    lo = 0;
+    hi = set->n;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (set->cells[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* qsort comparison for cell keys */
+static int cmp_key(const void *a, const void *b) {
+    uint64_t ka, kb;
+
+    ka = *(const uint64_t *)a;
+    kb = *(const uint64_t *)b;
+    return (ka > kb) - (ka < kb);
+}
+
+/*
+Allocates the (empty) current and next cell lists
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int sparse_alloc(struct gol_data *data) {
+
+    data->sparse_board = calloc(1, sizeof(struct sparse_set));
+    data->sparse_next = calloc(1, sizeof(struct sparse_set));
+    if (data->sparse_board == NULL || data->sparse_next == NULL) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Frees a cell list allocated by sparse_alloc
+    set -> the list (may be NULL)
+*/
+void sparse_free(struct sparse_set *set) {
+
+    if (set != NULL) {
+        free(set->cells);
+        free(set);
+    }
+}
+
+/*
+Returns the value (0/1) of cell (i, j) on the current board
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+int sparse_get_cell(struct gol_data *data, int i, int j) {
+    uint64_t key;
+    long at;
+
+    key = (uint64_t)i * data->cols + j;
+    at = sparse_lower_bound(data->sparse_board, key);
+    return at < data->sparse_board->n && data->sparse_board->cells[at] == key;
+}
+
+/*
+Sets cell (i, j) alive on the current board. Cells are appended as they
+are read; sparse_finish_load puts them in order afterwards.
+    data-> The struct containing information for the game
+    i -> the row of the cell
+    j -> the column of the cell
+*/
+void sparse_set_cell(struct gol_data *data, int i, int j) {
+
+    if (set_push(data->sparse_board, (uint64_t)i * data->cols + j) != 0) {
+        perror("malloc: sparse cells");
+        exit(1);
+    }
+}
+
+/*
+Sorts the cells read by sparse_set_cell and drops any duplicates
+    data-> The struct containing information for the game
+*/
+void sparse_finish_load(struct gol_data *data) {
+    struct sparse_set *set = data->sparse_board;
+    long i, n;
+
+    qsort(set->cells, set->n, sizeof(uint64_t), cmp_key);
+    n = 0;
+    for (i = 0; i < set->n; i++) {
+        if (n == 0 || set->cells[i] != set->cells[n - 1]) {
+            set->cells[n++] = set->cells[i];
+        }
+    }
+    set->n = n;
+}
+
+/*
+Allocates every thread's count table and result list (in the shared
+state, so the thread that merges the results can see them all)
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int sparse_setup(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+
+    shared->sparse_threads = aligned_alloc(CACHE_LINE,
+            sizeof(struct sparse_thread) * data->threads);
+    if (shared->sparse_threads == NULL) {
+        return 1;
+    }
+    memset(shared->sparse_threads, 0,
+            sizeof(struct sparse_thread) * data->threads);
+    return 0;
+}
+
+/*
+Frees what sparse_setup allocated
+    data-> The struct containing information for the game
+*/
+void sparse_cleanup(struct gol_data *data) {
+    struct sparse_thread *t;
+    int i;
+
+    if (data->shared->sparse_threads == NULL) {
+        return;
+    }
+    for (i = 0; i < data->threads; i++) {
+        t = &data->shared->sparse_threads[i];
+        free(t->out.cells);
+        free(t->keys);
+        free(t->counts);
+    }
+    free(data->shared->sparse_threads);
+}
+
+/*
+Makes a thread's count table empty and big enough for entries entries
+at most half full
+    t -> the thread's state
+    entries -> the most cells that will be counted
+    returns: 0 on success, 1 on error
+*/
+static int table_reset(struct sparse_thread *t, size_t entries) {
+    size_t cap;
+    int bits;
+
+    cap = 64;
+    bits = 6;
+    while (cap < 2 * entries) {
+        cap *= 2;
+        bits++;
+    }
+    if (cap > t->cap) {
+        free(t->keys);
+        free(t->counts);
+        t->keys = malloc(sizeof(uint64_t) * cap);
+        t->counts = malloc(cap);
+        if (t->keys == NULL || t->counts == NULL) {
+            return 1;
+        }
+        t->cap = cap;
+        t->bits = bits;
+    }
+    memset(t->keys, 0xff, sizeof(uint64_t) * t->cap);
+    return 0;
+}
+
+/*
+Adds add to the count of cell key (inserting it if it is new)
+    t -> the thread's state
+    key -> the cell
+    add -> 1 for a live neighbor, ALIVE_BIT for the cell itself
+*/
+static inline void table_add(struct sparse_thread *t, uint64_t key,
+        int add) {
+    size_t slot, mask;
+
+    mask = t->cap - 1;
+    slot = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> (64 - t->bits));
+    while (t->keys[slot] != key) {
+        if (t->keys[slot] == SLOT_EMPTY) {
+            t->keys[slot] = key;
+            t->counts[slot] = 0;
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    t->counts[slot] += add;
+}
+
+/*
+Counts the live cells on rows lo..hi of the current board
+    data-> The struct containing information for the game
+    lo, hi -> the first and last row
+    returns: the number of live cells
+*/
+static long rows_count(struct gol_data *data, int lo, int hi) {
+    const struct sparse_set *set = data->sparse_board;
+
+    return sparse_lower_bound(set, (uint64_t)(hi + 1) * data->cols)
+        - sparse_lower_bound(set, (uint64_t)lo * data->cols);
+}
+
+/*
+Adds the contribution of live cells on rows lo..hi (lo <= hi) to the
+counts of the cells on rows r0..r1 around them
+    data-> The struct containing information for the game
+    t -> the thread's state
+    lo, hi -> the rows of live cells to visit
+    r0, r1 -> the rows being played
+*/
+static void count_rows(struct gol_data *data, struct sparse_thread *t,
+        int lo, int hi, int r0, int r1) {
+    const struct sparse_set *set = data->sparse_board;
+    long a, b, k;
+    int i, j, di, dj, ni;
+    uint64_t rows, cols;
+
+    rows = data->rows;
+    cols = data->cols;
+    a = sparse_lower_bound(set, (uint64_t)lo * cols);
+    b = sparse_lower_bound(set, (uint64_t)(hi + 1) * cols);
+
+    for (k = a; k < b; k++) {
+        i = (int)(set->cells[k] / cols);
+        j = (int)(set->cells[k] % cols);
+        for (di = -1; di <= 1; di++) {
+            ni = (int)((i + di + rows) % rows);
+            if (ni < r0 || ni > r1) {
+                continue;
+            }
+            for (dj = -1; dj <= 1; dj++) {
+                table_add(t, (uint64_t)ni * cols + (j + dj + cols) % cols,
+                        (di == 0 && dj == 0) ? ALIVE_BIT : 1);
+            }
+        }
+    }
+}
+
+/*
+Plays one round on rows r0..r1 of the sparse board. The new live cells
+go to this thread's result list, in key order, for sparse_merge.
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row to compute
+    returns: the change in the number of live cells over the rows
+*/
+int sparse_round(struct gol_data *data, int r0, int r1) {
+    struct sparse_thread *t = &data->shared->sparse_threads[data->ntids];
+    long before, near;
+    size_t s;
+    int rows, above, below, c;
+
+    rows = data->rows;
+    t->out.n = 0;
+    before = rows_count(data, r0, r1);
+
+    // the live cells that touch rows r0..r1: the rows themselves and the
+    // row on each side (which may wrap around the torus)
+    above = (r0 - 1 + rows) % rows;
+    below = (r1 + 1) % rows;
+    near = before + rows_count(data, above, above)
+        + rows_count(data, below, below);
+    if (table_reset(t, 9 * (size_t)near) != 0) {
+        perror("malloc: sparse counts");
+        exit(1);
+    }
+
+    if (r1 - r0 + 3 >= rows) {
+        count_rows(data, t, 0, rows - 1, r0, r1);
+    } else {
+        count_rows(data, t, r0, r1, r0, r1);
+        count_rows(data, t, above, above, r0, r1);
+        count_rows(data, t, below, below, r0, r1);
+    }
+
+    // the rule on the count (only cells with a live neighbor or alive
+    // themselves are in the table: rules have no B0)
+    for (s = 0; s < t->cap; s++) {
+        if (t->keys[s] == SLOT_EMPTY) {
+            continue;
+        }
+        c = t->counts[s];
+        if (RULE_NEXT(data->rule, c >= ALIVE_BIT, c & (ALIVE_BIT - 1))) {
+            if (set_push(&t->out, t->keys[s]) != 0) {
+                perror("malloc: sparse cells");
+                exit(1);
+            }
+        }
+    }
+    qsort(t->out.cells, t->out.n, sizeof(uint64_t), cmp_key);
+    return (int)(t->out.n - before);
+}
+
+/*
+Returns the live cells this thread found for the next generation on
+its rows (in key order; valid from sparse_round to the end of the round)
+    data-> The struct containing information for the game
+*/
+struct sparse_set *sparse_result(struct gol_data *data) {
+
+    return &data->shared->sparse_threads[data->ntids].out;
+}
+
+/*
+Builds the next generation from the threads' results (run by the last
+thread at the end-of-round barrier, before the boards are flipped)
+    data-> The struct containing information for the game
+*/
+void sparse_merge(struct gol_data *data) {
+    struct sparse_set *next = data->sparse_next;
+    struct sparse_thread *t;
+    long n;
+    uint64_t *cells;
+    int i;
+
+    n = 0;
+    for (i = 0; i < data->threads; i++) {
+        n += data->shared->sparse_threads[i].out.n;
+    }
+    if (n > next->cap) {
+        cells = realloc(next->cells, sizeof(uint64_t) * n);
+        if (cells == NULL) {
+            perror("malloc: sparse cells");
+            exit(1);
+        }
+        next->cells = cells;
+        next->cap = n;
+    }
+
+    // thread i has rows before thread i + 1, so this stays in key order
+    next->n = 0;
+    for (i = 0; i < data->threads; i++) {
+        t = &data->shared->sparse_threads[i];
+        if (t->out.n > 0) {
+            memcpy(next->cells + next->n, t->out.cells,
+                    sizeof(uint64_t) * t->out.n);
+        }
+        next->n += t->out.n;
+    }
+}
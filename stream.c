@@ -0,0 +1,589 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Out-of-core streaming (-O file): the board lives in a file on disk, not
+in memory, so its size is limited by the disk. The file is a checkpoint
+of the packed board (see checkpoint.c: the header, then every row as
+words of 64 cells), so it is also an input that resumes the run, and a
+checkpoint written by -s can be streamed from directly.
+
+Each generation is one pass over the file: the rows are read in bands
+of about STREAM_BAND_BYTES, each with the wrapped rows above and below
+it, played with the packed kernel, and written to file.tmp at the same
+offset. Three kinds of threads work on a ring of band slots:
+    reader      (this thread) reads the next band into a free slot
+    compute     (data->threads of them) play a band that has been read
+    writer      writes a band that has been played, freeing its slot
+There are threads + 2 slots, so the reader fills the next bands while
+the current ones are played and the last ones written, and the memory
+used is the slots whatever the size of the board. At the end of a
+generation, once every band is written, the header gets its generation
+and live count and file.tmp is renamed over the file, which thus always
+holds a whole generation; the next generation reads it back.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "gol.h"
+
+/* bytes of board in one band (rounded to whole rows, at least one) */
+#define STREAM_BAND_BYTES (4 << 20)
+
+/* what a slot holds; it goes through them in order, back to free */
+enum slot_state {
+    SLOT_FREE, SLOT_LOADING, SLOT_READY, SLOT_COMPUTING, SLOT_COMPUTED,
+    SLOT_WRITING
+};
+
+/* One band of rows on its way through the pipeline */
+struct stream_slot {
+    uint64_t *in; // rows r0 - 1 .. r1 + 1 (wrapped) of the file's board
+    uint64_t *out; // their next generation, rows 1 .. r1 - r0 + 1
+    int r0, r1; // the band's rows
+    long live; // change in live cells over the band
+    int state; // enum slot_state
+};
+
+/* The run: the file, the slots and the threads working on them */
+struct stream {
+    struct gol_data *data; // the options (rows, cols, rule, threads)
+    const char *path; // the board's file
+    char *tmp; // path.tmp, where the next generation is written
+    int src, dst; // the file read and the one written this generation
+    int words; // 64-bit words per row
+    int band; // rows per band
+    int nbands; // bands per generation
+    struct stream_slot *slots;
+    int nslots;
+    pthread_mutex_t lock; // the slots' states and the counts below
+    pthread_cond_t cond; // a state changed
+    long live; // change in live cells over the bands written so far
+    int quit; // the threads stop once there is nothing left
+    int error; // errno of the first failed read or write, or 0
+    double bytes; // bytes read and written
+    pthread_t writer, *workers;
+};
+
+/*
+Reads or writes whole rows of a board file
+    fd -> the file
+    buf -> the rows
+    first -> the first row
+    count -> number of rows
+    words -> words per row
+    out -> 1 to write, 0 to read
+    returns: 0 on success, an errno on error
+*/
+static int file_rows(int fd, uint64_t *buf, long first, long count,
+        int words, int out) {
+    char *p = (char *)buf;
+    size_t len = (size_t)count * words * sizeof(uint64_t);
+    off_t off = CHECKPOINT_HEAD + (off_t)first * words * sizeof(uint64_t);
+    ssize_t n;
+
+    while (len > 0) {
+        n = out ? pwrite(fd, p, len, off) : pread(fd, p, len, off);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return (n == 0) ? EIO : errno;
+        }
+        p += n;
+        off += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*
+Finds a slot in a state (under s->lock)
+    s -> the run
+    state -> the state
+    returns: the slot's index, or -1 if none is
+*/
+static int find_slot(struct stream *s, int state) {
+    int k;
+
+    for (k = 0; k < s->nslots; k++) {
+        if (s->slots[k].state == state) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+/*
+Records the first error and wakes every thread (under s->lock)
+    s -> the run
+    err -> the errno
+*/
+static void stream_fail(struct stream *s, int err) {
+
+    if (s->error == 0) {
+        s->error = err;
+    }
+    pthread_cond_broadcast(&s->cond);
+}
+
+/*
+Plays a band: its in rows are a small packed board whose first and last
+rows are the neighbors, so packed_round plays rows 1 .. n with no wrap
+    s -> the run
+    slot -> the band (read)
+    returns: the change in the number of live cells over the band
+*/
+static long band_compute(struct stream *s, struct stream_slot *slot) {
+    struct gol_data view;
+
+    memset(&view, 0, sizeof(view));
+    view.rows = slot->r1 - slot->r0 + 3;
+    view.cols = s->data->cols;
+    view.words = s->words;
+    view.rule = s->data->rule;
+    view.packed_board = slot->in;
+    view.packed_next = slot->out;
+    return packed_round(&view, 1, view.rows - 2, 0, s->words - 1);
+}
+
+/*
+Thread function of a compute thread: plays bands as they are read
+    arg -> the struct stream
+*/
+static void *compute_run(void *arg) {
+    struct stream *s = (struct stream *)arg;
+    long live;
+    int k;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while ((k = find_slot(s, SLOT_READY)) < 0 && !s->quit) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        }
+        if (k < 0) {
+            break;
+        }
+        s->slots[k].state = SLOT_COMPUTING;
+        pthread_mutex_unlock(&s->lock);
+
+        live = band_compute(s, &s->slots[k]);
+
+        pthread_mutex_lock(&s->lock);
+        s->slots[k].live = live;
+        s->slots[k].state = SLOT_COMPUTED;
+        pthread_cond_broadcast(&s->cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/*
+Thread function of the writer: writes bands as they are played (in any
+order; each goes to its own rows of the file)
+    arg -> the struct stream
+*/
+static void *writer_run(void *arg) {
+    struct stream *s = (struct stream *)arg;
+    struct stream_slot *slot;
+    int k, err;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while ((k = find_slot(s, SLOT_COMPUTED)) < 0 && !s->quit) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        }
+        if (k < 0) {
+            break;
+        }
+        slot = &s->slots[k];
+        slot->state = SLOT_WRITING;
+        pthread_mutex_unlock(&s->lock);
+
+        err = file_rows(s->dst, slot->out + s->words, slot->r0,
+                slot->r1 - slot->r0 + 1, s->words, 1);
+
+        pthread_mutex_lock(&s->lock);
+        if (err != 0) {
+            stream_fail(s, err);
+        }
+        s->live += slot->live;
+        s->bytes += (double)(slot->r1 - slot->r0 + 1) * s->words
+            * sizeof(uint64_t);
+        slot->state = SLOT_FREE;
+        pthread_cond_broadcast(&s->cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/*
+Reads band b and the rows around it into a slot
+    s -> the run
+    slot -> the slot (loading)
+    b -> the band
+    returns: 0 on success, an errno on error
+*/
+static int band_read(struct stream *s, struct stream_slot *slot, int b) {
+    int rows = s->data->rows;
+    long n;
+    int err;
+
+    slot->r0 = b * s->band;
+    slot->r1 = slot->r0 + s->band - 1;
+    if (slot->r1 > rows - 1) {
+        slot->r1 = rows - 1;
+    }
+    n = slot->r1 - slot->r0 + 1;
+    // the row above and the band in one read when the top does not wrap
+    if (slot->r0 > 0) {
+        err = file_rows(s->src, slot->in, slot->r0 - 1, n + 1, s->words, 0);
+    } else {
+        err = file_rows(s->src, slot->in, rows - 1, 1, s->words, 0);
+        if (err == 0) {
+            err = file_rows(s->src, slot->in + s->words, 0, n, s->words, 0);
+        }
+    }
+    if (err == 0) {
+        err = file_rows(s->src, slot->in + (n + 1) * s->words,
+                (slot->r1 + 1) % rows, 1, s->words, 0);
+    }
+    return err;
+}
+
+/*
+Plays one generation: reads every band into the slots as they free up,
+and waits for the compute threads and the writer to finish them
+    s -> the run
+    returns: 0 on success, an errno on error
+*/
+static int stream_generation(struct stream *s) {
+    int b, k, err;
+
+    pthread_mutex_lock(&s->lock);
+    s->live = 0;
+    for (b = 0; b < s->nbands && s->error == 0; b++) {
+        while ((k = find_slot(s, SLOT_FREE)) < 0 && s->error == 0) {
+            pthread_cond_wait(&s->cond, &s->lock);
+        }
+        if (k < 0) {
+            break;
+        }
+        s->slots[k].state = SLOT_LOADING;
+        pthread_mutex_unlock(&s->lock);
+
+        err = band_read(s, &s->slots[k], b);
+
+        pthread_mutex_lock(&s->lock);
+        if (err != 0) {
+            s->slots[k].state = SLOT_FREE;
+            stream_fail(s, err);
+            break;
+        }
+        s->bytes += (double)(s->slots[k].r1 - s->slots[k].r0 + 3)
+            * s->words * sizeof(uint64_t);
+        s->slots[k].state = SLOT_READY;
+        pthread_cond_broadcast(&s->cond);
+    }
+    // (the bands already handed out finish even after an error)
+    while (find_slot(s, SLOT_READY) >= 0 || find_slot(s, SLOT_COMPUTING) >= 0
+            || find_slot(s, SLOT_COMPUTED) >= 0
+            || find_slot(s, SLOT_WRITING) >= 0) {
+        pthread_cond_wait(&s->cond, &s->lock);
+    }
+    err = s->error;
+    pthread_mutex_unlock(&s->lock);
+    return err;
+}
+
+/*
+Creates file.tmp at the full size of the board (its blocks are
+allocated as the bands are written, so unwritten rows read as dead)
+    s -> the run
+    returns: the file, or -1 on error (errno set)
+*/
+static int open_tmp(struct stream *s) {
+    int fd;
+
+    fd = open(s->tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0 && ftruncate(fd, CHECKPOINT_HEAD + (off_t)s->data->rows
+                * s->words * sizeof(uint64_t)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/*
+Writes the header of file.tmp and renames it over the file, which then
+holds the generation just written; the file read so far is closed and
+the new one is read next
+    s -> the run
+    generation -> its generation
+    target -> generation the run plays to
+    live -> its live cells
+    returns: 0 on success, an errno on error
+*/
+static int stream_commit(struct stream *s, long generation, long target,
+        long live) {
+    char head[CHECKPOINT_HEAD];
+
+    checkpoint_head(s->data, generation, target, live, head);
+    if (pwrite(s->dst, head, sizeof(head), 0) != sizeof(head)
+            || rename(s->tmp, s->path) != 0) {
+        return errno ? errno : EIO;
+    }
+    close(s->src);
+    s->src = s->dst;
+    s->dst = -1;
+    return 0;
+}
+
+/* orders the keys of the initial board by row (then column) */
+static int key_cmp(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*
+Writes a pattern that is not already a board file (any other input
+format, or a sparse checkpoint) to the file as generation 0 of the run:
+its cells are sorted by row, and only the rows with a live cell are
+written (the rest of the file is a hole, read back as dead cells)
+    s -> the run
+    pat -> the loaded pattern
+    returns: 0 on success, an errno on error
+*/
+static int stream_build(struct stream *s, struct pattern *pat) {
+    uint64_t *keys, *row, key;
+    long k, n, i, cur;
+    int err;
+
+    n = pat->ncells;
+    if (pat->snap_cells != NULL) {
+        n += pat->live;
+    }
+    keys = malloc(sizeof(uint64_t) * (n + 1));
+    row = calloc(s->words, sizeof(uint64_t));
+    if (keys == NULL || row == NULL) {
+        free(keys);
+        free(row);
+        return ENOMEM;
+    }
+    for (k = 0; k < pat->ncells; k++) {
+        keys[k] = (uint64_t)pat->cells[2 * k] * s->data->cols
+            + pat->cells[2 * k + 1];
+    }
+    if (pat->snap_cells != NULL) {
+        memcpy(keys + pat->ncells, pat->snap_cells,
+                sizeof(uint64_t) * pat->live);
+    }
+    qsort(keys, n, sizeof(uint64_t), key_cmp);
+
+    err = 0;
+    s->dst = open_tmp(s);
+    if (s->dst < 0) {
+        err = errno;
+    }
+    for (k = 0; k < n && err == 0; k = i) {
+        cur = keys[k] / s->data->cols;
+        memset(row, 0, sizeof(uint64_t) * s->words);
+        for (i = k; i < n && (long)(keys[i] / s->data->cols) == cur; i++) {
+            key = keys[i] % s->data->cols;
+            row[key / 64] |= (uint64_t)1 << (key % 64);
+        }
+        err = file_rows(s->dst, row, cur, 1, s->words, 1);
+    }
+    free(keys);
+    free(row);
+    if (err == 0) {
+        err = stream_commit(s, pat->generation,
+                pat->generation + pat->iters, pat->live);
+    }
+    return err;
+}
+
+/*
+Allocates the slots and starts the compute threads and the writer
+    s -> the run
+    returns: 0 on success, 1 on error
+*/
+static int stream_start(struct stream *s) {
+    size_t len;
+    int k;
+
+    s->nslots = s->data->threads + 2;
+    s->slots = calloc(s->nslots, sizeof(struct stream_slot));
+    s->workers = calloc(s->data->threads, sizeof(pthread_t));
+    if (s->slots == NULL || s->workers == NULL) {
+        return 1;
+    }
+    len = (size_t)(s->band + 2) * s->words * sizeof(uint64_t);
+    for (k = 0; k < s->nslots; k++) {
+        s->slots[k].in = aligned_alloc(CACHE_LINE,
+                (len + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+        s->slots[k].out = aligned_alloc(CACHE_LINE,
+                (len + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+        if (s->slots[k].in == NULL || s->slots[k].out == NULL) {
+            return 1;
+        }
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    for (k = 0; k < s->data->threads; k++) {
+        if (pthread_create(&s->workers[k], NULL, compute_run, s) != 0) {
+            return 1;
+        }
+    }
+    if (pthread_create(&s->writer, NULL, writer_run, s) != 0) {
+        return 1;
+    }
+    return 0;
+}
+
+/*
+Stops the threads and frees the slots
+    s -> the run (started)
+*/
+static void stream_stop(struct stream *s) {
+    int k;
+
+    pthread_mutex_lock(&s->lock);
+    s->quit = 1;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    for (k = 0; k < s->data->threads; k++) {
+        pthread_join(s->workers[k], NULL);
+    }
+    pthread_join(s->writer, NULL);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->cond);
+    for (k = 0; k < s->nslots; k++) {
+        free(s->slots[k].in);
+        free(s->slots[k].out);
+    }
+}
+
+/*
+Runs gol out of core: loads the input file, writes it to the board file
+unless it already is one, streams every generation through the file and
+prints the report
+    data-> The struct containing information for the game (options)
+    path -> the input file (a checkpoint of the packed board is read
+        from directly, and may be the -O file itself)
+    returns: the exit status
+*/
+int stream_main(struct gol_data *data, const char *path) {
+    struct stream s;
+    struct pattern pat;
+    struct timeval start, stop;
+    long generation, target, total;
+    double secs;
+    int g, err;
+
+    if (load_pattern(path, data, &pat) != 0) {
+        return 1;
+    }
+    life_rule(data, &pat);
+    data->iters = pat.iters;
+    data->rows = pat.rows;
+    data->cols = pat.cols;
+
+    memset(&s, 0, sizeof(s));
+    s.data = data;
+    s.path = data->stream_path;
+    s.src = s.dst = -1;
+    s.words = (data->cols + 63) / 64;
+    s.band = STREAM_BAND_BYTES / (s.words * sizeof(uint64_t));
+    s.band = (s.band < 1) ? 1 : (s.band > data->rows) ? data->rows : s.band;
+    s.nbands = (data->rows + s.band - 1) / s.band;
+    s.tmp = malloc(strlen(s.path) + 5);
+    if (s.tmp == NULL) {
+        perror("malloc: -O");
+        free_pattern(&pat);
+        return 1;
+    }
+    sprintf(s.tmp, "%s.tmp", s.path);
+    generation = pat.generation;
+    target = pat.generation + pat.iters;
+    total = pat.live;
+
+    // a board file already: its rows are read where they are
+    if (pat.snap_cells != NULL && !pat.snap_keys) {
+        s.src = open(path, O_RDONLY);
+        err = (s.src < 0) ? errno : 0;
+    } else {
+        err = stream_build(&s, &pat);
+    }
+    free_pattern(&pat);
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", s.tmp, strerror(err));
+        free(s.tmp);
+        return 1;
+    }
+    posix_fadvise(s.src, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (data->print_config == 1) {
+        printf("Streaming %d x %d through %s: %d bands of %d rows, "
+                "%d compute threads\n", data->rows, data->cols, s.path,
+                s.nbands, s.band, data->threads);
+    }
+    if (stream_start(&s) != 0) {
+        perror("-O: starting the pipeline");
+        return 1;
+    }
+
+    gettimeofday(&start, NULL);
+    for (g = 0; g < data->iters && err == 0; g++) {
+        s.dst = open_tmp(&s);
+        if (s.dst < 0) {
+            err = errno;
+            break;
+        }
+        posix_fadvise(s.src, 0, 0, POSIX_FADV_SEQUENTIAL);
+        err = stream_generation(&s);
+        if (err == 0) {
+            total += s.live;
+            generation++;
+            err = stream_commit(&s, generation, target, total);
+        }
+    }
+    gettimeofday(&stop, NULL);
+    stream_stop(&s);
+    if (s.dst >= 0) {
+        close(s.dst);
+        unlink(s.tmp);
+    }
+    if (s.src >= 0) {
+        close(s.src);
+    }
+    if (err != 0) {
+        fprintf(stderr, "%s: %s\n", s.path, strerror(err));
+        free(s.slots);
+        free(s.workers);
+        free(s.tmp);
+        return 1;
+    }
+
+    secs = (stop.tv_sec + stop.tv_usec * .000001)
+        - (start.tv_sec + start.tv_usec * .000001);
+    printf("Streamed: %d bands of %d rows per generation, %.1f MB/s "
+            "read and written\n", s.nbands, s.band,
+            (secs > 0) ? s.bytes / secs / 1e6 : 0.0);
+    fprintf(stdout, "Kernel: packed\n");
+    fprintf(stdout, "Total time: %0.3f seconds\n", secs);
+    fprintf(stdout, "Number of live cells after %d rounds: %d\n\n",
+            data->iters, (int)total);
+    free(s.slots);
+    free(s.workers);
+    free(s.tmp);
+    return 0;
+}
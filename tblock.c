@@ -0,0 +1,251 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Temporal blocking (-t k|auto). Instead of one sweep of the whole board
+and one barrier per generation, every thread cuts its share of the board
+(its rows, columns or tiles) into tiles of tb_tile x tb_tile cells. Each
+tile is copied, with a halo k cells deep (wrapping around the torus),
+into a private buffer that fits in L2. The buffer is stepped k times
+with the row kernel, the valid region shrinking by one cell per step.
+What is left after k steps is exactly the tile, k generations later,
+and it is written to the next board. Tiles never wait for each other,
+so the threads meet once per k generations. The halo costs some
+recomputed cells; in exchange the board goes through memory once per k
+generations instead of every generation.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "gol.h"
+
+/* auto: k is this fraction of the buffer side (1/32 ~ 12% extra work) */
+#define TB_AUTO_DIV (32)
+
+/* smallest tile side */
+#define TB_MIN_TILE (16)
+
+/* the most generations per block (-t) */
+#define TB_MAX_K (256)
+
+/*
+Picks k (for auto) and the tile size: a tile plus its halo, twice (two
+buffers of ints), takes half of L2
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 if k is out of range
+*/
+int tblock_setup(struct gol_data *data) {
+    size_t area;
+    int side;
+
+    area = (size_t)(l2_cache_bytes() / 2) / (2 * sizeof(int));
+    side = 1;
+    while ((size_t)(side + 1) * (side + 1) <= area) {
+        side++;
+    }
+
+    if (data->tb_k < 0) {
+        data->tb_k = side / TB_AUTO_DIV;
+        if (data->tb_k < 1) {
+            data->tb_k = 1;
+        }
+    }
+    if (data->tb_k < 1 || data->tb_k > TB_MAX_K) {
+        return 1;
+    }
+
+    data->tb_tile = side - 2 * data->tb_k;
+    if (data->tb_tile < TB_MIN_TILE) {
+        data->tb_tile = TB_MIN_TILE;
+    }
+    // packed boards are written a word at a time
+    if (data->kernel == KERNEL_PACKED && data->tb_tile >= 64) {
+        data->tb_tile -= data->tb_tile % 64;
+    }
+    return 0;
+}
+
+/*
+Copies cells [c, c + n) of board row i into out, wrapping around the
+torus as many times as needed
+    data-> The struct containing information for the game
+    i -> the board row (in range)
+    c -> the first column (may be negative)
+    n -> number of cells
+    out -> where the 0/1 cells go
+*/
+static void load_row(struct gol_data *data, int i, int c, int n, int *out) {
+    const uint64_t *prow;
+    const int *row;
+    int x, j, len;
+
+    j = ((c % data->cols) + data->cols) % data->cols;
+    if (data->kernel == KERNEL_PACKED) {
+        prow = data->packed_board + (size_t)i * data->words;
+        for (x = 0; x < n; x++) {
+            out[x] = (prow[j >> 6] >> (j & 63)) & 1;
+            if (++j == data->cols) {
+                j = 0;
+            }
+        }
+        return;
+    }
+
+    row = board_row(data, data->gol_board, i);
+    for (x = 0; x < n; x += len) {
+        len = data->cols - j;
+        if (len > n - x) {
+            len = n - x;
+        }
+        memcpy(out + x, row + j, sizeof(int) * len);
+        j = 0;
+    }
+}
+
+/*
+Writes n cells from in to row i, columns c..c + n - 1, of the next board
+    data-> The struct containing information for the game
+    i -> the board row
+    c -> the first column (c + n <= cols)
+    n -> number of cells
+    in -> the 0/1 cells
+*/
+static void store_row(struct gol_data *data, int i, int c, int n,
+        const int *in) {
+    uint64_t *prow, bit;
+    int x, j;
+
+    if (data->kernel == KERNEL_PACKED) {
+        prow = data->packed_next + (size_t)i * data->words;
+        for (x = 0; x < n; x++) {
+            j = c + x;
+            bit = (uint64_t)1 << (j & 63);
+            if (in[x]) {
+                prow[j >> 6] |= bit;
+            } else {
+                prow[j >> 6] &= ~bit;
+            }
+        }
+        return;
+    }
+    memcpy(board_row(data, data->next_board, i) + c, in, sizeof(int) * n);
+}
+
+/* number of live cells in n cells */
+static int count_live(const int *cells, int n) {
+    int x, live;
+
+    live = 0;
+    for (x = 0; x < n; x++) {
+        live += cells[x];
+    }
+    return live;
+}
+
+/*
+Advances the tile rows r0..r1, cols c0..c1 by data->tb_steps
+generations into the next board
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row of the tile
+    c0, c1 -> the first and last column of the tile
+    returns: the change in the number of live cells in the tile
+*/
+static int tblock_tile(struct gol_data *data, int r0, int r1, int c0,
+        int c1) {
+    int *a, *b, *tmp;
+    int k, h, w, y, s, gi, before, after;
+
+    k = data->tb_steps;
+    h = r1 - r0 + 1 + 2 * k;
+    w = c1 - c0 + 1 + 2 * k;
+    a = data->tb_buf[0];
+    b = data->tb_buf[1];
+
+    // the tile and its halo at the current generation
+    before = 0;
+    for (y = 0; y < h; y++) {
+        gi = (((r0 - k + y) % data->rows) + data->rows) % data->rows;
+        load_row(data, gi, c0 - k, w, a + (size_t)y * w);
+        if (y >= k && y < h - k) {
+            before += count_live(a + (size_t)y * w + k, c1 - c0 + 1);
+        }
+    }
+
+    // step s computes rows and columns s .. side - 1 - s
+    for (s = 1; s <= k; s++) {
+        for (y = s; y < h - s; y++) {
+            data->row_fn(a + (size_t)(y - 1) * w + s, a + (size_t)y * w + s,
+                    a + (size_t)(y + 1) * w + s, b + (size_t)y * w + s,
+                    w - 2 * s, data->rule);
+        }
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    after = 0;
+    for (y = k; y < h - k; y++) {
+        store_row(data, r0 + y - k, c0, c1 - c0 + 1, a + (size_t)y * w + k);
+        after += count_live(a + (size_t)y * w + k, c1 - c0 + 1);
+    }
+    if (data->kernel == KERNEL_PADDED) {
+        padded_fill_halo(data, data->next_board, r0, r1, c0, c1);
+    }
+    return after - before;
+}
+
+/*
+Advances rows r0..r1, cols c0..c1 by data->tb_steps generations, one
+cache-sized tile at a time (used by play_round in place of play_region)
+    data-> The struct containing information for the game
+    r0, r1 -> the first and last row
+    c0, c1 -> the first and last column
+    returns: the change in the number of live cells in the rectangle
+*/
+int tblock_region(struct gol_data *data, int r0, int r1, int c0, int c1) {
+    size_t need;
+    int tr, tc, tr1, tc1, live, side;
+
+    if (r0 > r1 || c0 > c1) {
+        return 0;
+    }
+    side = data->tb_tile + 2 * data->tb_steps;
+    need = (size_t)side * side;
+    if (need > data->tb_cap) {
+        free(data->tb_buf[0]);
+        free(data->tb_buf[1]);
+        data->tb_buf[0] = malloc(sizeof(int) * need);
+        data->tb_buf[1] = malloc(sizeof(int) * need);
+        if (data->tb_buf[0] == NULL || data->tb_buf[1] == NULL) {
+            perror("malloc: temporal blocking buffers");
+            exit(1);
+        }
+        data->tb_cap = need;
+    }
+
+    live = 0;
+    for (tr = r0; tr <= r1; tr += data->tb_tile) {
+        tr1 = (tr + data->tb_tile - 1 < r1) ? tr + data->tb_tile - 1 : r1;
+        for (tc = c0; tc <= c1; tc += data->tb_tile) {
+            tc1 = (tc + data->tb_tile - 1 < c1) ? tc + data->tb_tile - 1 : c1;
+            live += tblock_tile(data, tr, tr1, tc, tc1);
+        }
+    }
+    return live;
+}
+
+/*
+Frees a thread's tile buffers
+    data-> The struct containing information for the game
+*/
+void tblock_free(struct gol_data *data) {
+
+    free(data->tb_buf[0]);
+    free(data->tb_buf[1]);
+    data->tb_buf[0] = NULL;
+    data->tb_buf[1] = NULL;
+    data->tb_cap = 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+2D tiled partitioning (part_mode 2). The board is cut into rectangular
+tiles small enough that a tile of the current board plus its next state
+fit in half of the L2 cache. Tiles are put in Morton (Z-curve) order and
+each thread gets a contiguous run of that order, so a thread's tiles form
+a compact 2D block instead of a long strip.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "gol.h"
+
+/* L2 size assumed when the system does not report one */
+#define DEFAULT_L2_BYTES (1024 * 1024)
+
+/* smallest tile side in cells (packed tiles are at least one word wide) */
+#define MIN_TILE (16)
+
+/*
+Interleaves the bits of a tile's row and column to give its position on
+the Z-curve
+    ty -> tile row
+    tx -> tile column
+    returns: the Morton key
+*/
+static uint64_t morton_key(int ty, int tx) {
+    uint64_t key;
+    int b;
+
+    key = 0;
+    for (b = 0; b < 31; b++) {
+        key |= (uint64_t)((tx >> b) & 1) << (2 * b);
+        key |= (uint64_t)((ty >> b) & 1) << (2 * b + 1);
+    }
+    return key;
+}
+
+/* qsort comparison: orders tile indices by Morton key (keys[] follows) */
+static int cmp_key(const void *a, const void *b) {
+    const uint64_t *ka, *kb;
+
+    ka = (const uint64_t *)a;
+    kb = (const uint64_t *)b;
+    return (ka[0] > kb[0]) - (ka[0] < kb[0]);
+}
+
+/*
+Returns the size of the L2 cache (or DEFAULT_L2_BYTES if the system does
+not say)
+    returns: the size in bytes
+*/
+long l2_cache_bytes(void) {
+    long l2;
+
+    l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 <= 0) {
+        l2 = DEFAULT_L2_BYTES;
+    }
+    return l2;
+}
+
+/*
+Picks the tile size for this board and kernel and builds the Morton
+ordered tile list that partition() splits between threads
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+int tile_setup(struct gol_data *data) {
+    long l2;
+    double cell_bytes;
+    size_t area;
+    int min_w, t, ty, tx, n;
+    uint64_t *keys;
+
+    l2 = l2_cache_bytes();
+    data->l2_bytes = l2;
+
+    // the current and next board of a tile share half of L2
+    cell_bytes = (data->kernel == KERNEL_PACKED) ? 1.0 / 8 : sizeof(int);
+    area = (size_t)((l2 / 2) / (2 * cell_bytes));
+    min_w = (data->kernel == KERNEL_PACKED) ? 64 : MIN_TILE;
+
+    data->tile_w = min_w;
+    while ((size_t)data->tile_w * data->tile_w * 2 <= area) {
+        data->tile_w *= 2;
+    }
+    data->tile_h = area / data->tile_w;
+
+    // never bigger than the board
+    if (data->tile_w > data->cols) {
+        data->tile_w = data->cols;
+    }
+    if (data->tile_h > data->rows) {
+        data->tile_h = data->rows;
+    }
+
+    // small boards: cut further so every thread gets several tiles
+    for (;;) {
+        data->tiles_y = (data->rows + data->tile_h - 1) / data->tile_h;
+        data->tiles_x = (data->cols + data->tile_w - 1) / data->tile_w;
+        if (data->tiles_y * data->tiles_x >= 4 * data->threads) {
+            break;
+        }
+        if (data->tile_h >= data->tile_w && data->tile_h / 2 >= MIN_TILE) {
+            data->tile_h /= 2;
+        } else if (data->tile_w / 2 >= min_w
+                && (data->kernel != KERNEL_PACKED
+                    || (data->tile_w / 2) % 64 == 0)) {
+            data->tile_w /= 2;
+        } else if (data->tile_h / 2 >= MIN_TILE) {
+            data->tile_h /= 2;
+        } else {
+            break;
+        }
+    }
+
+    n = data->tiles_y * data->tiles_x;
+    data->ntiles = n;
+    data->tile_order = malloc(sizeof(int) * n);
+    keys = malloc(sizeof(uint64_t) * 2 * n);
+    if (data->tile_order == NULL || keys == NULL) {
+        free(keys);
+        return 1;
+    }
+
+    // (key, index) pairs sorted by key give the Z-curve order
+    for (ty = 0; ty < data->tiles_y; ty++) {
+        for (tx = 0; tx < data->tiles_x; tx++) {
+            t = ty * data->tiles_x + tx;
+            keys[2 * t] = morton_key(ty, tx);
+            keys[2 * t + 1] = t;
+        }
+    }
+    qsort(keys, n, 2 * sizeof(uint64_t), cmp_key);
+    for (t = 0; t < n; t++) {
+        data->tile_order[t] = (int)keys[2 * t + 1];
+    }
+    free(keys);
+    return 0;
+}
+
+/*
+Gets the cell bounds of the k-th tile in Morton order
+    data-> The struct containing information for the game
+    k -> position of the tile in data->tile_order
+    r0, r1 -> set to the first and last row of the tile
+    c0, c1 -> set to the first and last column of the tile
+*/
+void tile_bounds(struct gol_data *data, int k,
+        int *r0, int *r1, int *c0, int *c1) {
+    int t, ty, tx;
+
+    t = data->tile_order[k];
+    ty = t / data->tiles_x;
+    tx = t % data->tiles_x;
+
+    *r0 = ty * data->tile_h;
+    *r1 = *r0 + data->tile_h - 1;
+    if (*r1 > data->rows - 1) {
+        *r1 = data->rows - 1;
+    }
+    *c0 = tx * data->tile_w;
+    *c1 = *c0 + data->tile_w - 1;
+    if (*c1 > data->cols - 1) {
+        *c1 = data->cols - 1;
+    }
+}
+
+/*
+Prints a thread's share of the tile grid (for print_config); thread 0
+also prints the grid itself
+    data-> The struct containing information for the game
+*/
+void tile_print_config(struct gol_data *data) {
+    int k, r0, r1, c0, c1, top, bottom, left, right;
+
+    if (data->ntids == 0) {
+        printf("tiles: %d x %d grid of %d x %d cells (L2 %ld KB)\n",
+                data->tiles_y, data->tiles_x, data->tile_h, data->tile_w,
+                data->l2_bytes / 1024);
+    }
+
+    printf("ntid %d:  tiles: %d:%d (%d)", data->ntids, data->start,
+            data->end, data->end - data->start + 1);
+    if (data->start > data->end) {
+        printf("\n");
+        return;
+    }
+
+    // the box that holds all of this thread's tiles
+    top = data->rows;
+    left = data->cols;
+    bottom = -1;
+    right = -1;
+    for (k = data->start; k <= data->end; k++) {
+        tile_bounds(data, k, &r0, &r1, &c0, &c1);
+        top = (r0 < top) ? r0 : top;
+        bottom = (r1 > bottom) ? r1 : bottom;
+        left = (c0 < left) ? c0 : left;
+        right = (c1 > right) ? c1 : right;
+    }
+    printf("  within rows: %d:%d cols: %d:%d\n", top, bottom, left, right);
+}
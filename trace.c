@@ -0,0 +1,237 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Span recorder behind -T (see trace.h). Every thread appends spans to its
+own preallocated buffer in the shared state, so recording is two
+clock_gettime calls and a store, with no locks and no allocation. The
+buffers have room for the first TRACE_MAX_ROUNDS generations only, so a
+long run does not allocate spans for all of them up front. At the
+end of the run the spans are written as Chrome trace JSON (load it in
+chrome://tracing or ui.perfetto.dev) and a per-thread summary is
+printed: time spent per kind of span, and how far the slowest thread's
+compute was above the average, generation by generation.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "gol.h"
+
+/* span names in the trace file and the summary */
+static const char *kind_names[TRACE_KINDS] = {
+    "compute", "barrier", "serial", "lock", "render"
+};
+
+/*
+Returns the time for a span
+    returns: CLOCK_MONOTONIC in nanoseconds
+*/
+uint64_t trace_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+Allocates every thread's span buffer (room for all the generations up to
+TRACE_MAX_ROUNDS, so nothing is allocated while the game runs)
+    data-> The struct containing information for the game
+    path -> where trace_finish writes the trace
+    returns: 0 on success, 1 on error
+*/
+int trace_setup(struct gol_data *data, const char *path) {
+    struct gol_shared *shared = data->shared;
+    struct trace_thread *t;
+    int i;
+
+    shared->trace = aligned_alloc(CACHE_LINE,
+            sizeof(struct trace_thread) * data->threads);
+    if (shared->trace == NULL) {
+        return 1;
+    }
+    memset(shared->trace, 0, sizeof(struct trace_thread) * data->threads);
+    shared->trace_rounds = (data->iters < TRACE_MAX_ROUNDS)
+        ? data->iters : TRACE_MAX_ROUNDS;
+    for (i = 0; i < data->threads; i++) {
+        t = &shared->trace[i];
+        t->cap = (long)TRACE_PER_ROUND * (shared->trace_rounds + 1) + 4;
+        t->spans = malloc(sizeof(struct trace_span) * t->cap);
+        if (t->spans == NULL) {
+            return 1;
+        }
+    }
+    shared->trace_path = path;
+    shared->trace_t0 = trace_now();
+    return 0;
+}
+
+/*
+Records a span of this thread that started at start and ends now
+    data-> The struct containing information for the game
+    kind -> one of the TRACE_* values
+    start -> trace_now() at the start of the span
+    gen -> the generation being played
+*/
+void trace_add(struct gol_data *data, int kind, uint64_t start, int gen) {
+    struct trace_thread *t = &data->shared->trace[data->ntids];
+    struct trace_span *s;
+
+    if (t->n == t->cap || gen > data->shared->trace_rounds) {
+        t->dropped++;
+        return;
+    }
+    s = &t->spans[t->n++];
+    s->start = start;
+    s->end = trace_now();
+    s->kind = kind;
+    s->gen = gen;
+}
+
+/*
+Writes the spans as Chrome trace JSON ("X" events, microseconds)
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 on error
+*/
+static int write_json(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct trace_span *s;
+    FILE *f;
+    long k;
+    int i, first;
+
+    f = fopen(shared->trace_path, "w");
+    if (f == NULL) {
+        return 1;
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"otherData\":{"
+            "\"generations\":%d,\"generations_traced\":%d},"
+            "\"traceEvents\":[\n", data->iters, shared->trace_rounds);
+    first = 1;
+    for (i = 0; i < data->threads; i++) {
+        if (shared->trace[i].n == 0) {
+            continue;
+        }
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                "\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", i, i);
+        first = 0;
+        for (k = 0; k < shared->trace[i].n; k++) {
+            s = &shared->trace[i].spans[k];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                    "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"gen\":%d}}", kind_names[s->kind], i,
+                    (s->start - shared->trace_t0) / 1000.0,
+                    (s->end - s->start) / 1000.0, s->gen);
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) != 0;
+}
+
+/*
+Prints, per thread, the milliseconds spent in each kind of span and the
+share of the run spent waiting at the barrier, then the compute
+imbalance: the sum over generations of the slowest thread's compute
+time against the sum of the average thread's
+    data-> The struct containing information for the game
+*/
+static void print_summary(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    struct trace_thread *t;
+    struct trace_span *s;
+    double ms[TRACE_KINDS], *gen_max, *gen_sum, dur, total, max_sum, avg_sum;
+    long k;
+    int i, kind, ran;
+
+    gen_max = calloc(shared->trace_rounds + 1, sizeof(double));
+    gen_sum = calloc(shared->trace_rounds + 1, sizeof(double));
+    if (gen_max == NULL || gen_sum == NULL) {
+        free(gen_max);
+        free(gen_sum);
+        return;
+    }
+
+    printf("Trace: %s\n", shared->trace_path);
+    if (shared->trace_rounds < data->iters) {
+        printf("(spans of the first %d of %d generations only)\n",
+                shared->trace_rounds, data->iters);
+    }
+    printf("thread");
+    for (kind = 0; kind < TRACE_KINDS; kind++) {
+        printf(" %10s", kind_names[kind]);
+    }
+    printf("  (ms)  barrier%%\n");
+
+    ran = 0;
+    for (i = 0; i < data->threads; i++) {
+        t = &shared->trace[i];
+        if (t->n == 0) {
+            continue;
+        }
+        ran++;
+        memset(ms, 0, sizeof(ms));
+        for (k = 0; k < t->n; k++) {
+            s = &t->spans[k];
+            dur = (s->end - s->start) / 1e6;
+            ms[s->kind] += dur;
+            if (s->kind == TRACE_COMPUTE && s->gen >= 0
+                    && s->gen <= shared->trace_rounds) {
+                gen_sum[s->gen] += dur;
+                gen_max[s->gen] = (dur > gen_max[s->gen])
+                    ? dur : gen_max[s->gen];
+            }
+        }
+        // the serial spans are nested in the barrier span
+        total = ms[TRACE_COMPUTE] + ms[TRACE_BARRIER] + ms[TRACE_LOCK]
+            + ms[TRACE_RENDER];
+        printf("%6d", i);
+        for (kind = 0; kind < TRACE_KINDS; kind++) {
+            printf(" %10.3f", ms[kind]);
+        }
+        printf("        %7.1f%s\n",
+                total > 0 ? 100 * ms[TRACE_BARRIER] / total : 0.0,
+                (t->dropped > 0 && shared->trace_rounds == data->iters)
+                ? " (trace full, spans dropped)" : "");
+    }
+
+    max_sum = 0;
+    avg_sum = 0;
+    for (i = 0; i <= shared->trace_rounds; i++) {
+        max_sum += gen_max[i];
+        avg_sum += (ran > 0) ? gen_sum[i] / ran : 0;
+    }
+    if (avg_sum > 0) {
+        printf("Imbalance: the slowest thread computed %.1f%% longer "
+                "than the average per generation\n",
+                100 * (max_sum / avg_sum - 1));
+    }
+    free(gen_max);
+    free(gen_sum);
+}
+
+/*
+Writes the trace file, prints the summary and frees the span buffers
+    data-> The struct containing information for the game
+    returns: 0 on success, 1 if the trace file could not be written
+*/
+int trace_finish(struct gol_data *data) {
+    struct gol_shared *shared = data->shared;
+    int ret, i;
+
+    if (shared->trace == NULL) {
+        return 0;
+    }
+    ret = write_json(data);
+    print_summary(data);
+    for (i = 0; i < data->threads; i++) {
+        free(shared->trace[i].spans);
+    }
+    free(shared->trace);
+    shared->trace = NULL;
+    return ret;
+}
@@ -0,0 +1,76 @@
+/*
+ * Swarthmore College, CS 31
+ * Copyright (c) 2023 Swarthmore College Computer Science Department,
+ * Swarthmore PA
+ */
+
+/*
+Per-thread span recorder for the hot path (-T, see trace.c). The TRACE_*
+macros are all the game loop uses; they only do something when gol is
+built with GOL_TRACE (make TRACE=1) and -T was given. Without GOL_TRACE
+they compile to nothing.
+*/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+#include "barrier.h"
+
+/* what a thread was doing during a span */
+#define TRACE_COMPUTE (0)   // play_round on its share of the board
+#define TRACE_BARRIER (1)   // at the end-of-round barrier (with end_round)
+#define TRACE_SERIAL  (2)   // end_round, in the last thread to arrive
+#define TRACE_LOCK    (3)   // waiting for the mutex
+#define TRACE_RENDER  (4)   // filling its share of a render frame
+#define TRACE_KINDS   (5)
+
+/* the most spans a thread records per generation (compute, barrier,
+ * serial and render) */
+#define TRACE_PER_ROUND (4)
+
+/* the most generations whose spans are recorded (the first ones; later
+ * ones are counted as dropped, and the trace and summary say so) */
+#define TRACE_MAX_ROUNDS (1 << 16)
+
+/* one span: a thread did kind from start to end (ns, CLOCK_MONOTONIC) */
+struct trace_span {
+    uint64_t start, end;
+    int kind; // one of the TRACE_* values
+    int gen; // the generation being played
+};
+
+/* one thread's spans, preallocated so recording never allocates */
+struct trace_thread {
+    struct trace_span *spans;
+    long n; // spans recorded
+    long cap; // room in spans
+    long dropped; // spans that did not fit
+} __attribute__((aligned(CACHE_LINE)));
+
+struct gol_data;
+
+uint64_t trace_now(void);
+int trace_setup(struct gol_data *data, const char *path);
+void trace_add(struct gol_data *data, int kind, uint64_t start, int gen);
+int trace_finish(struct gol_data *data);
+
+#ifdef GOL_TRACE
+/* declares t, a span's start time */
+#define TRACE_DECL(t) uint64_t t
+/* starts a span: t = now (when tracing) */
+#define TRACE_START(data, t) \
+    ((t) = ((data)->shared->trace != NULL) ? trace_now() : 0)
+/* ends the span that started at t */
+#define TRACE_END(data, kind, t, gen) \
+    do { \
+        if ((data)->shared->trace != NULL) { \
+            trace_add((data), (kind), (t), (gen)); \
+        } \
+    } while (0)
+#else
+#define TRACE_DECL(t) int t __attribute__((unused))
+#define TRACE_START(data, t) ((void)0)
+#define TRACE_END(data, kind, t, gen) ((void)0)
+#endif
+
+#endif  /* __TRACE_H__ */